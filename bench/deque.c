@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <time.h>
+#include "../src/api.h"
+
+
+/* Define the number of elements queued by each benchmark, and the length of
+ * the batches in which they are queued and dequeued. */
+static const int64_t BENCH_LEN = 1 << 22;
+static const int64_t BENCH_BATCH = 256;
+
+
+/* Define the bench_now() helper function. This function returns the current
+ * monotonic time in seconds. */
+static double
+bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+
+/* Define the bench_report() helper function. This function prints the time
+ * taken per element by a benchmark @name that started at @start. */
+static void
+bench_report(const char *name, double start, int64_t sum)
+{
+    double ns = (bench_now() - start) * 1e9 / (double) BENCH_LEN;
+    printf("%-40s %8.2f ns/elem (checksum %lld)\n", name, ns, (long long) sum);
+}
+
+
+/* Define the bench_vector_lifo() helper function. This is the current pattern
+ * of pushing onto and popping off the tail of a pcr_vector; the popped element
+ * has to be read back with pcr_vector_elem() before it is popped. */
+static void
+bench_vector_lifo(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        double start = bench_now();
+        pcr_vector *vec = pcr_vector_new(sizeof (int64_t), x);
+        int64_t sum = 0;
+
+        for (int64_t i = 0; i < BENCH_LEN; i += BENCH_BATCH) {
+            for (int64_t j = i; j < i + BENCH_BATCH; j++)
+                pcr_vector_push(&vec, &j, x);
+
+            for (register int64_t j = 0; j < BENCH_BATCH; j++) {
+                size_t len = pcr_vector_len(vec, x);
+                sum += *((int64_t *) pcr_vector_elem(vec, len, x));
+                pcr_vector_pop(&vec, x);
+            }
+        }
+
+        bench_report("pcr_vector push/elem/pop (LIFO)", start, sum);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the bench_deque_lifo() helper function. This is the same pattern as
+ * bench_vector_lifo(), but with pcr_deque. */
+static void
+bench_deque_lifo(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        double start = bench_now();
+        pcr_deque *dq = pcr_deque_new(sizeof (int64_t), x);
+        int64_t sum = 0, elem;
+
+        for (int64_t i = 0; i < BENCH_LEN; i += BENCH_BATCH) {
+            for (int64_t j = i; j < i + BENCH_BATCH; j++)
+                pcr_deque_push_back(&dq, &j, x);
+
+            for (register int64_t j = 0; j < BENCH_BATCH; j++) {
+                pcr_deque_pop_back(&dq, &elem, x);
+                sum += elem;
+            }
+        }
+
+        bench_report("pcr_deque push_back/pop_back (LIFO)", start, sum);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the bench_deque_fifo() helper function. This function queues batches
+ * of rows and dequeues them from the front, as a pipeline stage would. */
+static void
+bench_deque_fifo(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        double start = bench_now();
+        pcr_deque *dq = pcr_deque_new(sizeof (int64_t), x);
+        int64_t sum = 0, elem;
+
+        for (int64_t i = 0; i < BENCH_LEN; i += BENCH_BATCH) {
+            for (int64_t j = i; j < i + BENCH_BATCH; j++)
+                pcr_deque_push_back(&dq, &j, x);
+
+            for (register int64_t j = 0; j < BENCH_BATCH; j++) {
+                pcr_deque_pop_front(&dq, &elem, x);
+                sum += elem;
+            }
+        }
+
+        bench_report("pcr_deque push_back/pop_front (FIFO)", start, sum);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the bench_deque_drain() helper function. This function queues batches
+ * of rows and drains each batch into a vector in bulk. */
+static void
+bench_deque_drain(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        double start = bench_now();
+        pcr_deque *dq = pcr_deque_new(sizeof (int64_t), x);
+        int64_t sum = 0;
+
+        for (int64_t i = 0; i < BENCH_LEN; i += BENCH_BATCH) {
+            for (int64_t j = i; j < i + BENCH_BATCH; j++)
+                pcr_deque_push_back(&dq, &j, x);
+
+            pcr_vector *vec = pcr_vector_new_2(sizeof (int64_t), BENCH_BATCH,
+                                               x);
+            (void) pcr_deque_drain_all(&dq, &vec, x);
+            sum += *((int64_t *) pcr_vector_elem(vec, BENCH_BATCH, x));
+        }
+
+        bench_report("pcr_deque push_back/drain (FIFO)", start, sum);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+int main(void)
+{
+    pcr_exception_try (x) {
+        bench_vector_lifo(x);
+        bench_deque_lifo(x);
+        bench_deque_fifo(x);
+        bench_deque_drain(x);
+    }
+
+    pcr_exception_catchall {
+        pcr_exception_print();
+    }
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <threads.h>
+#include <time.h>
+#include "../src/api.h"
+
+
+/* Define the total number of elements appended by each benchmark; these are
+ * split evenly across the producers. */
+static const size_t BENCH_LEN = 1 << 22;
+
+
+/* Define the bench_locked struct. This holds the state of the baseline, which
+ * is the current pattern of guarding a pcr_vector with a mutex. */
+struct bench_locked {
+    pcr_vector *vec;
+    mtx_t lock;
+};
+
+
+/* Define the bench_now() helper function. This function returns the current
+ * monotonic time in seconds. */
+static double
+bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+
+/* Define the bench_locked_task() helper function. This function is run by each
+ * producer to append its share of elements to the mutex guarded pcr_vector. */
+static void
+bench_locked_task(size_t id, size_t len, void *opt, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        struct bench_locked *bl = opt;
+
+        for (size_t i = id; i < BENCH_LEN; i += len) {
+            mtx_lock(&bl->lock);
+            pcr_vector_push(&bl->vec, &i, x);
+            mtx_unlock(&bl->lock);
+        }
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the bench_segvector_task() helper function. This function is run by
+ * each producer to append its share of elements to the pcr_segvector. */
+static void
+bench_segvector_task(size_t id, size_t len, void *opt, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        for (size_t i = id; i < BENCH_LEN; i += len)
+            (void) pcr_segvector_push(opt, &i, x);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the bench_run() helper function. This function times the appending
+ * of BENCH_LEN elements by @wrk producers through both the mutex guarded
+ * pcr_vector and pcr_segvector. */
+static void
+bench_run(size_t wrk, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        struct bench_locked bl = {.vec = pcr_vector_new(sizeof (size_t), x)};
+        mtx_init(&bl.lock, mtx_plain);
+
+        double start = bench_now();
+        pcr_worker_run(wrk, &bench_locked_task, &bl, x);
+        double locked = bench_now() - start;
+        mtx_destroy(&bl.lock);
+
+        pcr_segvector *sv = pcr_segvector_new(sizeof (size_t), x);
+        start = bench_now();
+        pcr_worker_run(wrk, &bench_segvector_task, sv, x);
+        double lockfree = bench_now() - start;
+
+        printf("%2zu producers: mutex + pcr_vector %8.2f ns/elem,"
+               " pcr_segvector %8.2f ns/elem (%zu elems)\n", wrk,
+               locked * 1e9 / (double) BENCH_LEN,
+               lockfree * 1e9 / (double) BENCH_LEN,
+               pcr_segvector_len(sv, x));
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+int main(void)
+{
+    pcr_exception_try (x) {
+        for (size_t wrk = 1; wrk <= 8; wrk *= 2)
+            bench_run(wrk, x);
+    }
+
+    pcr_exception_catchall {
+        pcr_exception_print();
+    }
+
+    return 0;
+}
@@ -159,6 +159,7 @@ extern "C" {
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 
 /**
@@ -420,6 +421,85 @@ pcr_mempool_alloc(size_t sz, pcr_exception ex);
 extern void *
 pcr_mempool_realloc(void *ptr, size_t sz, pcr_exception ex);
 
+/**
+ * @private
+ * Private helper functions for registering worker threads with the garbage
+ * collector; these are called by the pcr_worker interface.
+ */
+extern void
+pcr_mempool_thread_init__(void);
+
+extern void
+pcr_mempool_thread_enter__(void);
+
+extern void
+pcr_mempool_thread_exit__(void);
+
+/**
+ * @private
+ * Private helper function for registering a finalizer that releases resources
+ * held outside the garbage collected heap by @ptr; used by pcr_vector_map()
+ * and pcr_dbase_open_cursor().
+ */
+extern void
+pcr_mempool_finalize__(void *ptr, void (*fin)(void *ptr, void *opt),
+                       void *opt);
+
+
+/******************************************************************************
+ * INTERFACE: pcr_refcount
+ */
+
+/**
+ * @private
+ * Reference counts shared by the copy-on-write runtime objects. By default these
+ * are C11 atomics so that handles may be copied and forked concurrently from
+ * worker threads; defining PCR_SINGLE_THREADED at compile time (or building
+ * with a compiler lacking <stdatomic.h>) falls back to plain counters.
+ *
+ * Increments are relaxed since a new handle is always derived from an existing
+ * one. Decrements release, and reads acquire, so that a fork which observes a
+ * count of 1 also observes every hard copy taken by the other handle owners.
+ */
+#if (defined PCR_SINGLE_THREADED || defined __STDC_NO_ATOMICS__)
+    typedef size_t pcr_refcount__;
+#   define pcr_refcount_init__(r, n) (*(r) = (n))
+#   define pcr_refcount_get__(r) (*(r))
+#   define pcr_refcount_inc__(r) ((void) ++*(r))
+#   define pcr_refcount_dec__(r) ((void) --*(r))
+#else
+#   include <stdatomic.h>
+    typedef atomic_size_t pcr_refcount__;
+#   define pcr_refcount_init__(r, n) atomic_init((r), (n))
+#   define pcr_refcount_get__(r) \
+        atomic_load_explicit((r), memory_order_acquire)
+#   define pcr_refcount_inc__(r) \
+        ((void) atomic_fetch_add_explicit((r), 1, memory_order_relaxed))
+#   define pcr_refcount_dec__(r) \
+        ((void) atomic_fetch_sub_explicit((r), 1, memory_order_release))
+#endif
+
+
+/******************************************************************************
+ * INTERFACE: pcr_worker
+ */
+
+#if !defined PCR_WORKER_MAX
+#   define PCR_WORKER_MAX 64
+#endif
+
+typedef void
+(pcr_worker_task)(size_t id, size_t len, void *opt, pcr_exception ex);
+
+extern size_t
+pcr_worker_count(void);
+
+extern void
+pcr_worker_limit(size_t len);
+
+extern void
+pcr_worker_run(size_t len, pcr_worker_task *task, void *opt, pcr_exception ex);
+
 
 /******************************************************************************
  * INTERFACE: pcr_vector
@@ -427,6 +507,23 @@ pcr_mempool_realloc(void *ptr, size_t sz, pcr_exception ex);
 
 typedef struct pcr_vector pcr_vector;
 
+/** @private */
+/* The layout of pcr_vector is exposed only so that the typed vectors generated
+ * by PCR_VECTOR_DEFINE() can access elements inline; client code must treat
+ * pcr_vector as an abstract data type. A slice has a non-null base, whose
+ * payload it shares; a mapped vector has its payload in a private file mapping
+ * instead of on the heap. */
+struct pcr_vector {
+    void *payload;
+    size_t sz;
+    size_t len;
+    size_t cap;
+    pcr_refcount__ ref;
+    struct pcr_vector *base;
+    bool sorted;
+    bool mapped;
+};
+
 typedef void
 (pcr_iterator)(const void *elem, size_t idx, void *opt, pcr_exception ex);
 
@@ -436,9 +533,20 @@ typedef void
 typedef int
 (pcr_comparator)(const void *ctx, const void *cmp);
 
+#if !defined PCR_VECTOR_SORT_THRESHOLD
+#   define PCR_VECTOR_SORT_THRESHOLD 65536
+#endif
+
+#if !defined PCR_VECTOR_INLINE
+#   define PCR_VECTOR_INLINE 4
+#endif
+
 extern pcr_vector *
 pcr_vector_new(size_t elemsz, pcr_exception ex);
 
+extern pcr_vector *
+pcr_vector_new_2(size_t elemsz, size_t cap, pcr_exception ex);
+
 extern pcr_vector *
 pcr_vector_copy(const pcr_vector *ctx, pcr_exception ex);
 
@@ -451,6 +559,20 @@ pcr_vector_refcount(const pcr_vector *ctx, pcr_exception ex);
 extern bool
 pcr_vector_sorted(const pcr_vector *ctx, pcr_exception ex);
 
+extern pcr_vector *
+pcr_vector_slice(const pcr_vector *ctx, size_t idx, size_t len,
+                 pcr_exception ex);
+
+extern pcr_vector *
+pcr_vector_map(const char *path, size_t elemsz, pcr_exception ex);
+
+extern pcr_vector *
+pcr_vector_map_2(const char *path, size_t elemsz, bool readonly,
+                 pcr_exception ex);
+
+extern void
+pcr_vector_persist(const pcr_vector *ctx, const char *path, pcr_exception ex);
+
 extern void *
 pcr_vector_elem(const pcr_vector *ctx, size_t idx, pcr_exception ex);
 
@@ -461,16 +583,54 @@ pcr_vector_setelem(pcr_vector **ctx, const void *elem, size_t idx,
 extern void
 pcr_vector_push(pcr_vector **ctx, const void *elem, pcr_exception ex);
 
+extern void
+pcr_vector_push_n(pcr_vector **ctx, const void *elems, size_t len,
+                  pcr_exception ex);
+
 extern void
 pcr_vector_pop(pcr_vector **ctx, pcr_exception ex);
 
 extern void
 pcr_vector_sort(pcr_vector **ctx, pcr_comparator *cmp, pcr_exception ex);
 
+extern void
+pcr_vector_sort_stable(pcr_vector **ctx, pcr_comparator *cmp,
+                        pcr_exception ex);
+
+extern void
+pcr_vector_sort_i64(pcr_vector **ctx, pcr_exception ex);
+
+extern void
+pcr_vector_sort_f64(pcr_vector **ctx, pcr_exception ex);
+
 extern size_t
 pcr_vector_search(pcr_vector **ctx, const void *key, pcr_comparator *cmp,
                         pcr_exception ex);
 
+extern size_t
+pcr_vector_lower_bound(const pcr_vector *ctx, const void *key,
+                        pcr_comparator *cmp, pcr_exception ex);
+
+extern size_t
+pcr_vector_upper_bound(const pcr_vector *ctx, const void *key,
+                        pcr_comparator *cmp, pcr_exception ex);
+
+extern void
+pcr_vector_insert_sorted(pcr_vector **ctx, const void *elem,
+                        pcr_comparator *cmp, pcr_exception ex);
+
+extern pcr_vector *
+pcr_vector_union(const pcr_vector *lhs, const pcr_vector *rhs,
+                        pcr_comparator *cmp, pcr_exception ex);
+
+extern pcr_vector *
+pcr_vector_intersect(const pcr_vector *lhs, const pcr_vector *rhs,
+                        pcr_comparator *cmp, pcr_exception ex);
+
+extern pcr_vector *
+pcr_vector_difference(const pcr_vector *lhs, const pcr_vector *rhs,
+                        pcr_comparator *cmp, pcr_exception ex);
+
 extern void
 pcr_vector_iterate(const pcr_vector *ctx, pcr_iterator *itr, void *opt,
                         pcr_exception ex);
@@ -479,6 +639,255 @@ extern void
 pcr_vector_muterate(pcr_vector **ctx, pcr_muterator *mtr, void *opt,
                         pcr_exception ex);
 
+extern void
+pcr_vector_iterate_par(const pcr_vector *ctx, pcr_iterator *itr, void **opt,
+                        size_t len, pcr_exception ex);
+
+extern void
+pcr_vector_muterate_par(pcr_vector **ctx, pcr_muterator *mtr, void **opt,
+                        size_t len, pcr_exception ex);
+
+typedef enum PCR_VECTOR_CMP {
+    PCR_VECTOR_CMP_EQ,
+    PCR_VECTOR_CMP_NE,
+    PCR_VECTOR_CMP_LT,
+    PCR_VECTOR_CMP_LE,
+    PCR_VECTOR_CMP_GT,
+    PCR_VECTOR_CMP_GE
+} PCR_VECTOR_CMP;
+
+typedef enum PCR_VECTOR_ARITH {
+    PCR_VECTOR_ARITH_ADD,
+    PCR_VECTOR_ARITH_SUB,
+    PCR_VECTOR_ARITH_MUL,
+    PCR_VECTOR_ARITH_DIV
+} PCR_VECTOR_ARITH;
+
+extern int64_t
+pcr_vector_sum_i64(const pcr_vector *ctx, pcr_exception ex);
+
+extern double
+pcr_vector_sum_f64(const pcr_vector *ctx, pcr_exception ex);
+
+extern int64_t
+pcr_vector_min_i64(const pcr_vector *ctx, pcr_exception ex);
+
+extern int64_t
+pcr_vector_max_i64(const pcr_vector *ctx, pcr_exception ex);
+
+extern double
+pcr_vector_min_f64(const pcr_vector *ctx, pcr_exception ex);
+
+extern double
+pcr_vector_max_f64(const pcr_vector *ctx, pcr_exception ex);
+
+extern size_t
+pcr_vector_count_i64(const pcr_vector *ctx, PCR_VECTOR_CMP cmp, int64_t val,
+                     pcr_exception ex);
+
+extern size_t
+pcr_vector_count_f64(const pcr_vector *ctx, PCR_VECTOR_CMP cmp, double val,
+                     pcr_exception ex);
+
+extern pcr_vector *
+pcr_vector_select_i64(const pcr_vector *ctx, PCR_VECTOR_CMP cmp, int64_t val,
+                      pcr_exception ex);
+
+extern pcr_vector *
+pcr_vector_select_f64(const pcr_vector *ctx, PCR_VECTOR_CMP cmp, double val,
+                      pcr_exception ex);
+
+extern void
+pcr_vector_arith_i64(pcr_vector **ctx, PCR_VECTOR_ARITH op, int64_t val,
+                     pcr_exception ex);
+
+extern void
+pcr_vector_arith_f64(pcr_vector **ctx, PCR_VECTOR_ARITH op, double val,
+                     pcr_exception ex);
+
+/**
+ * @private
+ * Private numeric kernels backing the functions above; these dispatch at run
+ * time to AVX2 where the processor supports it, and to scalar code otherwise.
+ */
+extern int64_t
+pcr_simd_sum_i64__(const int64_t *arr, size_t len);
+
+extern double
+pcr_simd_sum_f64__(const double *arr, size_t len);
+
+extern int64_t
+pcr_simd_minmax_i64__(const int64_t *arr, size_t len, bool max);
+
+extern double
+pcr_simd_minmax_f64__(const double *arr, size_t len, bool max);
+
+extern size_t
+pcr_simd_select_i64__(const int64_t *arr, size_t len, PCR_VECTOR_CMP cmp,
+                      int64_t val, size_t *sel);
+
+extern size_t
+pcr_simd_select_f64__(const double *arr, size_t len, PCR_VECTOR_CMP cmp,
+                      double val, size_t *sel);
+
+extern void
+pcr_simd_arith_i64__(int64_t *arr, size_t len, PCR_VECTOR_ARITH op,
+                     int64_t val);
+
+extern void
+pcr_simd_arith_f64__(double *arr, size_t len, PCR_VECTOR_ARITH op, double val);
+
+/* PCR_VECTOR_DEFINE_2() generates a typed vector @name holding elements of
+ * type @T. The generated type is a pcr_vector, so the whole pcr_vector
+ * interface works on it, but its accessors are inline and work directly on @T
+ * without going through void pointers, memcpy() or a heap copy. Elements are
+ * passed in as @CT, and converted to @T through @cp(elem, ex) when they are
+ * stored; this is how vectors of handles make their own copies of the elements
+ * pushed on to them. The _take variants of push and elem_set store a @T as-is,
+ * so that a caller can hand over an element it has just built without it being
+ * copied again. PCR_VECTOR_DEFINE() is the common case where elements are
+ * stored as-is. Exactly one translation unit must instantiate the external
+ * definitions of the generated functions through PCR_VECTOR_EXTERN(). */
+
+#define PCR_VECTOR_ASIS(e, x) (e)
+
+#define PCR_VECTOR_DEFINE(name, T) \
+    PCR_VECTOR_DEFINE_2(name, T, T, PCR_VECTOR_ASIS)
+
+#define PCR_VECTOR_DEFINE_2(name, T, CT, cp)                                  \
+    typedef pcr_vector name;                                                  \
+                                                                              \
+    inline name *                                                             \
+    name##_new(pcr_exception ex)                                              \
+    {                                                                         \
+        return pcr_vector_new(sizeof (T), ex);                                \
+    }                                                                         \
+                                                                              \
+    inline name *                                                             \
+    name##_copy(const name *ctx, pcr_exception ex)                            \
+    {                                                                         \
+        return pcr_vector_copy(ctx, ex);                                      \
+    }                                                                         \
+                                                                              \
+    inline name *                                                             \
+    name##_slice(const name *ctx, size_t idx, size_t len, pcr_exception ex)   \
+    {                                                                         \
+        return pcr_vector_slice(ctx, idx, len, ex);                           \
+    }                                                                         \
+                                                                              \
+    inline size_t                                                             \
+    name##_len(const name *ctx, pcr_exception ex)                             \
+    {                                                                         \
+        pcr_assert_handle(ctx, ex);                                           \
+        return ctx->len;                                                      \
+    }                                                                         \
+                                                                              \
+    inline size_t                                                             \
+    name##_refcount(const name *ctx, pcr_exception ex)                        \
+    {                                                                         \
+        return pcr_vector_refcount(ctx, ex);                                  \
+    }                                                                         \
+                                                                              \
+    inline bool                                                               \
+    name##_sorted(const name *ctx, pcr_exception ex)                          \
+    {                                                                         \
+        pcr_assert_handle(ctx, ex);                                           \
+        return ctx->sorted;                                                   \
+    }                                                                         \
+                                                                              \
+    inline T                                                                  \
+    name##_elem(const name *ctx, size_t idx, pcr_exception ex)                \
+    {                                                                         \
+        pcr_assert_handle(ctx, ex);                                           \
+        pcr_assert_range(idx && idx <= ctx->len, ex);                         \
+                                                                              \
+        return ((T *) ctx->payload)[idx - 1];                                 \
+    }                                                                         \
+                                                                              \
+    inline void                                                               \
+    name##_elem_set_take(name **ctx, size_t idx, T elem, pcr_exception ex)    \
+    {                                                                         \
+        pcr_vector_setelem(ctx, &elem, idx, ex);                              \
+    }                                                                         \
+                                                                              \
+    inline void                                                               \
+    name##_elem_set(name **ctx, size_t idx, CT elem, pcr_exception ex)        \
+    {                                                                         \
+        name##_elem_set_take(ctx, idx, cp(elem, ex), ex);                     \
+    }                                                                         \
+                                                                              \
+    inline void                                                               \
+    name##_push_take(name **ctx, T elem, pcr_exception ex)                    \
+    {                                                                         \
+        pcr_assert_handle(ctx && *ctx, ex);                                   \
+                                                                              \
+        pcr_vector *hnd = *ctx;                                               \
+        if (pcr_hint_likely (hnd->len < hnd->cap                              \
+                             && pcr_refcount_get__(&hnd->ref) == 1)) {        \
+            ((T *) hnd->payload)[hnd->len++] = elem;                          \
+            hnd->sorted = false;                                              \
+        } else                                                                \
+            pcr_vector_push(ctx, &elem, ex);                                  \
+    }                                                                         \
+                                                                              \
+    inline void                                                               \
+    name##_push(name **ctx, CT elem, pcr_exception ex)                        \
+    {                                                                         \
+        pcr_assert_handle(ctx && *ctx, ex);                                   \
+        name##_push_take(ctx, cp(elem, ex), ex);                              \
+    }                                                                         \
+                                                                              \
+    inline name *                                                             \
+    name##_new_2(const CT *arr, size_t len, pcr_exception ex)                 \
+    {                                                                         \
+        pcr_assert_handle(arr, ex);                                           \
+        pcr_assert_range(len, ex);                                            \
+                                                                              \
+        name *vec = pcr_vector_new_2(sizeof (T), len, ex);                    \
+        for (register size_t i = 0; i < len; i++)                             \
+            name##_push(&vec, arr[i], ex);                                    \
+                                                                              \
+        return vec;                                                           \
+    }                                                                         \
+                                                                              \
+    inline void                                                               \
+    name##_iterate(const name *ctx, pcr_iterator *itr, void *opt,             \
+                   pcr_exception ex)                                          \
+    {                                                                         \
+        pcr_assert_handle(ctx && itr, ex);                                    \
+                                                                              \
+        const T *arr = (const T *) ctx->payload;                              \
+        for (register size_t i = 0, len = ctx->len; i < len; i++)             \
+            itr(&arr[i], i + 1, opt, ex);                                     \
+    }                                                                         \
+                                                                              \
+    inline void                                                               \
+    name##_muterate(name **ctx, pcr_muterator *mtr, void *opt,                \
+                    pcr_exception ex)                                         \
+    {                                                                         \
+        pcr_vector_muterate(ctx, mtr, opt, ex);                               \
+    }
+
+#define PCR_VECTOR_EXTERN(name, T, CT)                                        \
+    extern inline name *name##_new(pcr_exception);                            \
+    extern inline name *name##_new_2(const CT *, size_t, pcr_exception);      \
+    extern inline name *name##_copy(const name *, pcr_exception);             \
+    extern inline name *name##_slice(const name *, size_t, size_t,            \
+                                     pcr_exception);                          \
+    extern inline size_t name##_len(const name *, pcr_exception);             \
+    extern inline size_t name##_refcount(const name *, pcr_exception);        \
+    extern inline bool name##_sorted(const name *, pcr_exception);            \
+    extern inline T name##_elem(const name *, size_t, pcr_exception);         \
+    extern inline void name##_elem_set(name **, size_t, CT, pcr_exception);   \
+    extern inline void name##_elem_set_take(name **, size_t, T,               \
+                                            pcr_exception);                   \
+    extern inline void name##_push(name **, CT, pcr_exception);               \
+    extern inline void name##_push_take(name **, T, pcr_exception);           \
+    extern inline void name##_iterate(const name *, pcr_iterator *, void *,   \
+                                      pcr_exception);                         \
+    extern inline void name##_muterate(name **, pcr_muterator *, void *,      \
+                                       pcr_exception)
+
 
 /**************************************************************************//**
  * @defgroup pcr_string PCR String Module
@@ -764,114 +1173,210 @@ pcr_string_float(double value, pcr_exception ex);
  * INTERFACE: pcr_string_vector
  */
 
-typedef pcr_vector pcr_string_vector;
+PCR_VECTOR_DEFINE_2(pcr_string_vector, pcr_string *, const pcr_string *,
+                    pcr_string_copy)
 
-inline pcr_string_vector *
-pcr_string_vector_new(pcr_exception ex)
-{
-    return pcr_vector_new(sizeof (pcr_string *), ex);
-}
-
-inline pcr_string_vector *
-pcr_string_vector_new_2(const pcr_string **arr, size_t len, pcr_exception ex)
+inline int
+__pcr_string_vector_comparator(const void *ctx, const void *cmp)
 {
-    pcr_assert_handle(arr, ex);
-    pcr_assert_range(len, ex);
-
-    pcr_string_vector *vec = pcr_string_vector_new(ex);
-
-    register pcr_string *str;
-    for (register size_t i = 0; i < len; i++) {
-        str = pcr_string_new(arr[i], ex);
-        pcr_vector_push(&vec, str, ex);
-    }
-
-    return vec;
+    return strcmp(*((pcr_string * const *) ctx), *((pcr_string * const *) cmp));
 }
 
-inline pcr_string_vector *
-pcr_string_vector_copy(const pcr_string_vector *ctx, pcr_exception ex)
+inline void
+pcr_string_vector_sort(pcr_string_vector **ctx, pcr_exception ex)
 {
-    return pcr_vector_copy(ctx, ex);
+    pcr_vector_sort(ctx, &__pcr_string_vector_comparator, ex);
 }
 
 inline size_t
-pcr_string_vector_len(const pcr_string_vector *ctx, pcr_exception ex)
+pcr_string_vector_search(pcr_string_vector **ctx, const pcr_string *key,
+                         pcr_exception ex)
 {
-    return pcr_vector_len(ctx, ex);
+    return pcr_vector_search(ctx, &key, &__pcr_string_vector_comparator, ex);
 }
 
-inline size_t
-pcr_string_vector_refcount(const pcr_string_vector *ctx, pcr_exception ex)
-{
-    return pcr_vector_refcount(ctx, ex);
-}
+extern void
+pcr_string_vector_sort_radix(pcr_string_vector **ctx, pcr_exception ex);
 
-inline bool
-pcr_string_vector_sorted(const pcr_string_vector *ctx, pcr_exception ex)
-{
-    return pcr_vector_sorted(ctx, ex);
-}
 
-inline pcr_string *
-pcr_string_vector_elem(const pcr_string_vector *ctx, size_t idx,
-                       pcr_exception ex)
-{
-    return (pcr_string *) pcr_vector_elem(ctx, idx, ex);
-}
+/******************************************************************************
+ * INTERFACE: pcr_deque
+ */
 
-inline void
-pcr_string_vector_elem_set(pcr_string_vector **ctx, size_t idx,
-                           const pcr_string *elem, pcr_exception ex)
-{
-    pcr_string *str = pcr_string_new(elem, ex);
-    pcr_vector_setelem(ctx, &str, idx, ex);
-}
+typedef struct pcr_deque pcr_deque;
 
-inline void
-pcr_string_vector_push(pcr_string_vector **ctx, const pcr_string *elem,
-                       pcr_exception ex)
-{
-    pcr_string *str = pcr_string_new(elem, ex);
-    pcr_vector_push(ctx, &str, ex);
-}
+extern pcr_deque *
+pcr_deque_new(size_t elemsz, pcr_exception ex);
 
-inline int
-__pcr_string_vector_comparator(const void *ctx, const void *cmp)
-{
-    pcr_exception_try (x) {
-        return !pcr_string_cmp((pcr_string *) ctx, (pcr_string *) cmp, x);
-    }
+extern pcr_deque *
+pcr_deque_copy(const pcr_deque *ctx, pcr_exception ex);
 
-    return -1;
-}
+extern size_t
+pcr_deque_len(const pcr_deque *ctx, pcr_exception ex);
 
-inline void
-pcr_string_vector_sort(pcr_string_vector **ctx, pcr_exception ex)
-{
-    pcr_vector_sort(ctx, &__pcr_string_vector_comparator, ex);
-}
+extern size_t
+pcr_deque_refcount(const pcr_deque *ctx, pcr_exception ex);
 
-inline size_t
-pcr_string_vector_search(pcr_string_vector **ctx, const pcr_string *key,
-                         pcr_exception ex)
-{
-    return pcr_vector_search(ctx, key, &__pcr_string_vector_comparator, ex);
-}
+extern void *
+pcr_deque_elem(const pcr_deque *ctx, size_t idx, pcr_exception ex);
 
-inline void
-pcr_string_vector_iterate(const pcr_string_vector *ctx, pcr_iterator *itr,
-                          void *opt, pcr_exception ex)
-{
-    pcr_vector_iterate(ctx, itr, opt, ex);
-}
+extern void
+pcr_deque_push_back(pcr_deque **ctx, const void *elem, pcr_exception ex);
 
-inline void
-pcr_string_vector_muterate(pcr_string_vector **ctx, pcr_muterator *mtr,
-                           void *opt, pcr_exception ex)
-{
-    pcr_vector_muterate(ctx, mtr, opt, ex);
-}
+extern void
+pcr_deque_push_front(pcr_deque **ctx, const void *elem, pcr_exception ex);
+
+extern void
+pcr_deque_pop_back(pcr_deque **ctx, void *elem, pcr_exception ex);
+
+extern void
+pcr_deque_pop_front(pcr_deque **ctx, void *elem, pcr_exception ex);
+
+/**
+ * Moves up to @p len elements from the front of a deque to the back of a
+ * vector, returning the number moved. A @p len of 0 moves nothing; use
+ * pcr_deque_drain_all() to empty the deque.
+ */
+extern size_t
+pcr_deque_drain(pcr_deque **ctx, pcr_vector **vec, size_t len,
+                pcr_exception ex);
+
+extern size_t
+pcr_deque_drain_all(pcr_deque **ctx, pcr_vector **vec, pcr_exception ex);
+
+
+/******************************************************************************
+ * INTERFACE: pcr_segvector
+ */
+
+typedef struct pcr_segvector pcr_segvector;
+
+extern pcr_segvector *
+pcr_segvector_new(size_t elemsz, pcr_exception ex);
+
+extern size_t
+pcr_segvector_push(pcr_segvector *ctx, const void *elem, pcr_exception ex);
+
+extern size_t
+pcr_segvector_len(const pcr_segvector *ctx, pcr_exception ex);
+
+extern const void *
+pcr_segvector_elem(const pcr_segvector *ctx, size_t idx, pcr_exception ex);
+
+extern pcr_vector *
+pcr_segvector_flatten(const pcr_segvector *ctx, pcr_exception ex);
+
+
+/******************************************************************************
+ * INTERFACE: pcr_json_writer
+ */
+
+typedef struct pcr_json_writer pcr_json_writer;
+
+#if !defined PCR_JSON_WRITER_BUFFER
+#   define PCR_JSON_WRITER_BUFFER 65536
+#endif
+
+extern pcr_json_writer *
+pcr_json_writer_new(pcr_exception ex);
+
+extern pcr_json_writer *
+pcr_json_writer_new_2(FILE *file, pcr_exception ex);
+
+extern size_t
+pcr_json_writer_len(const pcr_json_writer *ctx, pcr_exception ex);
+
+extern pcr_string *
+pcr_json_writer_string(const pcr_json_writer *ctx, pcr_exception ex);
+
+extern void
+pcr_json_writer_flush(pcr_json_writer *ctx, pcr_exception ex);
+
+extern void
+pcr_json_writer_raw(pcr_json_writer *ctx, const char *str, size_t len,
+                    pcr_exception ex);
+
+extern void
+pcr_json_writer_text(pcr_json_writer *ctx, const char *str, size_t len,
+                     pcr_exception ex);
+
+extern void
+pcr_json_writer_int(pcr_json_writer *ctx, int64_t value, pcr_exception ex);
+
+extern void
+pcr_json_writer_float(pcr_json_writer *ctx, double value, pcr_exception ex);
+
+extern void
+pcr_json_writer_null(pcr_json_writer *ctx, pcr_exception ex);
+
+
+/******************************************************************************
+ * INTERFACE: pcr_map
+ */
+
+typedef struct pcr_map pcr_map;
+
+typedef void
+(pcr_map_iterator)(const void *key, size_t keysz, const void *val, void *opt,
+                   pcr_exception ex);
+
+extern pcr_map *
+pcr_map_new(size_t valsz, pcr_exception ex);
+
+extern pcr_map *
+pcr_map_copy(const pcr_map *ctx, pcr_exception ex);
+
+extern size_t
+pcr_map_len(const pcr_map *ctx, pcr_exception ex);
+
+extern size_t
+pcr_map_refcount(const pcr_map *ctx, pcr_exception ex);
+
+extern void
+pcr_map_reserve(pcr_map **ctx, size_t len, pcr_exception ex);
+
+extern bool
+pcr_map_get(const pcr_map *ctx, const void *key, size_t keysz, void *val,
+            pcr_exception ex);
+
+extern void
+pcr_map_set(pcr_map **ctx, const void *key, size_t keysz, const void *val,
+            pcr_exception ex);
+
+extern bool
+pcr_map_remove(pcr_map **ctx, const void *key, size_t keysz, pcr_exception ex);
+
+extern void
+pcr_map_iterate(const pcr_map *ctx, pcr_map_iterator *itr, void *opt,
+                pcr_exception ex);
+
+extern bool
+pcr_map_get_str(const pcr_map *ctx, const pcr_string *key, void *val,
+                pcr_exception ex);
+
+extern void
+pcr_map_set_str(pcr_map **ctx, const pcr_string *key, const void *val,
+                pcr_exception ex);
+
+extern bool
+pcr_map_remove_str(pcr_map **ctx, const pcr_string *key, pcr_exception ex);
+
+extern bool
+pcr_map_get_i64(const pcr_map *ctx, int64_t key, void *val, pcr_exception ex);
+
+extern void
+pcr_map_set_i64(pcr_map **ctx, int64_t key, const void *val, pcr_exception ex);
+
+extern bool
+pcr_map_remove_i64(pcr_map **ctx, int64_t key, pcr_exception ex);
+
+/**
+ * @private
+ * Private helper function for hashing bytes; exposed so that other modules can
+ * hash values consistently with pcr_map.
+ */
+extern uint64_t
+pcr_map_hash__(const void *key, size_t len);
 
 
 /******************************************************************************
@@ -945,7 +1450,8 @@ typedef enum PCR_ATTRIBUTE {
     PCR_ATTRIBUTE_NULL,
     PCR_ATTRIBUTE_INT,
     PCR_ATTRIBUTE_FLOAT,
-    PCR_ATTRIBUTE_TEXT
+    PCR_ATTRIBUTE_TEXT,
+    PCR_ATTRIBUTE_BLOB
 } PCR_ATTRIBUTE;
 
 
@@ -953,80 +1459,18 @@ typedef enum PCR_ATTRIBUTE {
  * INTERFACE: PCR_ATTRIBUTE_VECTOR
  */
 
-typedef pcr_vector PCR_ATTRIBUTE_VECTOR;
+PCR_VECTOR_DEFINE(PCR_ATTRIBUTE_VECTOR, PCR_ATTRIBUTE)
 
-inline PCR_ATTRIBUTE_VECTOR *
-PCR_ATTRIBUTE_VECTOR_NEW(pcr_exception ex)
-{
-    return pcr_vector_new(sizeof (PCR_ATTRIBUTE), ex);
-}
-
-inline PCR_ATTRIBUTE_VECTOR *
-PCR_ATTRIBUTE_VECTOR_NEW_2(const PCR_ATTRIBUTE *arr, size_t len,
-                           pcr_exception ex)
-{
-    pcr_assert_handle(arr, ex);
-    pcr_assert_range(len ,ex);
-
-    PCR_ATTRIBUTE_VECTOR *vec = PCR_ATTRIBUTE_VECTOR_NEW(ex);
-    for (register size_t i = 0; i < len; i++)
-        pcr_vector_push(&vec, &arr[i], ex);
-
-    return vec;
-}
-
-inline PCR_ATTRIBUTE_VECTOR *
-PCR_ATTRIBUTE_VECTOR_COPY(const PCR_ATTRIBUTE_VECTOR *ctx, pcr_exception ex)
-{
-    return pcr_vector_copy(ctx, ex);
-}
-
-inline size_t
-PCR_ATTRIBUTE_VECTOR_LEN(const PCR_ATTRIBUTE_VECTOR *ctx, pcr_exception ex)
-{
-    return pcr_vector_len(ctx, ex);
-}
-
-inline size_t
-PCR_ATTRIBUTE_VECTOR_REFCOUNT(const PCR_ATTRIBUTE_VECTOR *ctx, pcr_exception ex)
-{
-    return pcr_vector_refcount(ctx, ex);
-}
-
-inline PCR_ATTRIBUTE
-PCR_ATTRIBUTE_VECTOR_ELEM(const PCR_ATTRIBUTE_VECTOR *ctx, size_t idx,
-                          pcr_exception ex)
-{
-    return *((PCR_ATTRIBUTE *) pcr_vector_elem(ctx, idx, ex));
-}
-
-inline void
-PCR_ATTRIBUTE_VECTOR_ELEM_SET(PCR_ATTRIBUTE_VECTOR **ctx, size_t idx,
-                              PCR_ATTRIBUTE elem, pcr_exception ex)
-{
-    pcr_vector_setelem(ctx, &elem, idx, ex);
-}
-
-inline void
-PCR_ATTRIBUTE_VECTOR_PUSH(PCR_ATTRIBUTE_VECTOR **ctx, PCR_ATTRIBUTE elem,
-                          pcr_exception ex)
-{
-    pcr_vector_push(ctx, &elem, ex);
-}
-
-inline void
-PCR_ATTRIBUTE_VECTOR_ITERATE(const PCR_ATTRIBUTE_VECTOR *ctx, pcr_iterator *itr,
-                             void *opt, pcr_exception ex)
-{
-    pcr_vector_iterate(ctx, itr, opt, ex);
-}
-
-inline void
-PCR_ATTRIBUTE_VECTOR_MUTERATE(PCR_ATTRIBUTE_VECTOR **ctx, pcr_muterator *mtr,
-                              void *opt, pcr_exception ex)
-{
-    pcr_vector_muterate(ctx, mtr, opt, ex);
-}
+#define PCR_ATTRIBUTE_VECTOR_NEW PCR_ATTRIBUTE_VECTOR_new
+#define PCR_ATTRIBUTE_VECTOR_NEW_2 PCR_ATTRIBUTE_VECTOR_new_2
+#define PCR_ATTRIBUTE_VECTOR_COPY PCR_ATTRIBUTE_VECTOR_copy
+#define PCR_ATTRIBUTE_VECTOR_LEN PCR_ATTRIBUTE_VECTOR_len
+#define PCR_ATTRIBUTE_VECTOR_REFCOUNT PCR_ATTRIBUTE_VECTOR_refcount
+#define PCR_ATTRIBUTE_VECTOR_ELEM PCR_ATTRIBUTE_VECTOR_elem
+#define PCR_ATTRIBUTE_VECTOR_ELEM_SET PCR_ATTRIBUTE_VECTOR_elem_set
+#define PCR_ATTRIBUTE_VECTOR_PUSH PCR_ATTRIBUTE_VECTOR_push
+#define PCR_ATTRIBUTE_VECTOR_ITERATE PCR_ATTRIBUTE_VECTOR_iterate
+#define PCR_ATTRIBUTE_VECTOR_MUTERATE PCR_ATTRIBUTE_VECTOR_muterate
 
 /******************************************************************************
  * INTERFACE: pcr_attribute
@@ -1034,10 +1478,19 @@ PCR_ATTRIBUTE_VECTOR_MUTERATE(PCR_ATTRIBUTE_VECTOR **ctx, pcr_muterator *mtr,
 
 typedef struct pcr_attribute pcr_attribute;
 
+typedef struct pcr_blob {
+    const void *data;
+    size_t len;
+} pcr_blob;
+
 extern pcr_attribute *
 pcr_attribute_new(PCR_ATTRIBUTE type, const pcr_string *key, const void *value,
                   pcr_exception ex);
 
+extern pcr_attribute *
+pcr_attribute_new_take(PCR_ATTRIBUTE type, pcr_string *key, void *value,
+                       pcr_exception ex);
+
 inline pcr_attribute *
 pcr_attribute_new_null(const pcr_string *key, pcr_exception ex)
 {
@@ -1081,6 +1534,21 @@ pcr_attribute_new_text_2(const pcr_string *key, pcr_exception ex)
     return pcr_attribute_new_text(key, "", ex);
 }
 
+inline pcr_attribute *
+pcr_attribute_new_text_take(pcr_string *key, pcr_string *value,
+                            pcr_exception ex)
+{
+    return pcr_attribute_new_take(PCR_ATTRIBUTE_TEXT, key, value, ex);
+}
+
+inline pcr_attribute *
+pcr_attribute_new_blob(const pcr_string *key, const void *data, size_t len,
+                       pcr_exception ex)
+{
+    pcr_blob value = {.data = data, .len = len};
+    return pcr_attribute_new(PCR_ATTRIBUTE_BLOB, key, &value, ex);
+}
+
 extern pcr_attribute *
 pcr_attribute_copy(const pcr_attribute *ctx, pcr_exception ex);
 
@@ -1093,6 +1561,18 @@ pcr_attribute_key(const pcr_attribute *ctx, pcr_exception ex);
 extern void *
 pcr_attribute_value(const pcr_attribute *ctx, pcr_exception ex);
 
+extern int64_t
+pcr_attribute_int(const pcr_attribute *ctx, pcr_exception ex);
+
+extern double
+pcr_attribute_float(const pcr_attribute *ctx, pcr_exception ex);
+
+extern const pcr_string *
+pcr_attribute_text_ref(const pcr_attribute *ctx, pcr_exception ex);
+
+extern pcr_blob
+pcr_attribute_blob(const pcr_attribute *ctx, pcr_exception ex);
+
 extern size_t
 pcr_attribute_valuesz(const pcr_attribute *ctx, pcr_exception ex);
 
@@ -1102,86 +1582,68 @@ pcr_attribute_string(const pcr_attribute *ctx, pcr_exception ex);
 extern pcr_string *
 pcr_attribute_json(const pcr_attribute *ctx, pcr_exception ex);
 
+extern void
+pcr_attribute_json_write(const pcr_attribute *ctx, pcr_json_writer *writer,
+                         pcr_exception ex);
 
-/******************************************************************************
- * INTERFACE: pcr_attribute_vector
- */
+extern pcr_blob
+pcr_attribute_encode(const pcr_attribute *ctx, pcr_exception ex);
 
+extern pcr_attribute *
+pcr_attribute_decode(pcr_blob bfr, pcr_exception ex);
 
-typedef pcr_vector pcr_attribute_vector;
+extern pcr_attribute *
+pcr_attribute_decode_ref(pcr_blob bfr, pcr_exception ex);
 
-inline pcr_attribute_vector *
-pcr_attribute_vector_new(pcr_exception ex)
-{
-    return pcr_vector_new(sizeof (pcr_attribute *), ex);
-}
+extern int
+pcr_attribute_cmp(const pcr_attribute *lhs, const pcr_attribute *rhs,
+                  pcr_exception ex);
 
-inline pcr_attribute_vector *
-pcr_attribute_vector_new_2(const pcr_attribute **arr, size_t len,
-                           pcr_exception ex)
-{
-    pcr_assert_handle(arr, ex);
-    pcr_assert_range(len, ex);
+extern uint64_t
+pcr_attribute_hash(const pcr_attribute *ctx, pcr_exception ex);
 
-    pcr_attribute_vector *vec = pcr_attribute_vector_new(ex);
-    for (register size_t i = 0; i < len; i++)
-        pcr_vector_push(&vec, &arr[i], ex);
+/**
+ * @private
+ * Private helper functions for ranking storage classes and comparing numbers
+ * in the same order as pcr_attribute_cmp(); used by pcr_resultset to compare
+ * cells in place.
+ */
+extern int
+pcr_attribute_rank__(PCR_ATTRIBUTE type);
 
-    return vec;
-}
+extern int
+pcr_attribute_cmp_f64__(double lhs, double rhs);
 
-inline pcr_attribute_vector *
-pcr_attribute_vector_copy(const pcr_attribute_vector *ctx, pcr_exception ex)
-{
-    return pcr_vector_copy(ctx, ex);
-}
+extern int
+pcr_attribute_cmp_i64_f64__(int64_t lhs, double rhs);
 
-inline size_t
-pcr_attribute_vector_len(const pcr_attribute_vector *ctx, pcr_exception ex)
-{
-    return pcr_vector_len(ctx, ex);
-}
 
-inline size_t
-pcr_attribute_vector_refcount(const pcr_string_vector *ctx, pcr_exception ex)
-{
-    return pcr_vector_refcount(ctx, ex);
-}
+/******************************************************************************
+ * INTERFACE: pcr_attribute_vector
+ */
 
-inline pcr_attribute *
-pcr_attribute_vector_elem(const pcr_attribute_vector *ctx, size_t idx,
-                          pcr_exception ex)
-{
-    return *((pcr_attribute **) pcr_vector_elem(ctx, idx, ex));
-}
 
-inline void
-pcr_attribute_vector_elem_set(pcr_attribute_vector **ctx, size_t idx,
-                              const pcr_attribute *elem, pcr_exception ex)
-{
-    pcr_vector_setelem(ctx, elem, idx, ex);
-}
+PCR_VECTOR_DEFINE_2(pcr_attribute_vector, pcr_attribute *,
+                    const pcr_attribute *, pcr_attribute_copy)
 
-inline void
-pcr_attribute_vector_push(pcr_attribute_vector **ctx, const pcr_attribute *elem,
-                          pcr_exception ex)
-{
-    pcr_vector_push(ctx, &elem, ex);
-}
+extern pcr_blob
+pcr_attribute_vector_encode(const pcr_attribute_vector *ctx, pcr_exception ex);
 
-inline void
-pcr_attribute_vector_iterate(const pcr_attribute_vector *ctx, pcr_iterator *itr,
-                             void *opt, pcr_exception ex)
-{
-    pcr_vector_iterate(ctx, itr, opt, ex);
-}
+extern pcr_attribute_vector *
+pcr_attribute_vector_decode(pcr_blob bfr, pcr_exception ex);
 
-inline void
-pcr_attribute_vector_muterate(pcr_attribute_vector **ctx, pcr_muterator *mtr,
-                              void *opt, pcr_exception ex)
-{
-    pcr_vector_muterate(ctx, mtr, opt, ex);
-}
+extern pcr_attribute_vector *
+pcr_attribute_vector_decode_ref(pcr_blob bfr, pcr_exception ex);
+
+extern pcr_vector *
+pcr_attribute_vector_cmp(const pcr_attribute_vector *lhs,
+                         const pcr_attribute_vector *rhs, pcr_exception ex);
+
+extern pcr_vector *
+pcr_attribute_vector_hash(const pcr_attribute_vector *ctx, pcr_exception ex);
+
+extern void
+pcr_attribute_vector_sort(pcr_attribute_vector **ctx, pcr_exception ex);
 
 
 /******************************************************************************
@@ -1190,6 +1652,10 @@ pcr_attribute_vector_muterate(pcr_attribute_vector **ctx, pcr_muterator *mtr,
 
 typedef struct pcr_resultset pcr_resultset;
 
+#if !defined PCR_RESULTSET_SORT_THRESHOLD
+#   define PCR_RESULTSET_SORT_THRESHOLD 65536
+#endif
+
 extern pcr_resultset *
 pcr_resultset_new(const pcr_string *name, const pcr_string_vector *keys,
                   const PCR_ATTRIBUTE_VECTOR *types, pcr_exception ex);
@@ -1223,6 +1689,24 @@ extern pcr_attribute *
 pcr_resultset_attrib(const pcr_resultset *ctx, size_t row, size_t col,
                      pcr_exception ex);
 
+extern size_t
+pcr_resultset_col_index(const pcr_resultset *ctx, const pcr_string *key,
+                        pcr_exception ex);
+
+extern pcr_attribute *
+pcr_resultset_attrib_by_key(const pcr_resultset *ctx, size_t row,
+                            const pcr_string *key, pcr_exception ex);
+
+extern bool
+pcr_resultset_null(const pcr_resultset *ctx, size_t row, size_t col,
+                   pcr_exception ex);
+
+extern pcr_vector *
+pcr_resultset_col_i64(const pcr_resultset *ctx, size_t col, pcr_exception ex);
+
+extern pcr_vector *
+pcr_resultset_col_f64(const pcr_resultset *ctx, size_t col, pcr_exception ex);
+
 extern void
 pcr_resultset_attrib_set(pcr_resultset **ctx, const pcr_attribute *attr,
                          size_t row, size_t col, pcr_exception ex);
@@ -1238,6 +1722,52 @@ pcr_resultset_push_2(pcr_resultset **ctx, const pcr_attribute_vector *attrs,
 extern pcr_string *
 pcr_resultset_json(const pcr_resultset *ctx, pcr_exception ex);
 
+typedef enum PCR_RESULTSET_ORDER {
+    PCR_RESULTSET_ASC,
+    PCR_RESULTSET_DESC
+} PCR_RESULTSET_ORDER;
+
+extern void
+pcr_resultset_sort(pcr_resultset **ctx, const size_t *cols,
+                   const PCR_RESULTSET_ORDER *dirs, size_t len,
+                   pcr_exception ex);
+
+typedef enum PCR_RESULTSET_JSON {
+    PCR_RESULTSET_JSON_DEFAULT = 0,
+    PCR_RESULTSET_JSON_ARRAYS = 1 << 0,
+    PCR_RESULTSET_JSON_LINES = 1 << 1
+} PCR_RESULTSET_JSON;
+
+extern size_t
+pcr_resultset_json_write(const pcr_resultset *ctx, FILE *file,
+                         PCR_RESULTSET_JSON opts, pcr_exception ex);
+
+typedef enum PCR_RESULTSET_AGG {
+    PCR_RESULTSET_COUNT,
+    PCR_RESULTSET_SUM,
+    PCR_RESULTSET_MIN,
+    PCR_RESULTSET_MAX,
+    PCR_RESULTSET_AVG
+} PCR_RESULTSET_AGG;
+
+extern pcr_vector *
+pcr_resultset_filter(const pcr_resultset *ctx, size_t col, PCR_VECTOR_CMP cmp,
+                     const pcr_attribute *val, const pcr_vector *sel,
+                     pcr_exception ex);
+
+extern pcr_resultset *
+pcr_resultset_take(const pcr_resultset *ctx, const pcr_vector *sel,
+                   pcr_exception ex);
+
+extern pcr_resultset *
+pcr_resultset_project(const pcr_resultset *ctx, const size_t *cols, size_t len,
+                      pcr_exception ex);
+
+extern pcr_resultset *
+pcr_resultset_aggregate(const pcr_resultset *ctx, const size_t *cols,
+                        const PCR_RESULTSET_AGG *aggs, size_t len,
+                        const pcr_vector *sel, pcr_exception ex);
+
 
 /**************************************************************************//**
  * @defgroup pcr_sql PCR SQL Module
@@ -1388,6 +1918,7 @@ pcr_sql_bound(const pcr_sql *ctx, pcr_exception ex);
  * @see pcr_sql_bind_int()
  * @see pcr_sql_bind_float()
  * @see pcr_sql_bind_text()
+ * @see pcr_sql_bind_blob()
  */
 extern pcr_hint_hot void
 pcr_sql_bind(pcr_sql **ctx, const pcr_attribute *attr, pcr_exception ex);
@@ -1487,6 +2018,31 @@ pcr_sql_bind_text(pcr_sql **ctx, const pcr_string *key, const pcr_string *value,
 }
 
 
+/**
+ * Bind blob parameter in SQL statement.
+ *
+ * The pcr_sql_bind_blob() interface function is an overloaded version of the
+ * pcr_sql_bind() interface function. This function binds the @p len bytes at
+ * @p data to a parameter @p key in an SQL statement @p ctx as a blob literal.
+ *
+ * @param ctx The contextual SQL statement instance.
+ * @param key The SQL parameter to bind.
+ * @param data The bytes to bind.
+ * @param len The number of bytes to bind.
+ * @param ex The exception stack.
+ *
+ * @note This function is simply a convenience wrapper around pcr_sql_bind().
+ *
+ * @see pcr_sql_bind()
+ */
+inline void
+pcr_sql_bind_blob(pcr_sql **ctx, const pcr_string *key, const void *data,
+                  size_t len, pcr_exception ex)
+{
+    pcr_sql_bind(ctx, pcr_attribute_new_blob(key, data, len, ex), ex);
+}
+
+
 /**
  * Reset SQL statement.
  *
@@ -1542,6 +2098,47 @@ extern void
 pcr_dbase_rollback(pcr_dbase *ctx, pcr_exception ex);
 
 
+/******************************************************************************
+ * INTERFACE: pcr_cursor
+ */
+
+typedef struct pcr_cursor pcr_cursor;
+
+extern pcr_cursor *
+pcr_dbase_open_cursor(const pcr_dbase *ctx, const pcr_sql *sql,
+                      pcr_exception ex);
+
+extern bool
+pcr_cursor_next(pcr_cursor *ctx, pcr_exception ex);
+
+extern size_t
+pcr_cursor_cols(const pcr_cursor *ctx, pcr_exception ex);
+
+extern const pcr_string *
+pcr_cursor_key(const pcr_cursor *ctx, size_t col, pcr_exception ex);
+
+extern PCR_ATTRIBUTE
+pcr_cursor_type(const pcr_cursor *ctx, size_t col, pcr_exception ex);
+
+extern int64_t
+pcr_cursor_int(const pcr_cursor *ctx, size_t col, pcr_exception ex);
+
+extern double
+pcr_cursor_float(const pcr_cursor *ctx, size_t col, pcr_exception ex);
+
+extern const pcr_string *
+pcr_cursor_text(const pcr_cursor *ctx, size_t col, pcr_exception ex);
+
+extern pcr_blob
+pcr_cursor_blob(const pcr_cursor *ctx, size_t col, pcr_exception ex);
+
+extern pcr_attribute *
+pcr_cursor_attrib(const pcr_cursor *ctx, size_t col, pcr_exception ex);
+
+extern void
+pcr_cursor_close(pcr_cursor *ctx);
+
+
 /* Lua Script */
 
 typedef struct pcr_lua pcr_lua;
@@ -1,9 +1,19 @@
+#include <math.h>
 #include <string.h>
 #include "./api.h"
 
 
+/* Define the pcr_attribute struct. Integer and floating point values are held
+ * inline in the @value union, and only text and blob data live on the heap;
+ * this way numeric attributes cost a single allocation, and can be read
+ * without any. */
 struct pcr_attribute {
-    void *value;
+    union {
+        int64_t i;        /* PCR_ATTRIBUTE_INT value   */
+        double f;         /* PCR_ATTRIBUTE_FLOAT value */
+        pcr_string *text; /* PCR_ATTRIBUTE_TEXT value  */
+        pcr_blob blob;    /* PCR_ATTRIBUTE_BLOB value  */
+    } value;
     pcr_string *key;
     PCR_ATTRIBUTE type;
 };
@@ -25,6 +35,10 @@ static size_t value_size(PCR_ATTRIBUTE type, const void *value,
             return pcr_string_sz((pcr_string *) value, ex);
             break;
 
+        case PCR_ATTRIBUTE_BLOB:
+            return sizeof (pcr_blob);
+            break;
+
         default:
             return 0;
             break;
@@ -32,6 +46,51 @@ static size_t value_size(PCR_ATTRIBUTE type, const void *value,
 }
 
 
+/* Define the value_ref() helper function. This function returns a pointer to
+ * the bytes of the value of @ctx, in the same form as the @value argument of
+ * pcr_attribute_new(). */
+static inline const void *
+value_ref(const pcr_attribute *ctx)
+{
+    switch (ctx->type) {
+        case PCR_ATTRIBUTE_INT: return &ctx->value.i; break;
+        case PCR_ATTRIBUTE_FLOAT: return &ctx->value.f; break;
+        case PCR_ATTRIBUTE_TEXT: return ctx->value.text; break;
+        case PCR_ATTRIBUTE_BLOB: return &ctx->value.blob; break;
+        default: return NULL; break;
+    }
+}
+
+
+/* Define the blob_copy() helper function. This function makes a hard copy of
+ * the data of the blob @value. */
+static pcr_blob *
+blob_copy(const pcr_blob *value, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_blob *copy = pcr_mempool_alloc(sizeof *copy, x);
+        copy->len = value->len;
+        copy->data = NULL;
+
+        if (pcr_hint_likely (value->len)) {
+            pcr_assert_handle(value->data, x);
+
+            void *data = pcr_mempool_alloc(value->len, x);
+            memcpy(data, value->data, value->len);
+            copy->data = data;
+        }
+
+        return copy;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_attribute_new() interface function. Only the key and the
+ * text or blob data need to be copied, since numeric values are stored
+ * inline. */
 extern pcr_attribute *
 pcr_attribute_new(PCR_ATTRIBUTE type, const pcr_string *key, const void *value,
                   pcr_exception ex)
@@ -40,17 +99,49 @@ pcr_attribute_new(PCR_ATTRIBUTE type, const pcr_string *key, const void *value,
     if (pcr_hint_likely (type != PCR_ATTRIBUTE_NULL))
         pcr_assert_handle(value, ex);
 
+    pcr_exception_try (x) {
+        void *copy = (void *) value;
+
+        if (type == PCR_ATTRIBUTE_TEXT)
+            copy = pcr_string_copy(value, x);
+        else if (type == PCR_ATTRIBUTE_BLOB)
+            copy = blob_copy(value, x);
+
+        return pcr_attribute_new_take(type, pcr_string_copy(key, x), copy, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_attribute_new_take() interface function. The attribute
+ * adopts @key, a text @value and the data of a blob @value as they are instead
+ * of copying them, so the caller must not modify or release them after handing
+ * them over; numeric values and the blob descriptor are simply read into the
+ * attribute. */
+extern pcr_attribute *
+pcr_attribute_new_take(PCR_ATTRIBUTE type, pcr_string *key, void *value,
+                       pcr_exception ex)
+{
+    pcr_assert_string(key, ex);
+    if (pcr_hint_likely (type != PCR_ATTRIBUTE_NULL))
+        pcr_assert_handle(value, ex);
+
     pcr_exception_try (x) {
         pcr_attribute *ctx = pcr_mempool_alloc(sizeof *ctx, x);
 
         ctx->type = type;
-        ctx->key = pcr_string_copy(key, x);
+        ctx->key = key;
 
-        size_t sz = value_size(type, value, x);
-        if (pcr_hint_likely (sz)) {
-            ctx->value = pcr_mempool_alloc(sz, x);
-            memcpy(ctx->value, value, sz);
-        }
+        if (type == PCR_ATTRIBUTE_INT)
+            ctx->value.i = *((int64_t *) value);
+        else if (type == PCR_ATTRIBUTE_FLOAT)
+            ctx->value.f = *((double *) value);
+        else if (type == PCR_ATTRIBUTE_TEXT)
+            ctx->value.text = value;
+        else if (type == PCR_ATTRIBUTE_BLOB)
+            ctx->value.blob = *((pcr_blob *) value);
 
         return ctx;
     }
@@ -97,11 +188,11 @@ pcr_attribute_value(const pcr_attribute *ctx, pcr_exception ex)
 
     pcr_exception_try (x) {
         void *value = NULL;
-        size_t sz = value_size(ctx->type, ctx->value, x);
+        size_t sz = value_size(ctx->type, value_ref(ctx), x);
 
         if (pcr_hint_likely (sz)) {
             value = pcr_mempool_alloc(sz, x);
-            memcpy(value, ctx->value, sz);
+            memcpy(value, value_ref(ctx), sz);
         }
 
         return value;
@@ -112,13 +203,65 @@ pcr_attribute_value(const pcr_attribute *ctx, pcr_exception ex)
 }
 
 
+/* Implement the pcr_attribute_int() interface function. */
+extern int64_t
+pcr_attribute_int(const pcr_attribute *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_state(ctx->type == PCR_ATTRIBUTE_INT, ex);
+
+    return ctx->value.i;
+}
+
+
+/* Implement the pcr_attribute_float() interface function. */
+extern double
+pcr_attribute_float(const pcr_attribute *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_state(ctx->type == PCR_ATTRIBUTE_FLOAT, ex);
+
+    return ctx->value.f;
+}
+
+
+/* Implement the pcr_attribute_text_ref() interface function. The text held by
+ * the attribute is returned as-is, and since attributes are never modified in
+ * place it stays valid for as long as the caller holds on to it. */
+extern const pcr_string *
+pcr_attribute_text_ref(const pcr_attribute *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_state(ctx->type == PCR_ATTRIBUTE_TEXT, ex);
+
+    return ctx->value.text;
+}
+
+
+/* Implement the pcr_attribute_blob() interface function. The descriptor is
+ * returned by value, and its data is shared with the attribute. */
+extern pcr_blob
+pcr_attribute_blob(const pcr_attribute *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_state(ctx->type == PCR_ATTRIBUTE_BLOB, ex);
+
+    return ctx->value.blob;
+}
+
+
+/* Implement the pcr_attribute_valuesz() interface function. The size of a blob
+ * is the length of its data rather than that of its descriptor. */
 extern size_t
 pcr_attribute_valuesz(const pcr_attribute *ctx, pcr_exception ex)
 {
     pcr_assert_handle(ctx, ex);
 
+    if (ctx->type == PCR_ATTRIBUTE_BLOB)
+        return ctx->value.blob.len;
+
     pcr_exception_try (x) {
-        return value_size(ctx->type, ctx->value, x);
+        return value_size(ctx->type, value_ref(ctx), x);
     }
 
     pcr_exception_unwind(ex);
@@ -126,6 +269,31 @@ pcr_attribute_valuesz(const pcr_attribute *ctx, pcr_exception ex)
 }
 
 
+/* Define the blob_hex() helper function. This function returns the data of the
+ * blob @value as a string of hexadecimal digits, two per byte. */
+static pcr_string *
+blob_hex(const pcr_blob *value, pcr_exception ex)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    pcr_exception_try (x) {
+        const unsigned char *data = value->data;
+        pcr_string *hex = pcr_mempool_alloc(value->len * 2 + 1, x);
+
+        for (register size_t i = 0; i < value->len; i++) {
+            hex[i * 2] = digits[data[i] >> 4];
+            hex[i * 2 + 1] = digits[data[i] & 0xf];
+        }
+
+        hex[value->len * 2] = '\0';
+        return hex;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
 extern pcr_string *
 pcr_attribute_string(const pcr_attribute *ctx, pcr_exception ex)
 {
@@ -134,17 +302,19 @@ pcr_attribute_string(const pcr_attribute *ctx, pcr_exception ex)
     pcr_exception_try (x) {
         switch (ctx->type) {
             case PCR_ATTRIBUTE_INT:
-                pcr_assert_handle(ctx->value, x);
-                return pcr_string_int(*((int64_t *) ctx->value), x);
+                return pcr_string_int(ctx->value.i, x);
                 break;
 
             case PCR_ATTRIBUTE_FLOAT:
-                pcr_assert_handle(ctx->value, x);
-                return pcr_string_float(*((double *) ctx->value), x);
+                return pcr_string_float(ctx->value.f, x);
                 break;
 
             case PCR_ATTRIBUTE_TEXT:
-                return pcr_string_copy((pcr_string *) ctx->value, x);
+                return pcr_string_copy(ctx->value.text, x);
+                break;
+
+            case PCR_ATTRIBUTE_BLOB:
+                return blob_hex(&ctx->value.blob, x);
                 break;
 
             default:
@@ -178,139 +348,826 @@ pcr_attribute_json(const pcr_attribute *ctx, pcr_exception ex)
 }
 
 
+/* Implement the pcr_attribute_json_write() interface function. Unlike
+ * pcr_attribute_json(), the value is written as its native JSON type, and the
+ * key and text are escaped; nothing is allocated other than by @writer. Blobs
+ * have no JSON type, and so are written as strings of hexadecimal digits. */
+extern void
+pcr_attribute_json_write(const pcr_attribute *ctx, pcr_json_writer *writer,
+                         pcr_exception ex)
+{
+    pcr_assert_handle(ctx && writer, ex);
+
+    pcr_exception_try (x) {
+        pcr_json_writer_text(writer, ctx->key, strlen(ctx->key), x);
+        pcr_json_writer_raw(writer, ":", 1, x);
+
+        switch (ctx->type) {
+            case PCR_ATTRIBUTE_INT:
+                pcr_json_writer_int(writer, ctx->value.i, x);
+                break;
+
+            case PCR_ATTRIBUTE_FLOAT:
+                pcr_json_writer_float(writer, ctx->value.f, x);
+                break;
+
+            case PCR_ATTRIBUTE_TEXT:
+                pcr_json_writer_text(writer, ctx->value.text,
+                                     strlen(ctx->value.text), x);
+                break;
+
+            case PCR_ATTRIBUTE_BLOB: {
+                pcr_string *hex = blob_hex(&ctx->value.blob, x);
+                pcr_json_writer_text(writer, hex, ctx->value.blob.len * 2, x);
+                break;
+            }
+
+            default:
+                pcr_json_writer_null(writer, x);
+                break;
+        }
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
 /*******************************************************************************
- * pcr_attribute Inline Declarations
+ * Comparison and Hashing
+ *
+ * Attributes are compared by value, ignoring their keys, in the same order as
+ * SQLite sorts values: NULL first, then numbers, then text, and then blobs.
+ * Integers and floating point numbers are compared with each other by their
+ * numeric values, text is compared bytewise (the BINARY collation), and blobs
+ * are compared bytewise with shorter prefixes first. Unlike in SQL expressions,
+ * NULL compares equal to NULL, as it does in GROUP BY and DISTINCT; likewise,
+ * NaN compares equal to NaN and less than any other number. Attributes that
+ * compare equal hash equal, so that for example 3 and 3.0 fall into the same
+ * group.
  */
 
 
-extern inline pcr_attribute *
-pcr_attribute_new_null(const pcr_string *key, pcr_exception ex);
+/* Implement the pcr_attribute_rank__() private helper function. This function
+ * returns the rank of the storage class of @type in the sort order; like
+ * pcr_attribute_cmp_f64__(), it is shared with pcr_resultset. */
+extern int
+pcr_attribute_rank__(PCR_ATTRIBUTE type)
+{
+    switch (type) {
+        case PCR_ATTRIBUTE_INT: return 1; break;
+        case PCR_ATTRIBUTE_FLOAT: return 1; break;
+        case PCR_ATTRIBUTE_TEXT: return 2; break;
+        case PCR_ATTRIBUTE_BLOB: return 3; break;
+        default: return 0; break;
+    }
+}
 
 
-extern inline pcr_attribute *
-pcr_attribute_new_int(const pcr_string *key, int64_t value, pcr_exception ex);
+/* Implement the pcr_attribute_cmp_f64__() private helper function. This
+ * function compares two floating point numbers, with NaN ordered before every
+ * other number; it is shared with pcr_resultset so that it compares cells in
+ * the same way. */
+extern int
+pcr_attribute_cmp_f64__(double lhs, double rhs)
+{
+    if (pcr_hint_unlikely (isnan(lhs) || isnan(rhs)))
+        return !isnan(lhs) - !isnan(rhs);
 
+    return (lhs > rhs) - (lhs < rhs);
+}
 
-extern inline pcr_attribute *
-pcr_attribute_new_int_2(const pcr_string *key, pcr_exception ex);
 
+/* Implement the pcr_attribute_cmp_i64_f64__() private helper function. This
+ * function compares an integer @lhs with a floating point number @rhs exactly;
+ * simply converting @lhs to a double would lose precision for magnitudes above
+ * 2^53. */
+extern int
+pcr_attribute_cmp_i64_f64__(int64_t lhs, double rhs)
+{
+    if (pcr_hint_unlikely (isnan(rhs)))
+        return 1;
+    if (rhs >= 9223372036854775808.0)
+        return -1;
+    if (rhs < -9223372036854775808.0)
+        return 1;
+
+    int64_t whole = (int64_t) rhs;
+    if (lhs != whole)
+        return (lhs > whole) - (lhs < whole);
+
+    double frac = rhs - (double) whole;
+    return (frac < 0.0) - (frac > 0.0);
+}
 
-extern inline pcr_attribute *
-pcr_attribute_new_float(const pcr_string *key, double value, pcr_exception ex);
 
+/* Define the cmp_attrib() helper function. This function compares the values
+ * of @lhs and @rhs, neither of which may be null; it never throws, and so can
+ * back comparators that have no exception handle to throw to. */
+static int
+cmp_attrib(const pcr_attribute *lhs, const pcr_attribute *rhs)
+{
+    int lrank = pcr_attribute_rank__(lhs->type);
+    int rrank = pcr_attribute_rank__(rhs->type);
+    if (lrank != rrank)
+        return (lrank > rrank) - (lrank < rrank);
 
-extern inline pcr_attribute *
-pcr_attribute_new_float_2(const pcr_string *key, pcr_exception ex);
+    switch (lhs->type) {
+        case PCR_ATTRIBUTE_INT:
+            if (rhs->type == PCR_ATTRIBUTE_FLOAT)
+                return pcr_attribute_cmp_i64_f64__(lhs->value.i, rhs->value.f);
 
+            return (lhs->value.i > rhs->value.i)
+                   - (lhs->value.i < rhs->value.i);
+            break;
 
-extern inline pcr_attribute *
-pcr_attribute_new_text(const pcr_string *key, const pcr_string *value,
-                       pcr_exception ex);
+        case PCR_ATTRIBUTE_FLOAT:
+            if (rhs->type == PCR_ATTRIBUTE_INT)
+                return -pcr_attribute_cmp_i64_f64__(rhs->value.i, lhs->value.f);
 
+            return pcr_attribute_cmp_f64__(lhs->value.f, rhs->value.f);
+            break;
 
-extern inline pcr_attribute *
-pcr_attribute_new_text_2(const pcr_string *key, pcr_exception ex);
+        case PCR_ATTRIBUTE_TEXT: {
+            int cmp = strcmp(lhs->value.text, rhs->value.text);
+            return (cmp > 0) - (cmp < 0);
+            break;
+        }
+
+        case PCR_ATTRIBUTE_BLOB: {
+            size_t llen = lhs->value.blob.len, rlen = rhs->value.blob.len;
+            size_t len = llen < rlen ? llen : rlen;
+
+            int cmp = len ? memcmp(lhs->value.blob.data, rhs->value.blob.data,
+                                   len) : 0;
+            if (cmp)
+                return (cmp > 0) - (cmp < 0);
+
+            return (llen > rlen) - (llen < rlen);
+            break;
+        }
+
+        default:
+            return 0;
+            break;
+    }
+}
+
+
+/* Implement the pcr_attribute_cmp() interface function. */
+extern int
+pcr_attribute_cmp(const pcr_attribute *lhs, const pcr_attribute *rhs,
+                  pcr_exception ex)
+{
+    pcr_assert_handle(lhs && rhs, ex);
+    return cmp_attrib(lhs, rhs);
+}
+
+
+/* Define the hash_i64() helper function. This function hashes an integer; it
+ * is also used for floating point numbers with integral values, so that they
+ * hash the same as the equal integers. */
+static inline uint64_t
+hash_i64(int64_t val)
+{
+    return pcr_map_hash__(&val, sizeof val);
+}
+
+
+/* Implement the pcr_attribute_hash() interface function. The storage class is
+ * mixed into the hash of text and blobs, so that equal bytes in the two don't
+ * collide. */
+extern uint64_t
+pcr_attribute_hash(const pcr_attribute *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+
+    switch (ctx->type) {
+        case PCR_ATTRIBUTE_INT:
+            return hash_i64(ctx->value.i);
+            break;
+
+        case PCR_ATTRIBUTE_FLOAT: {
+            double val = ctx->value.f;
+
+            if (pcr_hint_unlikely (isnan(val)))
+                return 0x7FF8000000000000ULL;
+
+            if (val >= -9223372036854775808.0 && val < 9223372036854775808.0
+                && val == (double) (int64_t) val)
+                return hash_i64((int64_t) val);
+
+            return pcr_map_hash__(&val, sizeof val);
+            break;
+        }
+
+        case PCR_ATTRIBUTE_TEXT:
+            return pcr_map_hash__(ctx->value.text, strlen(ctx->value.text))
+                   ^ 0x9E3779B97F4A7C15ULL;
+            break;
+
+        case PCR_ATTRIBUTE_BLOB:
+            return pcr_map_hash__(ctx->value.blob.data, ctx->value.blob.len)
+                   ^ 0xC2B2AE3D27D4EB4FULL;
+            break;
+
+        default:
+            return 0;
+            break;
+    }
+}
+
+
+/* Implement the pcr_attribute_vector_cmp() interface function. The two columns
+ * are compared element by element into a vector of ints, each of which is the
+ * pcr_attribute_cmp() of the corresponding attributes. */
+extern pcr_vector *
+pcr_attribute_vector_cmp(const pcr_attribute_vector *lhs,
+                         const pcr_attribute_vector *rhs, pcr_exception ex)
+{
+    pcr_assert_handle(lhs && rhs, ex);
+    pcr_assert_range(lhs->len == rhs->len, ex);
+
+    pcr_exception_try (x) {
+        const size_t len = pcr_attribute_vector_len(lhs, x);
+        pcr_vector *cmp = pcr_vector_new_2(sizeof (int), len ? len : 1, x);
+
+        pcr_attribute * const *larr = lhs->payload;
+        pcr_attribute * const *rarr = rhs->payload;
+        int *out = cmp->payload;
+
+        for (register size_t i = 0; i < len; i++)
+            out[i] = pcr_attribute_cmp(larr[i], rarr[i], x);
+
+        cmp->len = len;
+        return cmp;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_attribute_vector_hash() interface function. The column is
+ * hashed into a vector of uint64_t, one hash per attribute. */
+extern pcr_vector *
+pcr_attribute_vector_hash(const pcr_attribute_vector *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+
+    pcr_exception_try (x) {
+        const size_t len = pcr_attribute_vector_len(ctx, x);
+        pcr_vector *hash = pcr_vector_new_2(sizeof (uint64_t), len ? len : 1,
+                                            x);
+
+        pcr_attribute * const *arr = ctx->payload;
+        uint64_t *out = hash->payload;
+
+        for (register size_t i = 0; i < len; i++)
+            out[i] = pcr_attribute_hash(arr[i], x);
+
+        hash->len = len;
+        return hash;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Define the sort_comparator() helper function. This function adapts
+ * cmp_attrib() to the pcr_comparator signature; pcr_attribute_vector_sort()
+ * checks that no attribute is null beforehand, since the comparator has no way
+ * to throw. */
+static int
+sort_comparator(const void *ctx, const void *cmp)
+{
+    const pcr_attribute *lhs = *((pcr_attribute * const *) ctx);
+    const pcr_attribute *rhs = *((pcr_attribute * const *) cmp);
+
+    return cmp_attrib(lhs, rhs);
+}
+
+
+/* Implement the pcr_attribute_vector_sort() interface function. The sort is
+ * stable, so attributes with equal values keep their relative order. */
+extern void
+pcr_attribute_vector_sort(pcr_attribute_vector **ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx, ex);
+
+    pcr_attribute * const *arr = (*ctx)->payload;
+    for (register size_t i = 0; i < (*ctx)->len; i++)
+        pcr_assert_handle(arr[i], ex);
+
+    pcr_vector_sort_stable(ctx, &sort_comparator, ex);
+}
 
 
 /*******************************************************************************
- * PCR_ATTRIBUTE_VECTOR Inline Declarations
+ * Binary Encoding
+ *
+ * An encoded attribute is a version byte followed by the attribute body; an
+ * encoded attribute vector is a version byte, the number of attributes as a
+ * varint, and then the body of each attribute. The body of an attribute is its
+ * type tag byte and key followed by its value, where
+ *   - keys and text are a varint length, the bytes, and a terminating null
+ *     byte; the null byte is redundant, but it allows decoded strings to point
+ *     straight into the encoded buffer,
+ *   - integers are zigzag varints, so small magnitudes take few bytes,
+ *   - floating point numbers are their 8 IEEE 754 bytes in little endian order,
+ *   - blobs are a varint length and the bytes, and
+ *   - nulls have no value at all.
+ * Varints are little endian base 128, as in protocol buffers.
  */
 
 
-extern inline PCR_ATTRIBUTE_VECTOR *
-PCR_ATTRIBUTE_VECTOR_NEW(pcr_exception ex);
+/* Define the version of the binary encoding; this is bumped whenever the format
+ * changes, so that data cached by an older version is rejected rather than
+ * misread. */
+#define CODEC_VERSION 1
 
 
-extern inline PCR_ATTRIBUTE_VECTOR *
-PCR_ATTRIBUTE_VECTOR_NEW_2(const PCR_ATTRIBUTE *arr, size_t len,
-                           pcr_exception ex);
+/* Define the codec_varint_sz() helper function. This function returns the
+ * number of bytes taken by the varint encoding of @val. */
+static inline size_t
+codec_varint_sz(uint64_t val)
+{
+    size_t sz = 1;
+    while (val >= 0x80) {
+        val >>= 7;
+        sz++;
+    }
 
+    return sz;
+}
 
-extern inline PCR_ATTRIBUTE_VECTOR *
-PCR_ATTRIBUTE_VECTOR_COPY(const PCR_ATTRIBUTE_VECTOR *ctx, pcr_exception ex);
 
+/* Define the codec_varint() helper function. This function writes the varint
+ * encoding of @val at @out, and returns a pointer past it. */
+static inline unsigned char *
+codec_varint(unsigned char *out, uint64_t val)
+{
+    while (val >= 0x80) {
+        *out++ = (unsigned char) (val | 0x80);
+        val >>= 7;
+    }
 
-extern inline size_t
-PCR_ATTRIBUTE_VECTOR_LEN(const PCR_ATTRIBUTE_VECTOR *ctx, pcr_exception ex);
+    *out++ = (unsigned char) val;
+    return out;
+}
 
 
-extern inline size_t
-PCR_ATTRIBUTE_VECTOR_REFCOUNT(const PCR_ATTRIBUTE_VECTOR *ctx,
-                              pcr_exception ex);
+/* Define the codec_zigzag() and codec_unzigzag() helper functions. These
+ * functions map signed integers to unsigned ones so that values of small
+ * magnitude, whether positive or negative, have short varint encodings. */
+static inline uint64_t
+codec_zigzag(int64_t val)
+{
+    return ((uint64_t) val << 1) ^ (uint64_t) (val >> 63);
+}
 
+static inline int64_t
+codec_unzigzag(uint64_t val)
+{
+    return (int64_t) (val >> 1) ^ -(int64_t) (val & 1);
+}
 
-extern inline PCR_ATTRIBUTE
-PCR_ATTRIBUTE_VECTOR_ELEM(const PCR_ATTRIBUTE_VECTOR *ctx, size_t idx,
-                          pcr_exception ex);
+
+/* Define the codec_size() helper function. This function returns the number of
+ * bytes taken by the body of the encoding of @ctx. */
+static size_t
+codec_size(const pcr_attribute *ctx)
+{
+    size_t klen = strlen(ctx->key);
+    size_t sz = 1 + codec_varint_sz(klen) + klen + 1;
+
+    switch (ctx->type) {
+        case PCR_ATTRIBUTE_INT:
+            return sz + codec_varint_sz(codec_zigzag(ctx->value.i));
+            break;
+
+        case PCR_ATTRIBUTE_FLOAT:
+            return sz + sizeof (uint64_t);
+            break;
+
+        case PCR_ATTRIBUTE_TEXT: {
+            size_t tlen = strlen(ctx->value.text);
+            return sz + codec_varint_sz(tlen) + tlen + 1;
+            break;
+        }
+
+        case PCR_ATTRIBUTE_BLOB:
+            return sz + codec_varint_sz(ctx->value.blob.len)
+                   + ctx->value.blob.len;
+            break;
+
+        default:
+            return sz;
+            break;
+    }
+}
 
 
-extern inline void
-PCR_ATTRIBUTE_VECTOR_ELEM_SET(PCR_ATTRIBUTE_VECTOR **ctx, size_t idx,
-                              PCR_ATTRIBUTE elem, pcr_exception ex);
+/* Define the codec_text() and codec_bytes() helper functions. These functions
+ * write the encoding of the string @str or of the @len bytes at @data to @out,
+ * and return a pointer past it. */
+static inline unsigned char *
+codec_text(unsigned char *out, const pcr_string *str)
+{
+    size_t len = strlen(str);
 
+    out = codec_varint(out, len);
+    memcpy(out, str, len + 1);
 
-extern inline void
-PCR_ATTRIBUTE_VECTOR_PUSH(PCR_ATTRIBUTE_VECTOR **ctx, PCR_ATTRIBUTE elem,
-                          pcr_exception ex);
+    return out + len + 1;
+}
 
+static inline unsigned char *
+codec_bytes(unsigned char *out, const void *data, size_t len)
+{
+    out = codec_varint(out, len);
+    if (len)
+        memcpy(out, data, len);
 
-extern inline void
-PCR_ATTRIBUTE_VECTOR_ITERATE(const PCR_ATTRIBUTE_VECTOR *ctx, pcr_iterator *itr,
-                             void *opt, pcr_exception ex);
+    return out + len;
+}
 
 
-extern inline void
-PCR_ATTRIBUTE_VECTOR_MUTERATE(PCR_ATTRIBUTE_VECTOR **ctx, pcr_muterator *mtr,
-                              void *opt, pcr_exception ex);
+/* Define the codec_write() helper function. This function writes the body of
+ * the encoding of @ctx to @out, and returns a pointer past it. */
+static unsigned char *
+codec_write(const pcr_attribute *ctx, unsigned char *out)
+{
+    *out++ = (unsigned char) ctx->type;
+    out = codec_text(out, ctx->key);
+
+    switch (ctx->type) {
+        case PCR_ATTRIBUTE_INT:
+            return codec_varint(out, codec_zigzag(ctx->value.i));
+            break;
+
+        case PCR_ATTRIBUTE_FLOAT: {
+            uint64_t bits;
+            memcpy(&bits, &ctx->value.f, sizeof bits);
+
+            for (register size_t i = 0; i < sizeof bits; i++)
+                *out++ = (unsigned char) (bits >> (i * 8));
+
+            return out;
+            break;
+        }
+
+        case PCR_ATTRIBUTE_TEXT:
+            return codec_text(out, ctx->value.text);
+            break;
+
+        case PCR_ATTRIBUTE_BLOB:
+            return codec_bytes(out, ctx->value.blob.data, ctx->value.blob.len);
+            break;
+
+        default:
+            return out;
+            break;
+    }
+}
+
+
+/* Define the codec_cursor struct. This tracks the position of a decoder within
+ * an encoded buffer. */
+struct codec_cursor {
+    const unsigned char *pos;
+    const unsigned char *end;
+};
+
+
+/* Define the codec_span() helper function. This function returns the next @len
+ * bytes of the buffer being decoded by @cur, and moves past them; the buffer
+ * must have at least @len bytes left. */
+static const unsigned char *
+codec_span(struct codec_cursor *cur, size_t len, pcr_exception ex)
+{
+    pcr_assert_parse(len <= (size_t) (cur->end - cur->pos), ex);
+
+    const unsigned char *span = cur->pos;
+    cur->pos += len;
+
+    return span;
+}
+
+
+/* Define the codec_read_varint() helper function. This function decodes the
+ * next varint from @cur. The tenth byte holds only the top bit of the value,
+ * so anything more in it is an overflow. */
+static uint64_t
+codec_read_varint(struct codec_cursor *cur, pcr_exception ex)
+{
+    uint64_t val = 0;
+
+    for (register unsigned shift = 0; shift < 64; shift += 7) {
+        pcr_assert_parse(cur->pos < cur->end, ex);
+
+        unsigned char byte = *cur->pos++;
+        pcr_assert_parse(shift < 63 || byte <= 1, ex);
+
+        val |= (uint64_t) (byte & 0x7f) << shift;
+
+        if (!(byte & 0x80))
+            return val;
+    }
+
+    pcr_exception_throw(ex, PCR_EXCEPTION_PARSE);
+    return 0;
+}
+
+
+/* Define the codec_read_text() helper function. This function decodes the next
+ * string from @cur. If @ref is set, the string is returned in place within the
+ * buffer; otherwise, a copy of it is returned. */
+static pcr_string *
+codec_read_text(struct codec_cursor *cur, bool ref, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        size_t len = codec_read_varint(cur, x);
+        pcr_assert_parse(len < (size_t) (cur->end - cur->pos), x);
+
+        const unsigned char *span = codec_span(cur, len + 1, x);
+        pcr_assert_parse(!span[len], x);
+
+        if (ref)
+            return (pcr_string *) span;
+
+        pcr_string *str = pcr_mempool_alloc(len + 1, x);
+        memcpy(str, span, len + 1);
+
+        return str;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Define the codec_read() helper function. This function decodes the next
+ * attribute body from @cur, with its key and any text or blob data either in
+ * place within the buffer if @ref is set, or copied otherwise. */
+static pcr_attribute *
+codec_read(struct codec_cursor *cur, bool ref, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        PCR_ATTRIBUTE type = (PCR_ATTRIBUTE) *codec_span(cur, 1, x);
+        pcr_assert_parse(type <= PCR_ATTRIBUTE_BLOB, x);
+
+        pcr_string *key = codec_read_text(cur, ref, x);
+
+        switch (type) {
+            case PCR_ATTRIBUTE_INT: {
+                int64_t val = codec_unzigzag(codec_read_varint(cur, x));
+                return pcr_attribute_new_take(type, key, &val, x);
+                break;
+            }
+
+            case PCR_ATTRIBUTE_FLOAT: {
+                const unsigned char *span = codec_span(cur, sizeof (uint64_t),
+                                                       x);
+                uint64_t bits = 0;
+                double val;
+
+                for (register size_t i = 0; i < sizeof bits; i++)
+                    bits |= (uint64_t) span[i] << (i * 8);
+
+                memcpy(&val, &bits, sizeof val);
+                return pcr_attribute_new_take(type, key, &val, x);
+                break;
+            }
+
+            case PCR_ATTRIBUTE_TEXT:
+                return pcr_attribute_new_take(type, key,
+                                              codec_read_text(cur, ref, x), x);
+                break;
+
+            case PCR_ATTRIBUTE_BLOB: {
+                pcr_blob val = {.len = codec_read_varint(cur, x)};
+                val.data = codec_span(cur, val.len, x);
+
+                if (!ref && val.len) {
+                    void *data = pcr_mempool_alloc(val.len, x);
+                    memcpy(data, val.data, val.len);
+                    val.data = data;
+                }
+
+                return pcr_attribute_new_take(type, key, &val, x);
+                break;
+            }
+
+            default:
+                return pcr_attribute_new_take(type, key, NULL, x);
+                break;
+        }
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Define the codec_decode() helper function. This function decodes the single
+ * attribute encoded in @bfr, which must hold nothing else. */
+static pcr_attribute *
+codec_decode(pcr_blob bfr, bool ref, pcr_exception ex)
+{
+    pcr_assert_handle(bfr.data || !bfr.len, ex);
+
+    pcr_exception_try (x) {
+        struct codec_cursor cur = {bfr.data, (const unsigned char *) bfr.data
+                                             + bfr.len};
+        pcr_assert_parse(*codec_span(&cur, 1, x) == CODEC_VERSION, x);
+
+        pcr_attribute *attr = codec_read(&cur, ref, x);
+        pcr_assert_parse(cur.pos == cur.end, x);
+
+        return attr;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_attribute_encode() interface function. The exact size of
+ * the encoding is worked out first, so that it is written in one go into a
+ * single allocation. */
+extern pcr_blob
+pcr_attribute_encode(const pcr_attribute *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+
+    pcr_exception_try (x) {
+        pcr_blob bfr = {.len = 1 + codec_size(ctx)};
+        unsigned char *out = pcr_mempool_alloc(bfr.len, x);
+
+        *out = CODEC_VERSION;
+        (void) codec_write(ctx, out + 1);
+
+        bfr.data = out;
+        return bfr;
+    }
+
+    pcr_exception_unwind(ex);
+    return (pcr_blob) {0};
+}
+
+
+/* Implement the pcr_attribute_decode() interface function. */
+extern pcr_attribute *
+pcr_attribute_decode(pcr_blob bfr, pcr_exception ex)
+{
+    return codec_decode(bfr, false, ex);
+}
+
+
+/* Implement the pcr_attribute_decode_ref() interface function. The key and any
+ * text or blob data of the decoded attribute point straight into @bfr, which
+ * must therefore outlive it and not be modified. */
+extern pcr_attribute *
+pcr_attribute_decode_ref(pcr_blob bfr, pcr_exception ex)
+{
+    return codec_decode(bfr, true, ex);
+}
+
+
+/* Define the codec_decode_vector() helper function. This function decodes the
+ * attribute vector encoded in @bfr, which must hold nothing else. */
+static pcr_attribute_vector *
+codec_decode_vector(pcr_blob bfr, bool ref, pcr_exception ex)
+{
+    pcr_assert_handle(bfr.data || !bfr.len, ex);
+
+    pcr_exception_try (x) {
+        struct codec_cursor cur = {bfr.data, (const unsigned char *) bfr.data
+                                             + bfr.len};
+        pcr_assert_parse(*codec_span(&cur, 1, x) == CODEC_VERSION, x);
+
+        /* each attribute takes at least 3 bytes, which bounds a valid length,
+         * and so a corrupt one can't trigger a huge allocation */
+        size_t len = codec_read_varint(&cur, x);
+        pcr_assert_parse(len <= (size_t) (cur.end - cur.pos) / 3, x);
+
+        pcr_attribute_vector *vec = pcr_vector_new_2(sizeof (pcr_attribute *),
+                                                     len ? len : 1, x);
+        for (register size_t i = 0; i < len; i++)
+            pcr_attribute_vector_push_take(&vec, codec_read(&cur, ref, x), x);
+
+        pcr_assert_parse(cur.pos == cur.end, x);
+        return vec;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_attribute_vector_encode() interface function. */
+extern pcr_blob
+pcr_attribute_vector_encode(const pcr_attribute_vector *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+
+    pcr_exception_try (x) {
+        size_t len = pcr_attribute_vector_len(ctx, x);
+        pcr_attribute * const *arr = ctx->payload;
+
+        pcr_blob bfr = {.len = 1 + codec_varint_sz(len)};
+        for (register size_t i = 0; i < len; i++)
+            bfr.len += codec_size(arr[i]);
+
+        unsigned char *out = pcr_mempool_alloc(bfr.len, x);
+        bfr.data = out;
+
+        *out++ = CODEC_VERSION;
+        out = codec_varint(out, len);
+        for (register size_t i = 0; i < len; i++)
+            out = codec_write(arr[i], out);
+
+        return bfr;
+    }
+
+    pcr_exception_unwind(ex);
+    return (pcr_blob) {0};
+}
+
+
+/* Implement the pcr_attribute_vector_decode() interface function. */
+extern pcr_attribute_vector *
+pcr_attribute_vector_decode(pcr_blob bfr, pcr_exception ex)
+{
+    return codec_decode_vector(bfr, false, ex);
+}
+
+
+/* Implement the pcr_attribute_vector_decode_ref() interface function. As with
+ * pcr_attribute_decode_ref(), the decoded attributes point into @bfr. */
+extern pcr_attribute_vector *
+pcr_attribute_vector_decode_ref(pcr_blob bfr, pcr_exception ex)
+{
+    return codec_decode_vector(bfr, true, ex);
+}
 
 
 /*******************************************************************************
- * pcr_attribute_vector Inline Declarations
+ * pcr_attribute Inline Declarations
  */
 
 
-extern inline pcr_attribute_vector *
-pcr_attribute_vector_new(pcr_exception ex);
+extern inline pcr_attribute *
+pcr_attribute_new_null(const pcr_string *key, pcr_exception ex);
 
 
-extern inline pcr_attribute_vector *
-pcr_attribute_vector_new_2(const pcr_attribute **arr, size_t len,
-                           pcr_exception ex);
+extern inline pcr_attribute *
+pcr_attribute_new_int(const pcr_string *key, int64_t value, pcr_exception ex);
 
 
-extern inline pcr_attribute_vector *
-pcr_attribute_vector_copy(const pcr_attribute_vector *ctx, pcr_exception ex);
+extern inline pcr_attribute *
+pcr_attribute_new_int_2(const pcr_string *key, pcr_exception ex);
 
 
-extern inline size_t
-pcr_attribute_vector_len(const pcr_attribute_vector *ctx, pcr_exception ex);
+extern inline pcr_attribute *
+pcr_attribute_new_float(const pcr_string *key, double value, pcr_exception ex);
+
+
+extern inline pcr_attribute *
+pcr_attribute_new_float_2(const pcr_string *key, pcr_exception ex);
+
+
+extern inline pcr_attribute *
+pcr_attribute_new_text(const pcr_string *key, const pcr_string *value,
+                       pcr_exception ex);
 
 
-extern inline size_t
-pcr_attribute_vector_refcount(const pcr_string_vector *ctx, pcr_exception ex);
+extern inline pcr_attribute *
+pcr_attribute_new_text_2(const pcr_string *key, pcr_exception ex);
 
 
 extern inline pcr_attribute *
-pcr_attribute_vector_elem(const pcr_attribute_vector *ctx, size_t idx,
-                          pcr_exception ex);
+pcr_attribute_new_text_take(pcr_string *key, pcr_string *value,
+                            pcr_exception ex);
 
 
-extern inline void
-pcr_attribute_vector_elem_set(pcr_attribute_vector **ctx, size_t idx,
-                              const pcr_attribute *elem, pcr_exception ex);
+extern inline pcr_attribute *
+pcr_attribute_new_blob(const pcr_string *key, const void *data, size_t len,
+                       pcr_exception ex);
 
 
-extern inline void
-pcr_attribute_vector_push(pcr_attribute_vector **ctx, const pcr_attribute *elem,
-                          pcr_exception ex);
+/*******************************************************************************
+ * PCR_ATTRIBUTE_VECTOR Inline Declarations
+ */
+
 
+PCR_VECTOR_EXTERN(PCR_ATTRIBUTE_VECTOR, PCR_ATTRIBUTE, PCR_ATTRIBUTE);
 
-extern inline void
-pcr_attribute_vector_iterate(const pcr_attribute_vector *ctx, pcr_iterator *itr,
-                             void *opt, pcr_exception ex);
 
+/*******************************************************************************
+ * pcr_attribute_vector Inline Declarations
+ */
 
-extern inline void
-pcr_attribute_vector_muterate(pcr_attribute_vector **ctx, pcr_muterator *mtr,
-                              void *opt, pcr_exception ex);
 
+PCR_VECTOR_EXTERN(pcr_attribute_vector, pcr_attribute *, const pcr_attribute *);
@@ -1,4 +1,5 @@
 #include <sqlite3.h>
+#include <string.h>
 #include "./api.h"
 
 
@@ -22,6 +23,36 @@ struct vtable {
 
     void
     (*rollback)(void *adapter, pcr_exception ex);
+
+    void *
+    (*cursor_open)(void *adapter, const pcr_sql *sql, pcr_exception ex);
+
+    bool
+    (*cursor_next)(void *stmt, pcr_exception ex);
+
+    size_t
+    (*cursor_cols)(void *stmt);
+
+    const pcr_string *
+    (*cursor_key)(void *stmt, size_t col);
+
+    PCR_ATTRIBUTE
+    (*cursor_type)(void *stmt, size_t col);
+
+    int64_t
+    (*cursor_int)(void *stmt, size_t col);
+
+    double
+    (*cursor_float)(void *stmt, size_t col);
+
+    const pcr_string *
+    (*cursor_text)(void *stmt, size_t col);
+
+    pcr_blob
+    (*cursor_blob)(void *stmt, size_t col);
+
+    void
+    (*cursor_close)(void *stmt);
 };
 
 
@@ -33,6 +64,18 @@ struct pcr_dbase {
 };
 
 
+/* Define the pcr_cursor struct; this structure was forward-declared in the API
+ * header file as an abstract data type. A cursor holds on to the prepared
+ * statement @stmt of its adapter until it is closed, and decodes a single row
+ * at a time; @row is set while the statement is positioned on a row. */
+struct pcr_cursor {
+    struct vtable *vtable;
+    void *stmt;
+    size_t cols;
+    bool row;
+};
+
+
 /******************************************************************************
  * Sqlite adapter helpers
  */
@@ -71,6 +114,7 @@ sqlite_col_type(sqlite3_stmt *stmt, int col)
         case SQLITE_INTEGER: return PCR_ATTRIBUTE_INT; break;
         case SQLITE_FLOAT: return PCR_ATTRIBUTE_FLOAT; break;
         case SQLITE_TEXT: return PCR_ATTRIBUTE_TEXT; break;
+        case SQLITE_BLOB: return PCR_ATTRIBUTE_BLOB; break;
         default: return PCR_ATTRIBUTE_NULL; break;
     }
 }
@@ -98,6 +142,27 @@ sqlite_col_value(sqlite3_stmt *stmt, int col, pcr_exception ex)
 
         else if (type == SQLITE_TEXT)
             val = pcr_string_new((char *) sqlite3_column_text(stmt, col), x);
+
+        else if (type == SQLITE_BLOB) {
+            /* the blob is only valid until the next step, so copy it here;
+             * this is the only copy, since the attribute adopts it */
+            pcr_blob blob = {
+                .data = sqlite3_column_blob(stmt, col),
+                .len = (size_t) sqlite3_column_bytes(stmt, col)
+            };
+
+            pcr_blob *bval = pcr_mempool_alloc(sizeof *bval, x);
+            bval->len = blob.len;
+            bval->data = NULL;
+
+            if (blob.len) {
+                void *data = pcr_mempool_alloc(blob.len, x);
+                memcpy(data, blob.data, blob.len);
+                bval->data = data;
+            }
+
+            val = bval;
+        }
     }
 
     pcr_exception_unwind(ex);
@@ -109,15 +174,13 @@ static pcr_resultset *
 sqlite_rs_init(sqlite3_stmt *stmt, pcr_exception ex)
 {
     pcr_exception_try (x) {
-        pcr_string_vector *keys = pcr_vector_new(sizeof (pcr_string), x);
-        PCR_ATTRIBUTE_VECTOR *types = pcr_vector_new(sizeof (PCR_ATTRIBUTE), x);
+        pcr_string_vector *keys = pcr_string_vector_new(x);
+        PCR_ATTRIBUTE_VECTOR *types = PCR_ATTRIBUTE_VECTOR_NEW(x);
 
-        PCR_ATTRIBUTE type;
         register int cols = sqlite3_column_count(stmt);
         for (register int i = 0; i < cols; i++) {
-            pcr_vector_push(&keys, sqlite_col_key(stmt, i), ex);
-            type = sqlite_col_type(stmt, i);
-            pcr_vector_push(&types, &type, ex);
+            pcr_string_vector_push(&keys, sqlite_col_key(stmt, i), x);
+            PCR_ATTRIBUTE_VECTOR_PUSH(&types, sqlite_col_type(stmt, i), x);
         }
 
         return pcr_resultset_new("resultset", keys, types, ex);
@@ -138,9 +201,9 @@ sqlite_rs_fill(pcr_resultset *rs, sqlite3_stmt *stmt, pcr_exception ex)
         pcr_attribute *attr;
         while (rc != SQLITE_DONE) {
             for (register int i = 0; i < cols; i++) {
-                attr = pcr_attribute_new(sqlite_col_type(stmt, i),
-                                         sqlite_col_key(stmt, i),
-                                         sqlite_col_value(stmt, i, x), x);
+                attr = pcr_attribute_new_take(sqlite_col_type(stmt, i),
+                            pcr_string_new(sqlite_col_key(stmt, i), x),
+                            sqlite_col_value(stmt, i, x), x);
                 pcr_resultset_push(&rs, attr, x);
             }
 
@@ -226,6 +289,85 @@ sqlite_rollback(void *adapter, pcr_exception ex)
 }
 
 
+static void *
+sqlite_cursor_open(void *adapter, const pcr_sql *sql, pcr_exception ex)
+{
+    return sqlite_stmt_init(adapter, sql, ex);
+}
+
+
+static bool
+sqlite_cursor_next(void *stmt, pcr_exception ex)
+{
+    int rc = sqlite3_step((sqlite3_stmt *) stmt);
+    pcr_assert_state(rc == SQLITE_ROW || rc == SQLITE_DONE, ex);
+
+    return rc == SQLITE_ROW;
+}
+
+
+static size_t
+sqlite_cursor_cols(void *stmt)
+{
+    return (size_t) sqlite3_column_count((sqlite3_stmt *) stmt);
+}
+
+
+static const pcr_string *
+sqlite_cursor_key(void *stmt, size_t col)
+{
+    return sqlite_col_key((sqlite3_stmt *) stmt, (int) col - 1);
+}
+
+
+static PCR_ATTRIBUTE
+sqlite_cursor_type(void *stmt, size_t col)
+{
+    return sqlite_col_type((sqlite3_stmt *) stmt, (int) col - 1);
+}
+
+
+static int64_t
+sqlite_cursor_int(void *stmt, size_t col)
+{
+    return sqlite3_column_int64((sqlite3_stmt *) stmt, (int) col - 1);
+}
+
+
+static double
+sqlite_cursor_float(void *stmt, size_t col)
+{
+    return sqlite3_column_double((sqlite3_stmt *) stmt, (int) col - 1);
+}
+
+
+static const pcr_string *
+sqlite_cursor_text(void *stmt, size_t col)
+{
+    return (const pcr_string *) sqlite3_column_text((sqlite3_stmt *) stmt,
+                                                    (int) col - 1);
+}
+
+
+/* the blob is owned by sqlite, and is only valid until the next step */
+static pcr_blob
+sqlite_cursor_blob(void *stmt, size_t col)
+{
+    return (pcr_blob) {
+        .data = sqlite3_column_blob((sqlite3_stmt *) stmt, (int) col - 1),
+        .len = (size_t) sqlite3_column_bytes((sqlite3_stmt *) stmt,
+                                             (int) col - 1)
+    };
+}
+
+
+static void
+sqlite_cursor_close(void *stmt)
+{
+    (void) sqlite3_finalize((sqlite3_stmt *) stmt);
+}
+
+
 static void
 sqlite_init(pcr_dbase *ctx, pcr_exception ex)
 {
@@ -239,6 +381,17 @@ sqlite_init(pcr_dbase *ctx, pcr_exception ex)
     ctx->vtable->commit = &sqlite_commit;
     ctx->vtable->query = &sqlite_query;
     ctx->vtable->rollback = &sqlite_rollback;
+
+    ctx->vtable->cursor_open = &sqlite_cursor_open;
+    ctx->vtable->cursor_next = &sqlite_cursor_next;
+    ctx->vtable->cursor_cols = &sqlite_cursor_cols;
+    ctx->vtable->cursor_key = &sqlite_cursor_key;
+    ctx->vtable->cursor_type = &sqlite_cursor_type;
+    ctx->vtable->cursor_int = &sqlite_cursor_int;
+    ctx->vtable->cursor_float = &sqlite_cursor_float;
+    ctx->vtable->cursor_text = &sqlite_cursor_text;
+    ctx->vtable->cursor_blob = &sqlite_cursor_blob;
+    ctx->vtable->cursor_close = &sqlite_cursor_close;
 }
 
 
@@ -350,3 +503,201 @@ pcr_dbase_rollback(pcr_dbase *ctx, pcr_exception ex)
     pcr_exception_unwind(ex);
 }
 
+
+/******************************************************************************
+ * pcr_cursor
+ */
+
+
+/* Define the cursor_finalize() helper function. This function is the finalizer
+ * of a cursor, and releases its statement if the cursor is collected without
+ * having been closed. */
+static void
+cursor_finalize(void *ptr, void *opt)
+{
+    (void) opt;
+    pcr_cursor_close(ptr);
+}
+
+
+/* Define the cursor_check() helper function. This function checks that @ctx is
+ * positioned on a row and that @col is one of its 1-based columns. */
+static inline void
+cursor_check(const pcr_cursor *ctx, size_t col, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_state(ctx->row, ex);
+    pcr_assert_range(col && col <= ctx->cols, ex);
+}
+
+
+/* Implement the pcr_dbase_open_cursor() interface function. The query is only
+ * prepared here; no rows are read until pcr_cursor_next() is called. */
+extern pcr_cursor *
+pcr_dbase_open_cursor(const pcr_dbase *ctx, const pcr_sql *sql,
+                      pcr_exception ex)
+{
+    pcr_assert_handle(ctx && sql, ex);
+
+    pcr_exception_try (x) {
+        pcr_cursor *cur = pcr_mempool_alloc(sizeof *cur, x);
+
+        cur->vtable = ctx->vtable;
+        cur->stmt = ctx->vtable->cursor_open(ctx->adapter, sql, x);
+        cur->cols = ctx->vtable->cursor_cols(cur->stmt);
+        cur->row = false;
+
+        pcr_mempool_finalize__(cur, &cursor_finalize, NULL);
+        return cur;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_cursor_next() interface function. The statement is
+ * released as soon as the last row has been read. */
+extern bool
+pcr_cursor_next(pcr_cursor *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+
+    if (pcr_hint_unlikely (!ctx->stmt))
+        return false;
+
+    pcr_exception_try (x) {
+        ctx->row = ctx->vtable->cursor_next(ctx->stmt, x);
+        if (!ctx->row)
+            pcr_cursor_close(ctx);
+
+        return ctx->row;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/* Implement the pcr_cursor_cols() interface function. */
+extern size_t
+pcr_cursor_cols(const pcr_cursor *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    return ctx->cols;
+}
+
+
+/* Implement the pcr_cursor_key() interface function. */
+extern const pcr_string *
+pcr_cursor_key(const pcr_cursor *ctx, size_t col, pcr_exception ex)
+{
+    cursor_check(ctx, col, ex);
+    return ctx->vtable->cursor_key(ctx->stmt, col);
+}
+
+
+/* Implement the pcr_cursor_type() interface function. The type is that of the
+ * value in the current row, since a column may hold values of any type. */
+extern PCR_ATTRIBUTE
+pcr_cursor_type(const pcr_cursor *ctx, size_t col, pcr_exception ex)
+{
+    cursor_check(ctx, col, ex);
+    return ctx->vtable->cursor_type(ctx->stmt, col);
+}
+
+
+/* Implement the pcr_cursor_int() interface function. */
+extern int64_t
+pcr_cursor_int(const pcr_cursor *ctx, size_t col, pcr_exception ex)
+{
+    pcr_assert_state(pcr_cursor_type(ctx, col, ex) == PCR_ATTRIBUTE_INT, ex);
+    return ctx->vtable->cursor_int(ctx->stmt, col);
+}
+
+
+/* Implement the pcr_cursor_float() interface function. */
+extern double
+pcr_cursor_float(const pcr_cursor *ctx, size_t col, pcr_exception ex)
+{
+    pcr_assert_state(pcr_cursor_type(ctx, col, ex) == PCR_ATTRIBUTE_FLOAT, ex);
+    return ctx->vtable->cursor_float(ctx->stmt, col);
+}
+
+
+/* Implement the pcr_cursor_text() interface function. The text is borrowed
+ * from the statement, and is only valid until the cursor moves on or is
+ * closed; it must be copied to be kept any longer. */
+extern const pcr_string *
+pcr_cursor_text(const pcr_cursor *ctx, size_t col, pcr_exception ex)
+{
+    pcr_assert_state(pcr_cursor_type(ctx, col, ex) == PCR_ATTRIBUTE_TEXT, ex);
+    return ctx->vtable->cursor_text(ctx->stmt, col);
+}
+
+
+/* Implement the pcr_cursor_blob() interface function. As with text, the data
+ * of the blob is borrowed and is valid only until the cursor moves on. */
+extern pcr_blob
+pcr_cursor_blob(const pcr_cursor *ctx, size_t col, pcr_exception ex)
+{
+    pcr_assert_state(pcr_cursor_type(ctx, col, ex) == PCR_ATTRIBUTE_BLOB, ex);
+    return ctx->vtable->cursor_blob(ctx->stmt, col);
+}
+
+
+/* Implement the pcr_cursor_attrib() interface function. Unlike the typed
+ * getters, the attribute holds its own copy of the value. */
+extern pcr_attribute *
+pcr_cursor_attrib(const pcr_cursor *ctx, size_t col, pcr_exception ex)
+{
+    cursor_check(ctx, col, ex);
+
+    pcr_exception_try (x) {
+        const pcr_string *key = pcr_cursor_key(ctx, col, x);
+
+        switch (pcr_cursor_type(ctx, col, x)) {
+            case PCR_ATTRIBUTE_INT:
+                return pcr_attribute_new_int(key, pcr_cursor_int(ctx, col, x),
+                                             x);
+                break;
+
+            case PCR_ATTRIBUTE_FLOAT:
+                return pcr_attribute_new_float(key,
+                                               pcr_cursor_float(ctx, col, x),
+                                               x);
+                break;
+
+            case PCR_ATTRIBUTE_TEXT:
+                return pcr_attribute_new_text(key,
+                                              pcr_cursor_text(ctx, col, x), x);
+                break;
+
+            case PCR_ATTRIBUTE_BLOB: {
+                pcr_blob blob = pcr_cursor_blob(ctx, col, x);
+                return pcr_attribute_new_blob(key, blob.data, blob.len, x);
+                break;
+            }
+
+            default:
+                return pcr_attribute_new_null(key, x);
+                break;
+        }
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_cursor_close() interface function. Closing a cursor more
+ * than once is harmless. */
+extern void
+pcr_cursor_close(pcr_cursor *ctx)
+{
+    if (ctx && ctx->stmt) {
+        ctx->vtable->cursor_close(ctx->stmt);
+        ctx->stmt = NULL;
+        ctx->row = false;
+    }
+}
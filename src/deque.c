@@ -0,0 +1,308 @@
+#include <string.h>
+#include "./api.h"
+
+
+/** @private */
+/* Define the pcr_deque struct; this structure was forward-declared in the API
+ * header file as an abstract data type. The elements are held in a ring buffer
+ * whose capacity is always a power of 2, so that logical indices can be mapped
+ * to slots by masking rather than by division. */
+struct pcr_deque {
+    char *payload;      /* ring buffer of elements       */
+    size_t sz;          /* size of each element          */
+    size_t head;        /* slot of the front element     */
+    size_t len;         /* number of elements            */
+    size_t cap;         /* number of slots, a power of 2 */
+    pcr_refcount__ ref; /* reference count               */
+};
+
+
+/* Define the deque_at() helper function. This function returns a pointer to
+ * the element at the 0-based logical index @idx of @ctx. */
+static inline char *
+deque_at(const pcr_deque *ctx, size_t idx)
+{
+    return ctx->payload + ((ctx->head + idx) & (ctx->cap - 1)) * ctx->sz;
+}
+
+
+/* Define the deque_span() helper function. This function returns the number of
+ * elements that are stored contiguously from the 0-based logical index @idx of
+ * @ctx before the ring buffer wraps around, limited to @len. */
+static inline size_t
+deque_span(const pcr_deque *ctx, size_t idx, size_t len)
+{
+    size_t slot = (ctx->head + idx) & (ctx->cap - 1);
+    size_t span = ctx->cap - slot;
+
+    return span < len ? span : len;
+}
+
+
+/* Define the deque_linearise() helper function. This function copies the @len
+ * elements of @ctx from its 0-based logical index @idx into the contiguous
+ * buffer @dst, taking care of any wrap around. */
+static void
+deque_linearise(const pcr_deque *ctx, size_t idx, size_t len, char *dst)
+{
+    size_t span = deque_span(ctx, idx, len);
+
+    memcpy(dst, deque_at(ctx, idx), span * ctx->sz);
+    memcpy(dst + span * ctx->sz, ctx->payload, (len - span) * ctx->sz);
+}
+
+
+/* Define the deque_alloc() helper function. This function allocates a new
+ * deque with elements of size @sz and @cap slots, copying over the elements of
+ * @src if it isn't null. */
+static pcr_deque *
+deque_alloc(size_t sz, size_t cap, const pcr_deque *src, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_deque *ctx = pcr_mempool_alloc(sizeof *ctx, x);
+
+        ctx->sz = sz;
+        ctx->head = 0;
+        ctx->len = 0;
+        ctx->cap = cap;
+        ctx->payload = pcr_mempool_alloc(sz * cap, x);
+        pcr_refcount_init__(&ctx->ref, 1);
+
+        if (src) {
+            deque_linearise(src, 0, src->len, ctx->payload);
+            ctx->len = src->len;
+        }
+
+        return ctx;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Define the deque_fork() helper function. This function is responsible for
+ * making a hard copy of @ctx if its reference count is greater than 1, in the
+ * same manner as the fork helpers of the other reference counted types. */
+static pcr_deque *
+deque_fork(pcr_deque **ctx, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_deque *hnd = *ctx;
+
+        if (pcr_refcount_get__(&hnd->ref) > 1) {
+            pcr_deque *frk = deque_alloc(hnd->sz, hnd->cap, hnd, x);
+
+            pcr_refcount_dec__(&hnd->ref);
+            *ctx = frk;
+        }
+
+        return *ctx;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Define the deque_grow() helper function. This function ensures that @ctx has
+ * room for at least one more element, doubling its capacity if required. The
+ * elements are linearised into the new ring buffer, and so the front element
+ * moves to the first slot. */
+static void
+deque_grow(pcr_deque *ctx, pcr_exception ex)
+{
+    if (pcr_hint_likely (ctx->len < ctx->cap))
+        return;
+
+    pcr_exception_try (x) {
+        char *payload = pcr_mempool_alloc(ctx->sz * ctx->cap * 2, x);
+        deque_linearise(ctx, 0, ctx->len, payload);
+
+        ctx->payload = payload;
+        ctx->head = 0;
+        ctx->cap *= 2;
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Implement the pcr_deque_new() interface function. */
+extern pcr_deque *
+pcr_deque_new(size_t elemsz, pcr_exception ex)
+{
+    pcr_assert_range(elemsz, ex);
+    return deque_alloc(elemsz, 8, NULL, ex);
+}
+
+
+/* Implement the pcr_deque_copy() interface function. */
+extern pcr_deque *
+pcr_deque_copy(const pcr_deque *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+
+    pcr_deque *hnd = (pcr_deque *) ctx;
+    pcr_refcount_inc__(&hnd->ref);
+
+    return hnd;
+}
+
+
+/* Implement the pcr_deque_len() interface function. */
+extern size_t
+pcr_deque_len(const pcr_deque *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    return ctx->len;
+}
+
+
+/* Implement the pcr_deque_refcount() interface function. */
+extern size_t
+pcr_deque_refcount(const pcr_deque *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    return pcr_refcount_get__(&ctx->ref);
+}
+
+
+/* Implement the pcr_deque_elem() interface function. As with pcr_vector_elem(),
+ * indices are 1-based and a copy of the element is returned. */
+extern void *
+pcr_deque_elem(const pcr_deque *ctx, size_t idx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_range(idx && idx <= ctx->len, ex);
+
+    pcr_exception_try (x) {
+        void *elem = pcr_mempool_alloc(ctx->sz, x);
+        memcpy(elem, deque_at(ctx, idx - 1), ctx->sz);
+
+        return elem;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_deque_push_back() interface function. */
+extern void
+pcr_deque_push_back(pcr_deque **ctx, const void *elem, pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx && elem, ex);
+
+    pcr_exception_try (x) {
+        pcr_deque *hnd = deque_fork(ctx, x);
+        deque_grow(hnd, x);
+
+        memcpy(deque_at(hnd, hnd->len++), elem, hnd->sz);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Implement the pcr_deque_push_front() interface function. */
+extern void
+pcr_deque_push_front(pcr_deque **ctx, const void *elem, pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx && elem, ex);
+
+    pcr_exception_try (x) {
+        pcr_deque *hnd = deque_fork(ctx, x);
+        deque_grow(hnd, x);
+
+        hnd->head = (hnd->head - 1) & (hnd->cap - 1);
+        hnd->len++;
+        memcpy(deque_at(hnd, 0), elem, hnd->sz);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Implement the pcr_deque_pop_back() interface function. The popped element is
+ * copied into @elem unless it is null. */
+extern void
+pcr_deque_pop_back(pcr_deque **ctx, void *elem, pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx, ex);
+    pcr_assert_state((*ctx)->len, ex);
+
+    pcr_exception_try (x) {
+        pcr_deque *hnd = deque_fork(ctx, x);
+        hnd->len--;
+
+        if (elem)
+            memcpy(elem, deque_at(hnd, hnd->len), hnd->sz);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Implement the pcr_deque_pop_front() interface function. The popped element is
+ * copied into @elem unless it is null. */
+extern void
+pcr_deque_pop_front(pcr_deque **ctx, void *elem, pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx, ex);
+    pcr_assert_state((*ctx)->len, ex);
+
+    pcr_exception_try (x) {
+        pcr_deque *hnd = deque_fork(ctx, x);
+
+        if (elem)
+            memcpy(elem, deque_at(hnd, 0), hnd->sz);
+
+        hnd->head = (hnd->head + 1) & (hnd->cap - 1);
+        hnd->len--;
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Implement the pcr_deque_drain() interface function. The drained elements are
+ * appended to @vec in at most two bulk copies, one for each contiguous span of
+ * the ring buffer. Draining nothing leaves a shared deque unforked. */
+extern size_t
+pcr_deque_drain(pcr_deque **ctx, pcr_vector **vec, size_t len,
+                pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx && vec && *vec, ex);
+    pcr_assert_state((*ctx)->sz == (*vec)->sz, ex);
+
+    if (len > (*ctx)->len)
+        len = (*ctx)->len;
+
+    if (!len)
+        return 0;
+
+    pcr_exception_try (x) {
+        pcr_deque *hnd = deque_fork(ctx, x);
+
+        size_t span = deque_span(hnd, 0, len);
+        pcr_vector_push_n(vec, deque_at(hnd, 0), span, x);
+        pcr_vector_push_n(vec, hnd->payload, len - span, x);
+
+        hnd->head = (hnd->head + len) & (hnd->cap - 1);
+        hnd->len -= len;
+
+        return len;
+    }
+
+    pcr_exception_unwind(ex);
+    return 0;
+}
+
+
+/* Implement the pcr_deque_drain_all() interface function. */
+extern size_t
+pcr_deque_drain_all(pcr_deque **ctx, pcr_vector **vec, pcr_exception ex)
+{
+    return pcr_deque_drain(ctx, vec, SIZE_MAX, ex);
+}
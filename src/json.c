@@ -0,0 +1,320 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "./api.h"
+
+#if (defined __SSE2__)
+#   include <emmintrin.h>
+#endif
+
+
+/** @private */
+/* Define the pcr_json_writer struct; this structure was forward-declared in
+ * the API header file as an abstract data type. A writer either accumulates
+ * its output in @buf, which grows as required, or, if @file is set, uses @buf
+ * as a bounded staging buffer that is written out to @file whenever it fills
+ * up. @total counts every byte written, whether still buffered or not. */
+struct pcr_json_writer {
+    char *buf;    /* output buffer                 */
+    size_t len;   /* number of bytes in @buf       */
+    size_t cap;   /* capacity of @buf              */
+    size_t total; /* number of bytes written       */
+    FILE *file;   /* output file, NULL if buffered */
+};
+
+
+/* Define the json_alloc() helper function. This function allocates a new
+ * writer with a buffer of @cap bytes that writes out to @file. */
+static pcr_json_writer *
+json_alloc(FILE *file, size_t cap, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_json_writer *ctx = pcr_mempool_alloc(sizeof *ctx, x);
+
+        ctx->buf = pcr_mempool_alloc(cap, x);
+        ctx->len = 0;
+        ctx->cap = cap;
+        ctx->total = 0;
+        ctx->file = file;
+
+        return ctx;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Define the json_drain() helper function. This function writes the buffered
+ * output of a file writer @ctx out to its file. */
+static void
+json_drain(pcr_json_writer *ctx, pcr_exception ex)
+{
+    if (ctx->len) {
+        pcr_assert_file(fwrite(ctx->buf, 1, ctx->len, ctx->file) == ctx->len,
+                        ex);
+        ctx->len = 0;
+    }
+}
+
+
+/* Define the json_reserve() helper function. This function makes room for at
+ * least @len more bytes in the buffer of @ctx, either by growing it or, for a
+ * file writer, by draining it. A file writer may still be left with less room
+ * than @len if @len exceeds its capacity; json_put() handles that case. */
+static void
+json_reserve(pcr_json_writer *ctx, size_t len, pcr_exception ex)
+{
+    if (pcr_hint_likely (ctx->len + len <= ctx->cap))
+        return;
+
+    if (ctx->file) {
+        json_drain(ctx, ex);
+        return;
+    }
+
+    pcr_exception_try (x) {
+        size_t cap = ctx->cap * 2;
+        while (cap < ctx->len + len)
+            cap *= 2;
+
+        ctx->buf = pcr_mempool_realloc(ctx->buf, cap, x);
+        ctx->cap = cap;
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the json_put() helper function. This function appends @len bytes at
+ * @str to the output of @ctx. Chunks that are too large to be buffered by a
+ * file writer are written straight out to its file. */
+static void
+json_put(pcr_json_writer *ctx, const char *str, size_t len, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        json_reserve(ctx, len, x);
+
+        if (pcr_hint_unlikely (ctx->len + len > ctx->cap)) {
+            pcr_assert_file(fwrite(str, 1, len, ctx->file) == len, x);
+        } else {
+            memcpy(ctx->buf + ctx->len, str, len);
+            ctx->len += len;
+        }
+
+        ctx->total += len;
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the json_clean() helper function. This function returns the length of
+ * the prefix of the @len bytes at @str that can be written without escaping;
+ * that is, the number of bytes before the first control character, quote or
+ * backslash. This is the hot loop of text output, and so SSE2 is used to scan
+ * 16 bytes at a time where available. */
+static inline size_t
+json_clean(const char *str, size_t len)
+{
+    register size_t i = 0;
+
+#if (defined __SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    const __m128i ctrl = _mm_set1_epi8(0x1f);
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (str + i));
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                 _mm_cmpeq_epi8(v, slash));
+
+        /* an unsigned byte is at most 0x1f iff max(byte, 0x1f) is 0x1f */
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl));
+
+        uint32_t mask = (uint32_t) _mm_movemask_epi8(m);
+        if (mask) {
+#   if (defined __GNUC__ || defined __clang__)
+            return i + (size_t) __builtin_ctz(mask);
+#   else
+            break;
+#   endif
+        }
+    }
+#endif
+
+    for (; i < len; i++) {
+        unsigned char c = (unsigned char) str[i];
+        if (c < 0x20 || c == '"' || c == '\\')
+            break;
+    }
+
+    return i;
+}
+
+
+/* Define the json_escape() helper function. This function writes the escape
+ * sequence of a character @c that can't appear as-is in a JSON string. */
+static void
+json_escape(pcr_json_writer *ctx, unsigned char c, pcr_exception ex)
+{
+    static const char digits[] = "0123456789abcdef";
+    char esc[6] = {'\\', 'u', '0', '0', digits[c >> 4], digits[c & 0xf]};
+
+    switch (c) {
+        case '"': json_put(ctx, "\\\"", 2, ex); break;
+        case '\\': json_put(ctx, "\\\\", 2, ex); break;
+        case '\b': json_put(ctx, "\\b", 2, ex); break;
+        case '\f': json_put(ctx, "\\f", 2, ex); break;
+        case '\n': json_put(ctx, "\\n", 2, ex); break;
+        case '\r': json_put(ctx, "\\r", 2, ex); break;
+        case '\t': json_put(ctx, "\\t", 2, ex); break;
+        default: json_put(ctx, esc, sizeof esc, ex); break;
+    }
+}
+
+
+/* Implement the pcr_json_writer_new() interface function. */
+extern pcr_json_writer *
+pcr_json_writer_new(pcr_exception ex)
+{
+    return json_alloc(NULL, 256, ex);
+}
+
+
+/* Implement the pcr_json_writer_new_2() interface function. The output is
+ * staged in a buffer of PCR_JSON_WRITER_BUFFER bytes, so the memory used does
+ * not depend on the size of the document. */
+extern pcr_json_writer *
+pcr_json_writer_new_2(FILE *file, pcr_exception ex)
+{
+    pcr_assert_handle(file, ex);
+    return json_alloc(file, PCR_JSON_WRITER_BUFFER, ex);
+}
+
+
+/* Implement the pcr_json_writer_len() interface function. */
+extern size_t
+pcr_json_writer_len(const pcr_json_writer *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    return ctx->total;
+}
+
+
+/* Implement the pcr_json_writer_string() interface function. Only buffered
+ * writers hold on to their output, so this function can't be called on a file
+ * writer. */
+extern pcr_string *
+pcr_json_writer_string(const pcr_json_writer *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_state(!ctx->file, ex);
+
+    pcr_exception_try (x) {
+        pcr_string *str = pcr_mempool_alloc(ctx->len + 1, x);
+
+        memcpy(str, ctx->buf, ctx->len);
+        str[ctx->len] = '\0';
+
+        return str;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_json_writer_flush() interface function. Flushing a
+ * buffered writer is a no-op. */
+extern void
+pcr_json_writer_flush(pcr_json_writer *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+
+    if (ctx->file) {
+        json_drain(ctx, ex);
+        pcr_assert_file(!fflush(ctx->file), ex);
+    }
+}
+
+
+/* Implement the pcr_json_writer_raw() interface function. */
+extern void
+pcr_json_writer_raw(pcr_json_writer *ctx, const char *str, size_t len,
+                    pcr_exception ex)
+{
+    pcr_assert_handle(ctx && (str || !len), ex);
+    json_put(ctx, str, len, ex);
+}
+
+
+/* Implement the pcr_json_writer_text() interface function. Runs of characters
+ * that need no escaping are copied in bulk, and only the characters between
+ * them are escaped one at a time. UTF-8 sequences are passed through as-is. */
+extern void
+pcr_json_writer_text(pcr_json_writer *ctx, const char *str, size_t len,
+                     pcr_exception ex)
+{
+    pcr_assert_handle(ctx && (str || !len), ex);
+
+    pcr_exception_try (x) {
+        json_put(ctx, "\"", 1, x);
+
+        for (register size_t i = 0, run; i < len; i += run + 1) {
+            run = json_clean(str + i, len - i);
+            json_put(ctx, str + i, run, x);
+
+            if (i + run < len)
+                json_escape(ctx, (unsigned char) str[i + run], x);
+        }
+
+        json_put(ctx, "\"", 1, x);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Implement the pcr_json_writer_int() interface function. */
+extern void
+pcr_json_writer_int(pcr_json_writer *ctx, int64_t value, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+
+    char num[24];
+    int len = snprintf(num, sizeof num, "%" PRId64, value);
+    json_put(ctx, num, (size_t) len, ex);
+}
+
+
+/* Implement the pcr_json_writer_float() interface function. The shortest of
+ * 15 or 17 significant digits that reads back as @value is written; JSON has
+ * no representation for infinities and NaNs, so these are written as null. */
+extern void
+pcr_json_writer_float(pcr_json_writer *ctx, double value, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+
+    if (pcr_hint_unlikely (!isfinite(value))) {
+        json_put(ctx, "null", 4, ex);
+        return;
+    }
+
+    char num[32];
+    int len = snprintf(num, sizeof num, "%.15g", value);
+    if (strtod(num, NULL) != value)
+        len = snprintf(num, sizeof num, "%.17g", value);
+
+    json_put(ctx, num, (size_t) len, ex);
+}
+
+
+/* Implement the pcr_json_writer_null() interface function. */
+extern void
+pcr_json_writer_null(pcr_json_writer *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    json_put(ctx, "null", 4, ex);
+}
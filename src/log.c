@@ -80,7 +80,7 @@ pcr_log_suppress(void)
  */
 extern void pcr_log_write__(const char type, const char *msg, ...)
 {
-    if (pcr_hint_unlikely (!log_enabled))
+    if (pcr_hint_unlikely (!log_enabled || !log_file))
         return;
 
     time_t tm = time(NULL);
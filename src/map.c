@@ -0,0 +1,586 @@
+#include <string.h>
+#include "./api.h"
+
+#if (defined __SSE2__)
+#   include <emmintrin.h>
+#endif
+
+
+/* Define the layout constants of the hash table. The table is split into groups
+ * of MAP_GROUP slots, each with a control byte; a control byte is either
+ * MAP_EMPTY, MAP_DELETED (a tombstone), or the low 7 bits of the hash of the
+ * key held in its slot. Groups are probed a whole at a time, which allows the
+ * control bytes of a group to be matched in parallel. */
+#define MAP_GROUP 16
+#define MAP_EMPTY ((uint8_t) 0x80)
+#define MAP_DELETED ((uint8_t) 0xFE)
+
+
+/* Define the size of keys that are stored inline in their slot; longer keys
+ * are copied onto the heap. This is large enough for integer keys and most
+ * short identifiers such as column names. */
+#define MAP_INLINE 16
+
+
+/* Define the map_slot struct. Along with the key, each slot caches the full
+ * hash of the key so that rehashing and probing don't need to rehash keys. */
+struct map_slot {
+    uint64_t hash;
+    size_t keysz;
+    union {
+        unsigned char buf[MAP_INLINE];
+        void *ptr;
+    } key;
+};
+
+
+/** @private */
+/* Define the pcr_map struct; this structure was forward-declared in the API
+ * header file as an abstract data type. */
+struct pcr_map {
+    uint8_t *ctrl;          /* control bytes, one per slot     */
+    struct map_slot *slots; /* keys, one per slot              */
+    char *vals;             /* values, one per slot            */
+    size_t valsz;           /* size of each value              */
+    size_t len;             /* number of keys                  */
+    size_t cap;             /* number of slots                 */
+    size_t growth;          /* empty slots left before rehash  */
+    pcr_refcount__ ref;     /* reference count                 */
+};
+
+
+/* Define the map_mix() helper function. This is the 64-bit finaliser of
+ * MurmurHash3, and is used to avalanche the bits of each word hashed. */
+static inline uint64_t
+map_mix(uint64_t v)
+{
+    v ^= v >> 33;
+    v *= 0xFF51AFD7ED558CCDULL;
+    v ^= v >> 33;
+    v *= 0xC4CEB9FE1A85EC53ULL;
+    v ^= v >> 33;
+
+    return v;
+}
+
+
+/* Implement the pcr_map_hash__() private helper function. This function hashes
+ * the @len bytes of @key a word at a time; it is shared with the other modules
+ * that need to hash values consistently with pcr_map. */
+extern uint64_t
+pcr_map_hash__(const void *key, size_t len)
+{
+    const unsigned char *itr = key;
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ (len * 0xC2B2AE3D27D4EB4FULL);
+    uint64_t w;
+
+    for (; len >= sizeof w; itr += sizeof w, len -= sizeof w) {
+        memcpy(&w, itr, sizeof w);
+        h = (h ^ map_mix(w)) * 0x9FB21C651E98DF25ULL;
+    }
+
+    if (len) {
+        w = 0;
+        memcpy(&w, itr, len);
+        h = (h ^ map_mix(w)) * 0x9FB21C651E98DF25ULL;
+    }
+
+    return map_mix(h);
+}
+
+
+/* Define the map_h2() helper function. This function returns the control byte
+ * for a key with a given @hash. */
+static inline uint8_t
+map_h2(uint64_t hash)
+{
+    return (uint8_t) (hash & 0x7F);
+}
+
+
+/* Define the map_ctz() helper function. This function returns the index of the
+ * lowest bit set in a non-zero group bitmask @m. */
+static inline size_t
+map_ctz(uint32_t m)
+{
+#if (defined __GNUC__ || defined __clang__)
+    return (size_t) __builtin_ctz(m);
+#else
+    size_t n = 0;
+    while (!(m & 1)) {
+        m >>= 1;
+        n++;
+    }
+
+    return n;
+#endif
+}
+
+
+/* Define the grp_match(), grp_empty() and grp_free() helper functions. These
+ * functions return a bitmask with bit j set if the j-th control byte in a group
+ * @grp is respectively equal to @h2, MAP_EMPTY, or either MAP_EMPTY or
+ * MAP_DELETED. SSE2 is used to match all 16 bytes at once where available. */
+#if (defined __SSE2__)
+static inline uint32_t
+grp_match(const uint8_t *grp, uint8_t h2)
+{
+    __m128i g = _mm_loadu_si128((const __m128i *) grp);
+    __m128i m = _mm_cmpeq_epi8(g, _mm_set1_epi8((char) h2));
+
+    return (uint32_t) _mm_movemask_epi8(m);
+}
+
+static inline uint32_t
+grp_empty(const uint8_t *grp)
+{
+    return grp_match(grp, MAP_EMPTY);
+}
+
+static inline uint32_t
+grp_free(const uint8_t *grp)
+{
+    __m128i g = _mm_loadu_si128((const __m128i *) grp);
+    return (uint32_t) _mm_movemask_epi8(g);
+}
+#else
+static inline uint32_t
+grp_match(const uint8_t *grp, uint8_t h2)
+{
+    uint32_t m = 0;
+    for (register size_t j = 0; j < MAP_GROUP; j++)
+        m |= (uint32_t) (grp[j] == h2) << j;
+
+    return m;
+}
+
+static inline uint32_t
+grp_empty(const uint8_t *grp)
+{
+    return grp_match(grp, MAP_EMPTY);
+}
+
+static inline uint32_t
+grp_free(const uint8_t *grp)
+{
+    uint32_t m = 0;
+    for (register size_t j = 0; j < MAP_GROUP; j++)
+        m |= (uint32_t) (grp[j] >> 7) << j;
+
+    return m;
+}
+#endif
+
+
+/* Define the slot_key() helper function. This function returns a pointer to
+ * the bytes of the key held in a slot @s. */
+static inline const void *
+slot_key(const struct map_slot *s)
+{
+    return s->keysz <= MAP_INLINE ? s->key.buf : s->key.ptr;
+}
+
+
+/* Define the map_capacity() helper function. This function returns the number
+ * of slots required to hold @len keys without exceeding the maximum load factor
+ * of 7/8; the number of slots is always a power of 2. */
+static size_t
+map_capacity(size_t len)
+{
+    size_t cap = MAP_GROUP;
+    while (cap - cap / 8 < len)
+        cap *= 2;
+
+    return cap;
+}
+
+
+/* Define the map_alloc() helper function. This function allocates empty
+ * storage for @cap slots in @ctx; the existing storage, if any, is not freed
+ * since it is managed by the garbage collector. */
+static void
+map_alloc(pcr_map *ctx, size_t cap, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        uint8_t *ctrl = pcr_mempool_alloc(cap, x);
+        struct map_slot *slots = pcr_mempool_alloc(cap * sizeof *slots, x);
+        char *vals = pcr_mempool_alloc(cap * ctx->valsz, x);
+
+        memset(ctrl, MAP_EMPTY, cap);
+        ctx->ctrl = ctrl;
+        ctx->slots = slots;
+        ctx->vals = vals;
+        ctx->cap = cap;
+        ctx->growth = cap - cap / 8 - ctx->len;
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the map_lookup() helper function. This function walks the probe
+ * sequence for @hash through the groups of @ctx, and returns the 1-based slot
+ * index of @key if found, or 0 otherwise. The probe stops at the first group
+ * with an empty slot since an insertion would never have passed over it. */
+static size_t
+map_lookup(const pcr_map *ctx, uint64_t hash, const void *key, size_t keysz)
+{
+    const size_t mask = ctx->cap / MAP_GROUP - 1;
+    const uint8_t h2 = map_h2(hash);
+    size_t g = (size_t) (hash >> 7) & mask;
+
+    for (register size_t step = 0; step <= mask; step++) {
+        const uint8_t *grp = ctx->ctrl + g * MAP_GROUP;
+
+        for (uint32_t m = grp_match(grp, h2); m; m &= m - 1) {
+            size_t idx = g * MAP_GROUP + map_ctz(m);
+            const struct map_slot *s = &ctx->slots[idx];
+
+            if (s->hash == hash && s->keysz == keysz
+                && !memcmp(slot_key(s), key, keysz))
+                return idx + 1;
+        }
+
+        if (pcr_hint_likely (grp_empty(grp)))
+            return 0;
+
+        g = (g + step + 1) & mask;
+    }
+
+    return 0;
+}
+
+
+/* Define the map_probe() helper function. This function returns the 0-based
+ * index of the first empty or deleted slot in the probe sequence for @hash.
+ * The table is never completely full, so a free slot always exists. */
+static size_t
+map_probe(const pcr_map *ctx, uint64_t hash)
+{
+    const size_t mask = ctx->cap / MAP_GROUP - 1;
+    size_t g = (size_t) (hash >> 7) & mask;
+
+    for (register size_t step = 0;; step++) {
+        uint32_t m = grp_free(ctx->ctrl + g * MAP_GROUP);
+        if (m)
+            return g * MAP_GROUP + map_ctz(m);
+
+        g = (g + step + 1) & mask;
+    }
+}
+
+
+/* Define the map_place() helper function. This function places a slot @s with
+ * value @val into the first free slot of its probe sequence in @ctx, and
+ * returns the 0-based index of the slot used. The caller is responsible for
+ * ensuring that @ctx has room for the new slot. */
+static size_t
+map_place(pcr_map *ctx, const struct map_slot *s, const void *val)
+{
+    size_t idx = map_probe(ctx, s->hash);
+
+    if (ctx->ctrl[idx] == MAP_EMPTY)
+        ctx->growth--;
+
+    ctx->ctrl[idx] = map_h2(s->hash);
+    ctx->slots[idx] = *s;
+    memcpy(ctx->vals + idx * ctx->valsz, val, ctx->valsz);
+    ctx->len++;
+
+    return idx;
+}
+
+
+/* Define the map_rehash() helper function. This function moves the keys in
+ * @ctx into fresh storage of @cap slots, dropping any tombstones. The cached
+ * hashes are reused, so keys are not rehashed. */
+static void
+map_rehash(pcr_map *ctx, size_t cap, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        const uint8_t *ctrl = ctx->ctrl;
+        const struct map_slot *slots = ctx->slots;
+        const char *vals = ctx->vals;
+        const size_t oldcap = ctx->cap;
+
+        ctx->len = 0;
+        map_alloc(ctx, cap, x);
+
+        for (register size_t i = 0; i < oldcap; i++) {
+            if (!(ctrl[i] & 0x80))
+                (void) map_place(ctx, &slots[i], vals + i * ctx->valsz);
+        }
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the map_fork() helper function. This function is responsible for
+ * making a hard copy of @ctx if its reference count is greater than 1, in the
+ * same manner as the fork helpers of the other reference counted types. Keys
+ * held on the heap are never modified, and so are shared by the copy. */
+static pcr_map *
+map_fork(pcr_map **ctx, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_map *hnd = *ctx;
+
+        if (pcr_refcount_get__(&hnd->ref) > 1) {
+            pcr_map *frk = pcr_mempool_alloc(sizeof *frk, x);
+
+            frk->valsz = hnd->valsz;
+            frk->len = hnd->len;
+            map_alloc(frk, hnd->cap, x);
+            frk->growth = hnd->growth;
+            pcr_refcount_init__(&frk->ref, 1);
+
+            memcpy(frk->ctrl, hnd->ctrl, hnd->cap);
+            memcpy(frk->slots, hnd->slots, hnd->cap * sizeof *hnd->slots);
+            memcpy(frk->vals, hnd->vals, hnd->cap * hnd->valsz);
+
+            pcr_refcount_dec__(&hnd->ref);
+            *ctx = frk;
+        }
+
+        return *ctx;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_map_new() interface function. */
+extern pcr_map *
+pcr_map_new(size_t valsz, pcr_exception ex)
+{
+    pcr_assert_range(valsz, ex);
+
+    pcr_exception_try (x) {
+        pcr_map *ctx = pcr_mempool_alloc(sizeof *ctx, x);
+
+        ctx->valsz = valsz;
+        ctx->len = 0;
+        pcr_refcount_init__(&ctx->ref, 1);
+        map_alloc(ctx, MAP_GROUP, x);
+
+        return ctx;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_map_copy() interface function. */
+extern pcr_map *
+pcr_map_copy(const pcr_map *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+
+    pcr_map *hnd = (pcr_map *) ctx;
+    pcr_refcount_inc__(&hnd->ref);
+
+    return hnd;
+}
+
+
+/* Implement the pcr_map_len() interface function. */
+extern size_t
+pcr_map_len(const pcr_map *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    return ctx->len;
+}
+
+
+/* Implement the pcr_map_refcount() interface function. */
+extern size_t
+pcr_map_refcount(const pcr_map *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    return pcr_refcount_get__(&ctx->ref);
+}
+
+
+/* Implement the pcr_map_reserve() interface function. We rehash into a larger
+ * table only if @len keys wouldn't fit in the current one. */
+extern void
+pcr_map_reserve(pcr_map **ctx, size_t len, pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx, ex);
+
+    pcr_exception_try (x) {
+        pcr_map *hnd = map_fork(ctx, x);
+        size_t cap = map_capacity(len);
+
+        if (cap > hnd->cap)
+            map_rehash(hnd, cap, x);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Implement the pcr_map_get() interface function. */
+extern bool
+pcr_map_get(const pcr_map *ctx, const void *key, size_t keysz, void *val,
+            pcr_exception ex)
+{
+    pcr_assert_handle(ctx && key, ex);
+
+    size_t idx = map_lookup(ctx, pcr_map_hash__(key, keysz), key, keysz);
+    if (idx && val)
+        memcpy(val, ctx->vals + (idx - 1) * ctx->valsz, ctx->valsz);
+
+    return idx;
+}
+
+
+/* Implement the pcr_map_set() interface function. If the table has run out of
+ * empty slots, we either rehash in place when at least half the used slots are
+ * tombstones, or double the size of the table otherwise. */
+extern void
+pcr_map_set(pcr_map **ctx, const void *key, size_t keysz, const void *val,
+            pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx && key && val, ex);
+
+    pcr_exception_try (x) {
+        pcr_map *hnd = map_fork(ctx, x);
+        uint64_t hash = pcr_map_hash__(key, keysz);
+
+        size_t idx = map_lookup(hnd, hash, key, keysz);
+        if (idx) {
+            memcpy(hnd->vals + (idx - 1) * hnd->valsz, val, hnd->valsz);
+            return;
+        }
+
+        struct map_slot s = {.hash = hash, .keysz = keysz};
+        if (keysz <= MAP_INLINE)
+            memcpy(s.key.buf, key, keysz);
+        else {
+            s.key.ptr = pcr_mempool_alloc(keysz, x);
+            memcpy(s.key.ptr, key, keysz);
+        }
+
+        if (pcr_hint_unlikely (!hnd->growth)) {
+            size_t maxlen = hnd->cap - hnd->cap / 8;
+            map_rehash(hnd, hnd->len < maxlen / 2 ? hnd->cap : hnd->cap * 2, x);
+        }
+
+        (void) map_place(hnd, &s, val);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Implement the pcr_map_remove() interface function. A removed slot can be
+ * marked empty again only if its group still has an empty slot; otherwise some
+ * probe sequence may have passed over the group, and so a tombstone is left
+ * behind instead. */
+extern bool
+pcr_map_remove(pcr_map **ctx, const void *key, size_t keysz, pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx && key, ex);
+
+    pcr_exception_try (x) {
+        size_t idx = map_lookup(*ctx, pcr_map_hash__(key, keysz), key, keysz);
+        if (!idx--)
+            return false;
+
+        /* a fork has the same layout, so @idx remains valid */
+        pcr_map *hnd = map_fork(ctx, x);
+        const uint8_t *grp = hnd->ctrl + idx / MAP_GROUP * MAP_GROUP;
+
+        if (grp_empty(grp)) {
+            hnd->ctrl[idx] = MAP_EMPTY;
+            hnd->growth++;
+        } else
+            hnd->ctrl[idx] = MAP_DELETED;
+
+        memset(&hnd->slots[idx], 0, sizeof *hnd->slots);
+        hnd->len--;
+
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/* Implement the pcr_map_iterate() interface function. Keys are visited in slot
+ * order, which is unspecified. */
+extern void
+pcr_map_iterate(const pcr_map *ctx, pcr_map_iterator *itr, void *opt,
+                pcr_exception ex)
+{
+    pcr_assert_handle(ctx && itr, ex);
+
+    pcr_exception_try (x) {
+        for (register size_t i = 0; i < ctx->cap; i++) {
+            if (!(ctx->ctrl[i] & 0x80)) {
+                const struct map_slot *s = &ctx->slots[i];
+                itr(slot_key(s), s->keysz, ctx->vals + i * ctx->valsz, opt, x);
+            }
+        }
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Implement the pcr_map_get_str() interface function. */
+extern bool
+pcr_map_get_str(const pcr_map *ctx, const pcr_string *key, void *val,
+                pcr_exception ex)
+{
+    pcr_assert_handle(key, ex);
+    return pcr_map_get(ctx, key, strlen(key), val, ex);
+}
+
+
+/* Implement the pcr_map_set_str() interface function. */
+extern void
+pcr_map_set_str(pcr_map **ctx, const pcr_string *key, const void *val,
+                pcr_exception ex)
+{
+    pcr_assert_handle(key, ex);
+    pcr_map_set(ctx, key, strlen(key), val, ex);
+}
+
+
+/* Implement the pcr_map_remove_str() interface function. */
+extern bool
+pcr_map_remove_str(pcr_map **ctx, const pcr_string *key, pcr_exception ex)
+{
+    pcr_assert_handle(key, ex);
+    return pcr_map_remove(ctx, key, strlen(key), ex);
+}
+
+
+/* Implement the pcr_map_get_i64() interface function. */
+extern bool
+pcr_map_get_i64(const pcr_map *ctx, int64_t key, void *val, pcr_exception ex)
+{
+    return pcr_map_get(ctx, &key, sizeof key, val, ex);
+}
+
+
+/* Implement the pcr_map_set_i64() interface function. */
+extern void
+pcr_map_set_i64(pcr_map **ctx, int64_t key, const void *val, pcr_exception ex)
+{
+    pcr_map_set(ctx, &key, sizeof key, val, ex);
+}
+
+
+/* Implement the pcr_map_remove_i64() interface function. */
+extern bool
+pcr_map_remove_i64(pcr_map **ctx, int64_t key, pcr_exception ex)
+{
+    return pcr_map_remove(ctx, &key, sizeof key, ex);
+}
@@ -1,3 +1,4 @@
+#define GC_THREADS
 #include <gc.h>
 #include "api.h"
 
@@ -25,3 +26,40 @@ extern void *pcr_mempool_realloc(void *ptr, size_t sz, pcr_exception ex)
     return bfr;
 }
 
+
+/* Threads that are not created through the Boehm GC wrappers must register
+ * themselves with the collector before they allocate, and the registration
+ * must first be allowed from a thread that is already known to the collector.
+ * The following three private helpers are used by the pcr_worker interface to
+ * do exactly this for its worker threads. */
+
+extern void pcr_mempool_thread_init__(void)
+{
+    GC_allow_register_threads();
+}
+
+
+extern void pcr_mempool_thread_enter__(void)
+{
+    struct GC_stack_base sb;
+
+    (void) GC_get_stack_base(&sb);
+    (void) GC_register_my_thread(&sb);
+}
+
+
+extern void pcr_mempool_thread_exit__(void)
+{
+    (void) GC_unregister_my_thread();
+}
+
+
+/* The pcr_vector_map() interface function holds a file mapping that the
+ * collector knows nothing about; this private helper lets it release the
+ * mapping once the vector holding it is no longer reachable. */
+
+extern void pcr_mempool_finalize__(void *ptr, void (*fin)(void *, void *),
+                                   void *opt)
+{
+    GC_REGISTER_FINALIZER(ptr, fin, opt, NULL, NULL);
+}
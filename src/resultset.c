@@ -1,14 +1,279 @@
+#include <math.h>
+#include <string.h>
 #include "./api.h"
 
+
+/* Define the number of cells flagged by each word of a validity bitmap. */
+#define RSET_WORD 64
+
+
+/** @private */
+/* Define the rset_col struct. Each column of a result set is stored as a typed
+ * array of values; integers and floating point numbers are held inline in
+ * @data, while text and blobs are packed end to end in @bytes, with @data then
+ * holding the end offset of each cell. The bit for a cell in the @valid bitmap
+ * is clear if the cell is NULL, in which case its slot in @data is zero or an
+ * empty span. Columns of type PCR_ATTRIBUTE_NULL hold only the bitmap. */
+struct rset_col {
+    PCR_ATTRIBUTE type; /* column type                     */
+    pcr_vector *data;   /* int64_t, double or size_t cells */
+    pcr_vector *bytes;  /* text and blob bytes             */
+    pcr_vector *valid;  /* uint64_t validity bitmap        */
+};
+
+
+/** @private */
+/* Define the pcr_resultset struct; this structure was forward-declared in the
+ * API header file as an abstract data type. Cells are pushed in row-major order
+ * but stored by column; @rows counts the complete rows, and @part the cells
+ * pushed so far to the row following them. The @index maps each key to its
+ * 1-based column; keys never change, so it is built once and then shared. */
 struct pcr_resultset {
     pcr_string *name;
     pcr_string_vector *keys;
+    pcr_map *index;
     PCR_ATTRIBUTE_VECTOR *types;
-    pcr_vector *values; // holds void** values to ensure Unicode support
-    size_t ref;
+    struct rset_col *cols;
+    size_t ncols;
+    size_t rows;
+    size_t part;
+    pcr_refcount__ ref;
 };
 
 
+/* Define the rset_alloc() helper function. This function allocates an array of
+ * @n elements of size @sz. An empty result set needs no array at all, and so
+ * NULL is returned if @n is 0; every caller indexes the array only below @n, so
+ * this is never dereferenced. */
+static void *
+rset_alloc(size_t n, size_t sz, pcr_exception ex)
+{
+    if (!n)
+        return NULL;
+
+    pcr_assert_range(n <= SIZE_MAX / sz, ex);
+    return pcr_mempool_alloc(n * sz, ex);
+}
+
+
+/* Define the col_elemsz() helper function. This function returns the size of
+ * the cells in @data for a column of @type, or 0 if it has no @data. */
+static inline size_t
+col_elemsz(PCR_ATTRIBUTE type)
+{
+    switch (type) {
+        case PCR_ATTRIBUTE_INT: return sizeof (int64_t); break;
+        case PCR_ATTRIBUTE_FLOAT: return sizeof (double); break;
+        case PCR_ATTRIBUTE_TEXT: return sizeof (size_t); break;
+        case PCR_ATTRIBUTE_BLOB: return sizeof (size_t); break;
+        default: return 0; break;
+    }
+}
+
+
+/* Define the col_retype() helper function. This function (re)initialises the
+ * storage of @col for @type, holding @len NULL cells; the validity bitmap of
+ * @col, if any, is kept as it is. */
+static void
+col_retype(struct rset_col *col, PCR_ATTRIBUTE type, size_t len,
+           pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        const size_t sz = col_elemsz(type);
+
+        if (!col->valid)
+            col->valid = pcr_vector_new(sizeof (uint64_t), x);
+
+        col->type = type;
+        col->data = NULL;
+        col->bytes = NULL;
+
+        if (sz) {
+            col->data = pcr_vector_new_2(sz, len ? len : 1, x);
+            memset(col->data->payload, 0, len * sz);
+            col->data->len = len;
+        }
+
+        if (type == PCR_ATTRIBUTE_TEXT || type == PCR_ATTRIBUTE_BLOB)
+            col->bytes = pcr_vector_new(1, x);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the col_valid() helper function. This function checks whether the
+ * 0-based @row of @col is not NULL. */
+static inline bool
+col_valid(const struct rset_col *col, size_t row)
+{
+    const uint64_t *bits = col->valid->payload;
+    return (bits[row / RSET_WORD] >> (row % RSET_WORD)) & 1;
+}
+
+
+/* Define the col_valid_set() helper function. This function flags the 0-based
+ * @row of @col as not NULL if @on is set, and as NULL otherwise. */
+static void
+col_valid_set(struct rset_col *col, size_t row, bool on, pcr_exception ex)
+{
+    const uint64_t bit = (uint64_t) 1 << (row % RSET_WORD);
+    uint64_t word = ((const uint64_t *) col->valid->payload)[row / RSET_WORD];
+
+    word = on ? word | bit : word & ~bit;
+    pcr_vector_setelem(&col->valid, &word, row / RSET_WORD + 1, ex);
+}
+
+
+/* Define the col_span() helper function. This function locates the bytes of
+ * the 0-based @row of a text or blob column @col. */
+static inline void
+col_span(const struct rset_col *col, size_t row, size_t *off, size_t *len)
+{
+    const size_t *ends = col->data->payload;
+
+    *off = row ? ends[row - 1] : 0;
+    *len = ends[row] - *off;
+}
+
+
+/* Define the col_cell() helper function. This function reads the value of the
+ * attribute @attr into the buffer @cell in the form stored in @data, returning
+ * the bytes of text and blob values through @bytes and @len. */
+static void
+col_cell(const struct rset_col *col, const pcr_attribute *attr, void *cell,
+         const void **bytes, size_t *len, pcr_exception ex)
+{
+    *bytes = NULL;
+    *len = 0;
+
+    if (pcr_attribute_type(attr, ex) == PCR_ATTRIBUTE_NULL)
+        return;
+
+    if (col->type == PCR_ATTRIBUTE_INT)
+        *((int64_t *) cell) = pcr_attribute_int(attr, ex);
+    else if (col->type == PCR_ATTRIBUTE_FLOAT)
+        *((double *) cell) = pcr_attribute_float(attr, ex);
+    else if (col->type == PCR_ATTRIBUTE_TEXT) {
+        *bytes = pcr_attribute_text_ref(attr, ex);
+        *len = strlen(*bytes);
+    } else if (col->type == PCR_ATTRIBUTE_BLOB) {
+        pcr_blob blob = pcr_attribute_blob(attr, ex);
+        *bytes = blob.data;
+        *len = blob.len;
+    }
+}
+
+
+/* Define the col_push() helper function. This function appends @attr to @col
+ * as its 0-based @row. */
+static void
+col_push(struct rset_col *col, size_t row, const pcr_attribute *attr,
+         pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        if (!(row % RSET_WORD)) {
+            const uint64_t word = 0;
+            pcr_vector_push(&col->valid, &word, x);
+        }
+
+        if (pcr_attribute_type(attr, x) != PCR_ATTRIBUTE_NULL)
+            col_valid_set(col, row, true, x);
+
+        if (col->data) {
+            uint64_t cell = 0;
+            const void *bytes;
+            size_t len;
+
+            col_cell(col, attr, &cell, &bytes, &len, x);
+            if (col->bytes) {
+                pcr_vector_push_n(&col->bytes, bytes, len, x);
+                memcpy(&cell, &col->bytes->len, sizeof col->bytes->len);
+            }
+
+            pcr_vector_push(&col->data, &cell, x);
+        }
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the col_splice() helper function. This function replaces the bytes
+ * of the 0-based @row of a text or blob column @col with the @len bytes at
+ * @bytes. The packed bytes and the offsets after @row have to be rebuilt, and
+ * so this takes time linear in the size of the column; new vectors are built
+ * rather than the existing ones modified, since they may be shared. */
+static void
+col_splice(struct rset_col *col, size_t row, const void *bytes, size_t len,
+           pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        size_t off, old;
+        col_span(col, row, &off, &old);
+
+        const size_t rows = col->data->len;
+        const size_t total = col->bytes->len - old + len;
+        const char *src = col->bytes->payload;
+
+        pcr_vector *packed = pcr_vector_new_2(1, total ? total : 1, x);
+        char *dst = packed->payload;
+        memcpy(dst, src, off);
+        if (len)
+            memcpy(dst + off, bytes, len);
+        memcpy(dst + off + len, src + off + old, col->bytes->len - off - old);
+        packed->len = total;
+
+        pcr_vector *data = pcr_vector_new_2(sizeof (size_t), rows, x);
+        size_t *ends = data->payload;
+        memcpy(ends, col->data->payload, rows * sizeof *ends);
+        for (register size_t i = row; i < rows; i++)
+            ends[i] = ends[i] - old + len;
+        data->len = rows;
+
+        col->bytes = packed;
+        col->data = data;
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the col_attrib() helper function. This function returns the 0-based
+ * @row of @col as an attribute keyed @key. Text and blob values are copied out
+ * of the packed bytes, which may be rebuilt by a later call to
+ * pcr_resultset_attrib_set(). */
+static pcr_attribute *
+col_attrib(const struct rset_col *col, pcr_string *key, size_t row,
+           pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        if (!col_valid(col, row))
+            return pcr_attribute_new_take(PCR_ATTRIBUTE_NULL, key, NULL, x);
+
+        char *cell = (char *) col->data->payload + row * col->data->sz;
+        if (!col->bytes)
+            return pcr_attribute_new_take(col->type, key, cell, x);
+
+        size_t off, len;
+        col_span(col, row, &off, &len);
+
+        char *data = pcr_mempool_alloc(len + 1, x);
+        memcpy(data, (const char *) col->bytes->payload + off, len);
+        data[len] = '\0';
+
+        if (col->type == PCR_ATTRIBUTE_TEXT)
+            return pcr_attribute_new_take(col->type, key, data, x);
+
+        pcr_blob blob = {.data = data, .len = len};
+        return pcr_attribute_new_take(col->type, key, &blob, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
 extern pcr_resultset *
 pcr_resultset_new(const pcr_string *name, const pcr_string_vector *keys,
                   const PCR_ATTRIBUTE_VECTOR *types, pcr_exception ex)
@@ -18,11 +283,30 @@ pcr_resultset_new(const pcr_string *name, const pcr_string_vector *keys,
     pcr_exception_try (x) {
         pcr_resultset *ctx = pcr_mempool_alloc(sizeof *ctx, x);
 
-        ctx->ref = 1;
+        pcr_refcount_init__(&ctx->ref, 1);
         ctx->name = pcr_string_copy(name, x);
         ctx->keys = pcr_vector_copy(keys, x);
         ctx->types = pcr_vector_copy(types, x);
-        ctx->values = pcr_vector_new(sizeof (void *), x);
+
+        ctx->ncols = pcr_string_vector_len(keys, x);
+        pcr_assert_range(ctx->ncols == PCR_ATTRIBUTE_VECTOR_LEN(types, x), x);
+
+        /* if a key is repeated, the first column with that key is indexed */
+        ctx->index = pcr_map_new(sizeof (size_t), x);
+        pcr_map_reserve(&ctx->index, ctx->ncols, x);
+        for (size_t i = 1; i <= ctx->ncols; i++) {
+            pcr_string *key = pcr_string_vector_elem(keys, i, x);
+            if (!pcr_map_get_str(ctx->index, key, NULL, x))
+                pcr_map_set_str(&ctx->index, key, &i, x);
+        }
+
+        ctx->rows = ctx->part = 0;
+        ctx->cols = rset_alloc(ctx->ncols, sizeof *ctx->cols, x);
+        for (register size_t i = 0; i < ctx->ncols; i++) {
+            ctx->cols[i].valid = NULL;
+            col_retype(&ctx->cols[i],
+                       PCR_ATTRIBUTE_VECTOR_ELEM(types, i + 1, x), 0, x);
+        }
 
         return ctx;
     }
@@ -54,7 +338,7 @@ pcr_resultset_copy(const pcr_resultset *ctx, pcr_exception ex)
     pcr_assert_handle(ctx, ex);
 
     pcr_resultset *hnd = (pcr_resultset *) ctx;
-    hnd->ref++;
+    pcr_refcount_inc__(&hnd->ref);
 
     return hnd;
 }
@@ -88,13 +372,30 @@ pcr_resultset_keys(const pcr_resultset *ctx, pcr_exception ex)
 }
 
 
+/* Implement the pcr_resultset_values() interface function. The cells are
+ * gathered from the columns into the row-major vector of values of the earlier
+ * row-oriented layout, with a null pointer for each NULL cell. */
 extern pcr_vector *
 pcr_resultset_values(const pcr_resultset *ctx, pcr_exception ex)
 {
     pcr_assert_handle(ctx, ex);
 
     pcr_exception_try (x) {
-        return pcr_vector_copy(ctx->values, x);
+        const size_t len = ctx->rows * ctx->ncols + ctx->part;
+        pcr_vector *values = pcr_vector_new_2(sizeof (void *), len ? len : 1,
+                                              x);
+
+        void *value;
+        for (register size_t i = 0; i < len; i++) {
+            size_t col = i % ctx->ncols;
+            pcr_string *key = pcr_string_vector_elem(ctx->keys, col + 1, x);
+
+            value = pcr_attribute_value(col_attrib(&ctx->cols[col], key,
+                                                   i / ctx->ncols, x), x);
+            pcr_vector_push(&values, &value, x);
+        }
+
+        return values;
     }
 
     pcr_exception_unwind(ex);
@@ -102,17 +403,13 @@ pcr_resultset_values(const pcr_resultset *ctx, pcr_exception ex)
 }
 
 
+/* Implement the pcr_resultset_rows() interface function. A row that has only
+ * been partly pushed is not counted. */
 extern size_t
 pcr_resultset_rows(const pcr_resultset *ctx, pcr_exception ex)
 {
     pcr_assert_handle(ctx, ex);
-
-    pcr_exception_try (x) {
-        return pcr_vector_len(ctx->values, x);
-    }
-
-    pcr_exception_unwind(ex);
-    return 0;
+    return ctx->rows;
 }
 
 
@@ -120,13 +417,7 @@ extern size_t
 pcr_resultset_cols(const pcr_resultset *ctx, pcr_exception ex)
 {
     pcr_assert_handle(ctx, ex);
-
-    pcr_exception_try (x) {
-        return pcr_vector_len(ctx->keys, x);
-    }
-
-    pcr_exception_unwind(ex);
-    return 0;
+    return ctx->ncols;
 }
 
 
@@ -134,65 +425,185 @@ extern size_t
 pcr_resultset_refcount(const pcr_resultset *ctx, pcr_exception ex)
 {
     pcr_assert_handle(ctx, ex);
-    return ctx->ref;
+    return pcr_refcount_get__(&ctx->ref);
+}
+
+
+/* Define the rset_cell_check() helper function. This function checks that the
+ * 1-based @row and @col of @ctx refer to a cell that has been pushed. */
+static inline void
+rset_cell_check(const pcr_resultset *ctx, size_t row, size_t col,
+                pcr_exception ex)
+{
+    pcr_assert_range(row && col && col <= ctx->ncols, ex);
+    pcr_assert_range(row <= ctx->rows || (row == ctx->rows + 1
+                                          && col <= ctx->part), ex);
 }
 
 
+/* Implement the pcr_resultset_attrib() interface function. */
 extern pcr_attribute *
 pcr_resultset_attrib(const pcr_resultset *ctx, size_t row, size_t col,
                      pcr_exception ex)
 {
     pcr_assert_handle(ctx, ex);
-    pcr_assert_state(row * col <= pcr_vector_len(ctx->values, ex), ex);
+    rset_cell_check(ctx, row, col, ex);
 
     pcr_exception_try (x) {
+        /* the key is never modified in place, so the attribute can share it
+         * rather than copy it */
         pcr_string *key = pcr_string_vector_elem(ctx->keys, col, x);
-        PCR_ATTRIBUTE type = PCR_ATTRIBUTE_VECTOR_ELEM(ctx->types, col, x);
-        void **value = pcr_vector_elem(ctx->values, row * col, x);
+        return col_attrib(&ctx->cols[col - 1], key, row - 1, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_resultset_col_index() interface function. */
+extern size_t
+pcr_resultset_col_index(const pcr_resultset *ctx, const pcr_string *key,
+                        pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_string(key, ex);
+
+    size_t col = 0;
+    (void) pcr_map_get_str(ctx->index, key, &col, ex);
+
+    return col;
+}
+
+
+/* Implement the pcr_resultset_attrib_by_key() interface function. */
+extern pcr_attribute *
+pcr_resultset_attrib_by_key(const pcr_resultset *ctx, size_t row,
+                            const pcr_string *key, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        size_t col = pcr_resultset_col_index(ctx, key, x);
+        pcr_assert_range(col, x);
 
-        return pcr_attribute_new(type, key, *value, x);
+        return pcr_resultset_attrib(ctx, row, col, x);
     }
 
     pcr_exception_unwind(ex);
     return NULL;
 }
 
+
+/* Implement the pcr_resultset_null() interface function. */
+extern bool
+pcr_resultset_null(const pcr_resultset *ctx, size_t row, size_t col,
+                   pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    rset_cell_check(ctx, row, col, ex);
+
+    return !col_valid(&ctx->cols[col - 1], row - 1);
+}
+
+
+/* Define the rset_col_vector() helper function. This function returns the
+ * cells of the 1-based column @col of @ctx, which must be of @type. The vector
+ * shares its payload with the column until either is modified. */
+static pcr_vector *
+rset_col_vector(const pcr_resultset *ctx, size_t col, PCR_ATTRIBUTE type,
+                pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_range(col && col <= ctx->ncols, ex);
+    pcr_assert_state(ctx->cols[col - 1].type == type, ex);
+
+    return pcr_vector_copy(ctx->cols[col - 1].data, ex);
+}
+
+
+/* Implement the pcr_resultset_col_i64() interface function. */
+extern pcr_vector *
+pcr_resultset_col_i64(const pcr_resultset *ctx, size_t col, pcr_exception ex)
+{
+    return rset_col_vector(ctx, col, PCR_ATTRIBUTE_INT, ex);
+}
+
+
+/* Implement the pcr_resultset_col_f64() interface function. */
+extern pcr_vector *
+pcr_resultset_col_f64(const pcr_resultset *ctx, size_t col, pcr_exception ex)
+{
+    return rset_col_vector(ctx, col, PCR_ATTRIBUTE_FLOAT, ex);
+}
+
+
+/* Define the attrib_check() helper function. This function checks that @attr
+ * may be stored in the 1-based column @col of @ctx, or in the column that is
+ * next to be pushed if @col is 0. A NULL attribute may be stored in any
+ * column, and a column of type PCR_ATTRIBUTE_NULL, such as one whose type was
+ * not known in advance, takes on the type of the first other attribute that
+ * is stored in it; @retype is set if that is the case. */
 static void
 attrib_check(const pcr_resultset *ctx, const pcr_attribute *attr, size_t col,
-             pcr_exception ex)
+             bool *retype, pcr_exception ex)
 {
     pcr_exception_try (x) {
-        if (!col) {
-            size_t q = pcr_vector_len(ctx->values, x);
-            size_t d = pcr_vector_len(ctx->keys, x);
-            col = (q % d) + 1;
-        }
+        if (!col)
+            col = ctx->part + 1;
+
+        pcr_assert_range(col <= ctx->ncols, x);
 
         pcr_string *lkey = pcr_attribute_key(attr, x);
-        pcr_string *rkey = pcr_vector_elem(ctx->keys, col, x);
+        pcr_string *rkey = pcr_string_vector_elem(ctx->keys, col, x);
         pcr_assert_state(!pcr_string_cmp(lkey, rkey, x), x);
 
         PCR_ATTRIBUTE ltype = pcr_attribute_type(attr, x);
-        PCR_ATTRIBUTE *rtype = pcr_vector_elem(ctx->types, col, x);
-        pcr_assert_state(ltype == *rtype, x);
+        PCR_ATTRIBUTE rtype = ctx->cols[col - 1].type;
+
+        *retype = ltype != PCR_ATTRIBUTE_NULL && rtype == PCR_ATTRIBUTE_NULL;
+        pcr_assert_state(ltype == rtype || ltype == PCR_ATTRIBUTE_NULL
+                         || *retype, x);
     }
 
     pcr_exception_unwind(ex);
 }
 
 
+/* Define the rset_fork() helper function. This function makes a copy of @ctx
+ * if it is shared. The copy shares the column vectors of the original, which
+ * are themselves copied on write. */
 static pcr_resultset *
 rset_fork(pcr_resultset **ctx, pcr_exception ex)
 {
     pcr_exception_try (x) {
         pcr_resultset *hnd = *ctx;
 
-        if (hnd->ref > 1) {
-            hnd->ref--;
+        if (pcr_refcount_get__(&hnd->ref) > 1) {
+            pcr_resultset *frk = pcr_mempool_alloc(sizeof *frk, x);
+
+            pcr_refcount_init__(&frk->ref, 1);
+            frk->name = hnd->name;
+            frk->keys = pcr_vector_copy(hnd->keys, x);
+            frk->index = pcr_map_copy(hnd->index, x);
+            frk->types = pcr_vector_copy(hnd->types, x);
+            frk->ncols = hnd->ncols;
+            frk->rows = hnd->rows;
+            frk->part = hnd->part;
+
+            frk->cols = rset_alloc(frk->ncols, sizeof *frk->cols, x);
+            for (register size_t i = 0; i < frk->ncols; i++) {
+                const struct rset_col *col = &hnd->cols[i];
+
+                frk->cols[i].type = col->type;
+                frk->cols[i].valid = pcr_vector_copy(col->valid, x);
+                frk->cols[i].data = col->data ? pcr_vector_copy(col->data, x)
+                                              : NULL;
+                frk->cols[i].bytes = col->bytes ? pcr_vector_copy(col->bytes,
+                                                                  x)
+                                                : NULL;
+            }
 
-            pcr_resultset *frk = pcr_resultset_new(hnd->name, hnd->keys,
-                                                   hnd->types, x);
-            frk->values = pcr_vector_copy(hnd->values, x);
+            pcr_refcount_dec__(&hnd->ref);
+            *ctx = frk;
         }
 
         return *ctx;
@@ -203,34 +614,87 @@ rset_fork(pcr_resultset **ctx, pcr_exception ex)
 }
 
 
+/* Define the rset_retype() helper function. This function gives the column of
+ * type PCR_ATTRIBUTE_NULL at the 0-based index @col of @ctx the @type of the
+ * first attribute other than NULL stored in it; the cells that are already in
+ * the column are all NULL. */
+static void
+rset_retype(pcr_resultset *ctx, size_t col, PCR_ATTRIBUTE type,
+            pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        size_t len = ctx->rows + (col < ctx->part);
+
+        col_retype(&ctx->cols[col], type, len, x);
+        PCR_ATTRIBUTE_VECTOR_ELEM_SET(&ctx->types, col + 1, type, x);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Implement the pcr_resultset_attrib_set() interface function. */
 extern void
 pcr_resultset_attrib_set(pcr_resultset **ctx, const pcr_attribute *attr,
                          size_t row, size_t col, pcr_exception ex)
 {
     pcr_assert_handle(ctx && *ctx && attr, ex);
-    attrib_check(*ctx, attr, col, ex);
+    rset_cell_check(*ctx, row, col, ex);
+
+    bool retype;
+    attrib_check(*ctx, attr, col, &retype, ex);
 
     pcr_exception_try (x) {
         pcr_resultset *hnd = rset_fork(ctx, x);
-        pcr_vector_setelem(&hnd->values, attr, row * col, x);
+        struct rset_col *cc = &hnd->cols[col - 1];
+
+        if (retype)
+            rset_retype(hnd, col - 1, pcr_attribute_type(attr, x), x);
+
+        bool valid = pcr_attribute_type(attr, x) != PCR_ATTRIBUTE_NULL;
+        col_valid_set(cc, row - 1, valid, x);
+
+        if (cc->data) {
+            uint64_t cell = 0;
+            const void *bytes;
+            size_t len;
+
+            col_cell(cc, attr, &cell, &bytes, &len, x);
+            if (cc->bytes)
+                col_splice(cc, row - 1, bytes, len, x);
+            else
+                pcr_vector_setelem(&cc->data, &cell, row, x);
+        }
     }
 
     pcr_exception_unwind(ex);
 }
 
 
+/* Implement the pcr_resultset_push() interface function. The attribute is
+ * appended to the column that is next in row-major order. */
 extern void
 pcr_resultset_push(pcr_resultset **ctx, const pcr_attribute *attr,
                    pcr_exception ex)
 {
     pcr_assert_handle(ctx && *ctx && attr, ex);
-    attrib_check(*ctx, attr, 0, ex);
+
+    bool retype;
+    attrib_check(*ctx, attr, 0, &retype, ex);
 
     pcr_exception_try (x) {
         pcr_resultset *hnd = rset_fork(ctx, x);
+        const size_t col = hnd->part;
 
-        void *value = pcr_attribute_value(attr, x);
-        pcr_vector_push(&hnd->values, &value, x);
+        if (retype)
+            rset_retype(hnd, col, pcr_attribute_type(attr, x), x);
+
+        col_push(&hnd->cols[col], hnd->rows, attr, x);
+
+        if (++hnd->part == hnd->ncols) {
+            hnd->part = 0;
+            hnd->rows++;
+        }
     }
 
     pcr_exception_unwind(ex);
@@ -257,9 +721,8 @@ extern pcr_string *
 pcr_resultset_json(const pcr_resultset *ctx, pcr_exception ex)
 {
     pcr_exception_try (x) {
-        register size_t items = pcr_vector_len(ctx->values, x);
-        register size_t cols = pcr_vector_len(ctx->keys, x);
-        register size_t rows = items / cols;
+        register size_t cols = ctx->ncols;
+        register size_t rows = ctx->rows;
 
         pcr_string *json = pcr_string_new("{", x);
         json = pcr_string_add(json, ctx->name, x);
@@ -281,7 +744,7 @@ pcr_resultset_json(const pcr_resultset *ctx, pcr_exception ex)
             }
 
             json = pcr_string_add(json, "}", x);
-            if (pcr_hint_unlikely ((r * c) < items))
+            if (pcr_hint_likely (r < rows))
                 json = pcr_string_add(json, ",", x);
         }
 
@@ -292,3 +755,1100 @@ pcr_resultset_json(const pcr_resultset *ctx, pcr_exception ex)
     return NULL;
 }
 
+
+/* Define the rset_gather() helper function. This function returns a new result
+ * set holding the @len rows of @ctx at the 0-based indices @rows, in that
+ * order. Each column is gathered in a single pass into storage allocated up
+ * front, so nothing is allocated per cell. */
+static pcr_resultset *
+rset_gather(const pcr_resultset *ctx, const size_t *rows, size_t len,
+            pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_resultset *gat = pcr_mempool_alloc(sizeof *gat, x);
+
+        pcr_refcount_init__(&gat->ref, 1);
+        gat->name = ctx->name;
+        gat->keys = pcr_vector_copy(ctx->keys, x);
+        gat->index = pcr_map_copy(ctx->index, x);
+        gat->types = pcr_vector_copy(ctx->types, x);
+        gat->ncols = ctx->ncols;
+        gat->rows = len;
+        gat->part = 0;
+        gat->cols = rset_alloc(gat->ncols, sizeof *gat->cols, x);
+
+        const size_t words = (len + RSET_WORD - 1) / RSET_WORD;
+
+        for (register size_t c = 0; c < ctx->ncols; c++) {
+            const struct rset_col *src = &ctx->cols[c];
+            struct rset_col *dst = &gat->cols[c];
+
+            dst->type = src->type;
+            dst->data = dst->bytes = NULL;
+
+            dst->valid = pcr_vector_new_2(sizeof (uint64_t),
+                                          words ? words : 1, x);
+            uint64_t *bits = dst->valid->payload;
+            memset(bits, 0, words * sizeof *bits);
+            for (register size_t i = 0; i < len; i++)
+                bits[i / RSET_WORD] |= (uint64_t) col_valid(src, rows[i])
+                                       << (i % RSET_WORD);
+            dst->valid->len = words;
+
+            if (!src->data)
+                continue;
+
+            const size_t sz = src->data->sz;
+            dst->data = pcr_vector_new_2(sz, len ? len : 1, x);
+            dst->data->len = len;
+
+            if (!src->bytes) {
+                const char *in = src->data->payload;
+                char *out = dst->data->payload;
+
+                for (register size_t i = 0; i < len; i++)
+                    memcpy(out + i * sz, in + rows[i] * sz, sz);
+
+                continue;
+            }
+
+            size_t off, n, total = 0;
+            for (register size_t i = 0; i < len; i++) {
+                col_span(src, rows[i], &off, &n);
+                total += n;
+            }
+
+            dst->bytes = pcr_vector_new_2(1, total ? total : 1, x);
+            dst->bytes->len = total;
+
+            const char *in = src->bytes->payload;
+            char *out = dst->bytes->payload;
+            size_t *ends = dst->data->payload;
+
+            for (register size_t i = 0, at = 0; i < len; i++) {
+                col_span(src, rows[i], &off, &n);
+                memcpy(out + at, in + off, n);
+                ends[i] = at += n;
+            }
+        }
+
+        return gat;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Define the sort_key() helper function. This function maps the numeric cell
+ * in the 0-based @row of @col to an unsigned key with the same order. Integers
+ * have their sign bit flipped; doubles have their sign bit flipped if positive
+ * and all bits flipped if negative, with -0.0 read as 0.0 and NaN ordered below
+ * every other number, as by pcr_attribute_cmp(). */
+static inline uint64_t
+sort_key(const struct rset_col *col, size_t row)
+{
+    const uint64_t sign = (uint64_t) 1 << 63;
+
+    if (col->type == PCR_ATTRIBUTE_INT)
+        return (uint64_t) ((const int64_t *) col->data->payload)[row] ^ sign;
+
+    double val = ((const double *) col->data->payload)[row];
+    if (pcr_hint_unlikely (isnan(val)))
+        return 0;
+    if (val == 0.0)
+        val = 0.0;
+
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof bits);
+
+    return bits & sign ? ~bits : bits | sign;
+}
+
+
+/** @private */
+/* Define the sort_radix struct. This holds the state shared by the workers of
+ * a least significant digit radix sort pass; each worker owns the chunk of the
+ * input between consecutive @bounds, and its own row of @hist, which holds its
+ * counts of each digit and then the output offsets of its elements. */
+struct sort_radix {
+    const uint64_t *kin;
+    const size_t *rin;
+    uint64_t *kout;
+    size_t *rout;
+    size_t (*hist)[256];
+    size_t bounds[PCR_WORKER_MAX + 1];
+    unsigned shift;
+};
+
+
+/* Define the radix_count() helper function. This is the worker task that
+ * counts the digits of the keys in a chunk for the current pass. */
+static void
+radix_count(size_t id, size_t len, void *opt, pcr_exception ex)
+{
+    struct sort_radix *sr = opt;
+    size_t *hist = sr->hist[id];
+
+    (void) len;
+    (void) ex;
+
+    for (register size_t i = sr->bounds[id]; i < sr->bounds[id + 1]; i++)
+        hist[(sr->kin[i] >> sr->shift) & 0xff]++;
+}
+
+
+/* Define the radix_scatter() helper function. This is the worker task that
+ * moves the keys and rows of a chunk to their output offsets for the current
+ * pass; since the chunks are scattered in order, each pass is stable. */
+static void
+radix_scatter(size_t id, size_t len, void *opt, pcr_exception ex)
+{
+    struct sort_radix *sr = opt;
+    size_t *hist = sr->hist[id];
+
+    (void) len;
+    (void) ex;
+
+    for (register size_t i = sr->bounds[id]; i < sr->bounds[id + 1]; i++) {
+        size_t at = hist[(sr->kin[i] >> sr->shift) & 0xff]++;
+
+        sr->kout[at] = sr->kin[i];
+        sr->rout[at] = sr->rin[i];
+    }
+}
+
+
+/* Define the sort_radix() helper function. This function stably sorts the @len
+ * @rows by their @keys, one byte at a time. Passes over bytes that are the same
+ * in every key are skipped. If there are at least PCR_RESULTSET_SORT_THRESHOLD
+ * rows and more than one worker, each pass is split into chunks that are
+ * counted and scattered in parallel. */
+static void
+sort_radix(uint64_t *keys, size_t *rows, size_t len, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        size_t wrk = len >= PCR_RESULTSET_SORT_THRESHOLD ? pcr_worker_count()
+                                                         : 1;
+        struct sort_radix sr = {.kin = keys, .rin = rows};
+
+        sr.kout = rset_alloc(len, sizeof *sr.kout, x);
+        sr.rout = rset_alloc(len, sizeof *sr.rout, x);
+        sr.hist = pcr_mempool_alloc(wrk * sizeof *sr.hist, x);
+
+        for (register size_t i = 0; i <= wrk; i++)
+            sr.bounds[i] = len * i / wrk;
+
+        for (sr.shift = 0; sr.shift < 64; sr.shift += 8) {
+            memset(sr.hist, 0, wrk * sizeof *sr.hist);
+
+            if (wrk > 1)
+                pcr_worker_run(wrk, &radix_count, &sr, x);
+            else
+                radix_count(0, 1, &sr, x);
+
+            bool skip = false;
+            for (register size_t d = 0, at = 0; d < 256; d++) {
+                size_t base = at;
+
+                for (register size_t w = 0; w < wrk; w++) {
+                    size_t n = sr.hist[w][d];
+                    sr.hist[w][d] = at;
+                    at += n;
+                }
+
+                skip = skip || at - base == len;
+            }
+
+            if (skip)
+                continue;
+
+            if (wrk > 1)
+                pcr_worker_run(wrk, &radix_scatter, &sr, x);
+            else
+                radix_scatter(0, 1, &sr, x);
+
+            uint64_t *kswp = (uint64_t *) sr.kin;
+            size_t *rswp = (size_t *) sr.rin;
+            sr.kin = sr.kout;
+            sr.rin = sr.rout;
+            sr.kout = kswp;
+            sr.rout = rswp;
+        }
+
+        if (sr.rin != rows)
+            memcpy(rows, sr.rin, len * sizeof *rows);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the span_cmp() helper function. This function compares the text or
+ * blob cells in the 0-based rows @lhs and @rhs of @col bytewise, with shorter
+ * prefixes first, as by pcr_attribute_cmp(). */
+static inline int
+span_cmp(const struct rset_col *col, size_t lhs, size_t rhs)
+{
+    size_t loff, llen, roff, rlen;
+    col_span(col, lhs, &loff, &llen);
+    col_span(col, rhs, &roff, &rlen);
+
+    const char *bytes = col->bytes->payload;
+    int cmp = memcmp(bytes + loff, bytes + roff, llen < rlen ? llen : rlen);
+
+    return cmp ? cmp : (llen > rlen) - (llen < rlen);
+}
+
+
+/* Define the sort_spans() helper function. This function stably sorts the @len
+ * @rows by their text or blob cells in @col with a bottom-up merge sort, in
+ * descending order if @desc is set. */
+static void
+sort_spans(const struct rset_col *col, size_t *rows, size_t len, bool desc,
+           pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        size_t *src = rows;
+        size_t *dst = rset_alloc(len, sizeof *dst, x);
+
+        for (register size_t w = 1; w < len; w *= 2) {
+            for (register size_t lo = 0; lo < len; lo += 2 * w) {
+                size_t mid = lo + w < len ? lo + w : len;
+                size_t hi = lo + 2 * w < len ? lo + 2 * w : len;
+                register size_t i = lo, j = mid, k = lo;
+
+                while (i < mid && j < hi) {
+                    int cmp = span_cmp(col, src[i], src[j]);
+                    dst[k++] = (desc ? -cmp : cmp) <= 0 ? src[i++] : src[j++];
+                }
+
+                while (i < mid)
+                    dst[k++] = src[i++];
+                while (j < hi)
+                    dst[k++] = src[j++];
+            }
+
+            size_t *swp = src;
+            src = dst;
+            dst = swp;
+        }
+
+        if (src != rows)
+            memcpy(rows, src, len * sizeof *rows);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the sort_pass() helper function. This function stably sorts the @len
+ * row indices in @perm by their cells in @col. NULLs are ordered before every
+ * other value, as in SQLite, and so come first in ascending order and last in
+ * descending order; they are set aside before the other cells are sorted. */
+static void
+sort_pass(const struct rset_col *col, size_t *perm, size_t len, bool desc,
+          pcr_exception ex)
+{
+    if (!len || col->type == PCR_ATTRIBUTE_NULL)
+        return;
+
+    pcr_exception_try (x) {
+        size_t *rows = rset_alloc(len, sizeof *rows, x);
+        size_t *nulls = rset_alloc(len, sizeof *nulls, x);
+        size_t n = 0, m = 0;
+
+        for (register size_t i = 0; i < len; i++) {
+            if (col_valid(col, perm[i]))
+                rows[n++] = perm[i];
+            else
+                nulls[m++] = perm[i];
+        }
+
+        if (col->bytes)
+            sort_spans(col, rows, n, desc, x);
+        else {
+            uint64_t *keys = rset_alloc(n, sizeof *keys, x);
+            for (register size_t i = 0; i < n; i++)
+                keys[i] = desc ? ~sort_key(col, rows[i]) : sort_key(col,
+                                                                    rows[i]);
+
+            sort_radix(keys, rows, n, x);
+        }
+
+        memcpy(perm + (desc ? 0 : m), rows, n * sizeof *perm);
+        memcpy(perm + (desc ? n : 0), nulls, m * sizeof *perm);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Implement the pcr_resultset_sort() interface function. The permutation that
+ * sorts the rows is computed first, sorting by the last of @cols and then by
+ * each one before it in turn; since each pass is stable, the earlier columns
+ * take precedence. The permutation is then applied to the whole result set at
+ * once by gathering each column. */
+extern void
+pcr_resultset_sort(pcr_resultset **ctx, const size_t *cols,
+                   const PCR_RESULTSET_ORDER *dirs, size_t len,
+                   pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx && cols, ex);
+    pcr_assert_range(len, ex);
+    pcr_assert_state(!(*ctx)->part, ex);
+
+    for (register size_t i = 0; i < len; i++)
+        pcr_assert_range(cols[i] && cols[i] <= (*ctx)->ncols, ex);
+
+    pcr_exception_try (x) {
+        pcr_resultset *hnd = *ctx;
+        const size_t rows = hnd->rows;
+
+        size_t *perm = rset_alloc(rows, sizeof *perm, x);
+        for (register size_t i = 0; i < rows; i++)
+            perm[i] = i;
+
+        for (register size_t i = len; i-- > 0;) {
+            bool desc = dirs && dirs[i] == PCR_RESULTSET_DESC;
+            sort_pass(&hnd->cols[cols[i] - 1], perm, rows, desc, x);
+        }
+
+        *ctx = rset_gather(hnd, perm, rows, x);
+        pcr_refcount_dec__(&hnd->ref);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the json_prefixes() helper function. This function renders the key
+ * of each column of @ctx as an escaped JSON object member prefix, so that the
+ * keys are escaped once rather than once per row. */
+static pcr_string **
+json_prefixes(const pcr_resultset *ctx, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_string **pfx = rset_alloc(ctx->ncols, sizeof *pfx, x);
+
+        for (register size_t i = 0; i < ctx->ncols; i++) {
+            pcr_string *key = pcr_string_vector_elem(ctx->keys, i + 1, x);
+            pcr_json_writer *jw = pcr_json_writer_new(x);
+
+            pcr_json_writer_text(jw, key, strlen(key), x);
+            pcr_json_writer_raw(jw, ":", 1, x);
+            pfx[i] = pcr_json_writer_string(jw, x);
+        }
+
+        return pfx;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Define the json_hex() helper function. This function writes the @len bytes
+ * at @data as a JSON string of hexadecimal digits, in chunks staged on the
+ * stack. Hexadecimal digits never need escaping. */
+static void
+json_hex(pcr_json_writer *jw, const unsigned char *data, size_t len,
+         pcr_exception ex)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    pcr_exception_try (x) {
+        char hex[128];
+        pcr_json_writer_raw(jw, "\"", 1, x);
+
+        for (register size_t i = 0, n; i < len; i += n) {
+            n = len - i < sizeof hex / 2 ? len - i : sizeof hex / 2;
+
+            for (register size_t j = 0; j < n; j++) {
+                hex[j * 2] = digits[data[i + j] >> 4];
+                hex[j * 2 + 1] = digits[data[i + j] & 0xf];
+            }
+
+            pcr_json_writer_raw(jw, hex, n * 2, x);
+        }
+
+        pcr_json_writer_raw(jw, "\"", 1, x);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the json_cell() helper function. This function writes the 0-based
+ * @row of @col as its native JSON type, straight from the column storage. */
+static inline void
+json_cell(pcr_json_writer *jw, const struct rset_col *col, size_t row,
+          pcr_exception ex)
+{
+    if (!col_valid(col, row)) {
+        pcr_json_writer_null(jw, ex);
+        return;
+    }
+
+    size_t off, len;
+    const char *bytes = col->bytes ? col->bytes->payload : NULL;
+
+    switch (col->type) {
+        case PCR_ATTRIBUTE_INT:
+            pcr_json_writer_int(jw, ((const int64_t *) col->data->payload)[row],
+                                ex);
+            break;
+
+        case PCR_ATTRIBUTE_FLOAT:
+            pcr_json_writer_float(jw,
+                                  ((const double *) col->data->payload)[row],
+                                  ex);
+            break;
+
+        case PCR_ATTRIBUTE_TEXT:
+            col_span(col, row, &off, &len);
+            pcr_json_writer_text(jw, bytes + off, len, ex);
+            break;
+
+        case PCR_ATTRIBUTE_BLOB:
+            col_span(col, row, &off, &len);
+            json_hex(jw, (const unsigned char *) bytes + off, len, ex);
+            break;
+
+        default:
+            pcr_json_writer_null(jw, ex);
+            break;
+    }
+}
+
+
+/* Implement the pcr_resultset_json_write() interface function. The rows are
+ * written one at a time, cell by cell from the columns, through a writer with
+ * a bounded buffer; nothing is allocated per row or per cell, and the memory
+ * used doesn't depend on the size of @ctx. Rows that have only been partly
+ * pushed are not written. */
+extern size_t
+pcr_resultset_json_write(const pcr_resultset *ctx, FILE *file,
+                         PCR_RESULTSET_JSON opts, pcr_exception ex)
+{
+    pcr_assert_handle(ctx && file, ex);
+
+    pcr_exception_try (x) {
+        const bool arrays = opts & PCR_RESULTSET_JSON_ARRAYS;
+        const bool lines = opts & PCR_RESULTSET_JSON_LINES;
+
+        pcr_json_writer *jw = pcr_json_writer_new_2(file, x);
+        pcr_string **pfx = arrays ? NULL : json_prefixes(ctx, x);
+
+        if (!lines) {
+            pcr_json_writer_raw(jw, "{", 1, x);
+            pcr_json_writer_text(jw, ctx->name, strlen(ctx->name), x);
+            pcr_json_writer_raw(jw, ":[", 2, x);
+        }
+
+        for (register size_t r = 0; r < ctx->rows; r++) {
+            if (r && !lines)
+                pcr_json_writer_raw(jw, ",", 1, x);
+
+            pcr_json_writer_raw(jw, arrays ? "[" : "{", 1, x);
+
+            for (register size_t c = 0; c < ctx->ncols; c++) {
+                if (c)
+                    pcr_json_writer_raw(jw, ",", 1, x);
+                if (!arrays)
+                    pcr_json_writer_raw(jw, pfx[c], strlen(pfx[c]), x);
+
+                json_cell(jw, &ctx->cols[c], r, x);
+            }
+
+            pcr_json_writer_raw(jw, arrays ? "]" : "}", 1, x);
+            if (lines)
+                pcr_json_writer_raw(jw, "\n", 1, x);
+        }
+
+        if (!lines)
+            pcr_json_writer_raw(jw, "]}", 2, x);
+
+        pcr_json_writer_flush(jw, x);
+        return pcr_json_writer_len(jw, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return 0;
+}
+
+
+/* Define the number of cells gathered into each batch by the aggregate
+ * operators before being handed over to the SIMD kernels. */
+#define RSET_BATCH 1024
+
+
+/* Define the word_ctz() and word_popcount() helper functions. These functions
+ * return the number of trailing zero bits, and the number of set bits, of the
+ * validity bitmap word @word; word_ctz() requires @word to be non-zero. */
+static inline unsigned
+word_ctz(uint64_t word)
+{
+#if (defined __GNUC__ || defined __clang__)
+    return (unsigned) __builtin_ctzll(word);
+#else
+    unsigned n = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        n++;
+    }
+
+    return n;
+#endif
+}
+
+static inline size_t
+word_popcount(uint64_t word)
+{
+#if (defined __GNUC__ || defined __clang__)
+    return (size_t) __builtin_popcountll(word);
+#else
+    size_t n = 0;
+    for (; word; word &= word - 1)
+        n++;
+
+    return n;
+#endif
+}
+
+
+/* Define the col_word() helper function. This function returns the validity
+ * bitmap word @w of @col, with the bits past the first @rows cleared so that
+ * the cells of a partly pushed row are left out. */
+static inline uint64_t
+col_word(const struct rset_col *col, size_t w, size_t rows)
+{
+    uint64_t word = ((const uint64_t *) col->valid->payload)[w];
+    size_t tail = rows - w * RSET_WORD;
+
+    return tail < RSET_WORD ? word & (((uint64_t) 1 << tail) - 1) : word;
+}
+
+
+/* Define the col_count() helper function. This function counts the cells that
+ * are not NULL in the first @rows rows of @col. */
+static size_t
+col_count(const struct rset_col *col, size_t rows)
+{
+    size_t n = 0;
+
+    for (register size_t w = 0; w * RSET_WORD < rows; w++)
+        n += word_popcount(col_word(col, w, rows));
+
+    return n;
+}
+
+
+/* Define the sel_rows() helper function. This function checks the selection
+ * vector @sel of 1-based row indices of @ctx, and returns the equivalent array
+ * of 0-based row indices. An empty selection yields a non-NULL empty array,
+ * since callers take a NULL array to mean every row. */
+static const size_t *
+sel_rows(const pcr_resultset *ctx, const pcr_vector *sel, pcr_exception ex)
+{
+    static const size_t none[1];
+
+    pcr_assert_state(sel->sz == sizeof (size_t), ex);
+
+    if (!sel->len)
+        return none;
+
+    pcr_exception_try (x) {
+        const size_t *idx = sel->payload;
+        size_t *rows = rset_alloc(sel->len, sizeof *rows, x);
+
+        for (register size_t i = 0; i < sel->len; i++) {
+            pcr_assert_range(idx[i] && idx[i] <= ctx->rows, x);
+            rows[i] = idx[i] - 1;
+        }
+
+        return rows;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/** @private */
+/* Define the filter_val struct. This holds the value that the cells of a
+ * column are compared against by pcr_resultset_filter(), unpacked from its
+ * attribute once so that no accessor is called per cell. */
+struct filter_val {
+    PCR_ATTRIBUTE type;
+    int64_t i;
+    double f;
+    const char *bytes;
+    size_t len;
+};
+
+
+/* Define the filter_cmp() helper function. This function compares the cell in
+ * the 0-based @row of @col, which must not be NULL, with @val in the same way
+ * as pcr_attribute_cmp(). */
+static inline int
+filter_cmp(const struct rset_col *col, size_t row, const struct filter_val *val)
+{
+    int lrank = pcr_attribute_rank__(col->type);
+    int rrank = pcr_attribute_rank__(val->type);
+    if (lrank != rrank)
+        return (lrank > rrank) - (lrank < rrank);
+
+    if (col->type == PCR_ATTRIBUTE_INT) {
+        int64_t cell = ((const int64_t *) col->data->payload)[row];
+
+        if (val->type == PCR_ATTRIBUTE_FLOAT)
+            return pcr_attribute_cmp_i64_f64__(cell, val->f);
+
+        return (cell > val->i) - (cell < val->i);
+    }
+
+    if (col->type == PCR_ATTRIBUTE_FLOAT) {
+        double cell = ((const double *) col->data->payload)[row];
+
+        if (val->type == PCR_ATTRIBUTE_INT)
+            return -pcr_attribute_cmp_i64_f64__(val->i, cell);
+
+        return pcr_attribute_cmp_f64__(cell, val->f);
+    }
+
+    size_t off, len;
+    col_span(col, row, &off, &len);
+
+    const char *bytes = col->bytes->payload;
+    int cmp = memcmp(bytes + off, val->bytes, len < val->len ? len : val->len);
+
+    return cmp ? (cmp > 0) - (cmp < 0) : (len > val->len) - (len < val->len);
+}
+
+
+/* Define the filter_match() helper function. This function checks whether the
+ * result @cmp of a three-way comparison satisfies the predicate @op. */
+static inline bool
+filter_match(int cmp, PCR_VECTOR_CMP op)
+{
+    switch (op) {
+        case PCR_VECTOR_CMP_EQ: return !cmp; break;
+        case PCR_VECTOR_CMP_NE: return cmp; break;
+        case PCR_VECTOR_CMP_LT: return cmp < 0; break;
+        case PCR_VECTOR_CMP_LE: return cmp <= 0; break;
+        case PCR_VECTOR_CMP_GT: return cmp > 0; break;
+        default: return cmp >= 0; break;
+    }
+}
+
+
+/* Implement the pcr_resultset_filter() interface function. The selection
+ * vector holds the 1-based indices of the matching rows, as returned by
+ * pcr_vector_select_i64(); if @sel is given, only the rows it selects are
+ * tested, so that predicates can be chained. NULL cells never match, as in
+ * SQL. Integer columns compared with integers are scanned by the SIMD select
+ * kernel, and other columns a bitmap word at a time, skipping NULLs. */
+extern pcr_vector *
+pcr_resultset_filter(const pcr_resultset *ctx, size_t col, PCR_VECTOR_CMP cmp,
+                     const pcr_attribute *val, const pcr_vector *sel,
+                     pcr_exception ex)
+{
+    pcr_assert_handle(ctx && val, ex);
+    pcr_assert_range(col && col <= ctx->ncols, ex);
+
+    pcr_exception_try (x) {
+        const struct rset_col *cc = &ctx->cols[col - 1];
+        const size_t rows = ctx->rows;
+        const size_t len = sel ? pcr_vector_len(sel, x) : rows;
+
+        pcr_vector *out = pcr_vector_new_2(sizeof (size_t), len ? len : 1, x);
+        size_t *res = out->payload;
+        size_t n = 0;
+
+        struct filter_val fv = {.type = pcr_attribute_type(val, x)};
+        if (fv.type == PCR_ATTRIBUTE_INT)
+            fv.i = pcr_attribute_int(val, x);
+        else if (fv.type == PCR_ATTRIBUTE_FLOAT)
+            fv.f = pcr_attribute_float(val, x);
+        else if (fv.type == PCR_ATTRIBUTE_TEXT) {
+            fv.bytes = pcr_attribute_text_ref(val, x);
+            fv.len = strlen(fv.bytes);
+        } else if (fv.type == PCR_ATTRIBUTE_BLOB) {
+            pcr_blob blob = pcr_attribute_blob(val, x);
+            fv.bytes = blob.data;
+            fv.len = blob.len;
+        }
+
+        if (fv.type == PCR_ATTRIBUTE_NULL || cc->type == PCR_ATTRIBUTE_NULL)
+            ;
+        else if (sel) {
+            const size_t *rsel = sel_rows(ctx, sel, x);
+
+            for (register size_t i = 0; i < len; i++) {
+                if (col_valid(cc, rsel[i])
+                    && filter_match(filter_cmp(cc, rsel[i], &fv), cmp))
+                    res[n++] = rsel[i] + 1;
+            }
+        } else if (cc->type == PCR_ATTRIBUTE_INT
+                   && fv.type == PCR_ATTRIBUTE_INT) {
+            n = pcr_simd_select_i64__(cc->data->payload, rows, cmp, fv.i, res);
+
+            /* the slots of NULL cells hold 0, which may have matched */
+            if (col_count(cc, rows) != rows) {
+                register size_t m = 0;
+                for (register size_t i = 0; i < n; i++) {
+                    if (col_valid(cc, res[i] - 1))
+                        res[m++] = res[i];
+                }
+
+                n = m;
+            }
+        } else {
+            for (register size_t w = 0; w * RSET_WORD < rows; w++) {
+                for (uint64_t word = col_word(cc, w, rows); word;
+                     word &= word - 1) {
+                    size_t row = w * RSET_WORD + word_ctz(word);
+                    if (filter_match(filter_cmp(cc, row, &fv), cmp))
+                        res[n++] = row + 1;
+                }
+            }
+        }
+
+        out->len = n;
+        out->sorted = !sel || sel->sorted;
+        return out;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_resultset_take() interface function. */
+extern pcr_resultset *
+pcr_resultset_take(const pcr_resultset *ctx, const pcr_vector *sel,
+                   pcr_exception ex)
+{
+    pcr_assert_handle(ctx && sel, ex);
+
+    pcr_exception_try (x) {
+        return rset_gather(ctx, sel_rows(ctx, sel, x), sel->len, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_resultset_project() interface function. The projection
+ * shares the storage of the selected columns with @ctx, so nothing is copied
+ * until either of them is modified. */
+extern pcr_resultset *
+pcr_resultset_project(const pcr_resultset *ctx, const size_t *cols, size_t len,
+                      pcr_exception ex)
+{
+    pcr_assert_handle(ctx && cols, ex);
+    pcr_assert_range(len, ex);
+    pcr_assert_state(!ctx->part, ex);
+
+    for (register size_t i = 0; i < len; i++)
+        pcr_assert_range(cols[i] && cols[i] <= ctx->ncols, ex);
+
+    pcr_exception_try (x) {
+        pcr_string_vector *keys = pcr_string_vector_new(x);
+        PCR_ATTRIBUTE_VECTOR *types = PCR_ATTRIBUTE_VECTOR_NEW(x);
+
+        for (register size_t i = 0; i < len; i++) {
+            pcr_string_vector_push(&keys, pcr_string_vector_elem(ctx->keys,
+                                                                 cols[i], x),
+                                   x);
+            PCR_ATTRIBUTE_VECTOR_PUSH(&types, ctx->cols[cols[i] - 1].type, x);
+        }
+
+        pcr_resultset *prj = pcr_resultset_new(ctx->name, keys, types, x);
+        prj->rows = ctx->rows;
+
+        for (register size_t i = 0; i < len; i++) {
+            const struct rset_col *col = &ctx->cols[cols[i] - 1];
+
+            prj->cols[i].valid = pcr_vector_copy(col->valid, x);
+            prj->cols[i].data = col->data ? pcr_vector_copy(col->data, x)
+                                          : NULL;
+            prj->cols[i].bytes = col->bytes ? pcr_vector_copy(col->bytes, x)
+                                            : NULL;
+        }
+
+        return prj;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/** @private */
+/* Define the agg_acc struct. This accumulates the number @n of cells that
+ * have been aggregated, along with their sum, minimum and maximum. */
+struct agg_acc {
+    size_t n;
+    int64_t isum, imin, imax;
+    double fsum, fmin, fmax;
+};
+
+
+/* Define the agg_batch() helper function. This function folds the @len dense
+ * numeric cells at @arr into @acc with the SIMD kernels, computing only what
+ * @agg needs. */
+static void
+agg_batch(const struct rset_col *col, const void *arr, size_t len,
+          PCR_RESULTSET_AGG agg, struct agg_acc *acc)
+{
+    if (!len)
+        return;
+
+    const bool first = !acc->n;
+    acc->n += len;
+
+    if (col->type == PCR_ATTRIBUTE_INT) {
+        if (agg == PCR_RESULTSET_SUM || agg == PCR_RESULTSET_AVG)
+            acc->isum += pcr_simd_sum_i64__(arr, len);
+        else if (agg == PCR_RESULTSET_MIN) {
+            int64_t min = pcr_simd_minmax_i64__(arr, len, false);
+            acc->imin = first || min < acc->imin ? min : acc->imin;
+        } else if (agg == PCR_RESULTSET_MAX) {
+            int64_t max = pcr_simd_minmax_i64__(arr, len, true);
+            acc->imax = first || max > acc->imax ? max : acc->imax;
+        }
+    } else {
+        if (agg == PCR_RESULTSET_SUM || agg == PCR_RESULTSET_AVG)
+            acc->fsum += pcr_simd_sum_f64__(arr, len);
+        else if (agg == PCR_RESULTSET_MIN) {
+            double min = pcr_simd_minmax_f64__(arr, len, false);
+            acc->fmin = first || min < acc->fmin ? min : acc->fmin;
+        } else if (agg == PCR_RESULTSET_MAX) {
+            double max = pcr_simd_minmax_f64__(arr, len, true);
+            acc->fmax = first || max > acc->fmax ? max : acc->fmax;
+        }
+    }
+}
+
+
+/* Define the agg_scan() helper function. This function aggregates the cells
+ * of the numeric column @col that are not NULL, either in the first @rows rows
+ * or, if @sel is set, in the @len rows at the 0-based indices @sel. A column
+ * without NULLs is handed to the kernels as it is; otherwise, the cells are
+ * gathered into batches of RSET_BATCH, except that complete bitmap words are
+ * still passed straight through. */
+static void
+agg_scan(const struct rset_col *col, size_t rows, const size_t *sel,
+         size_t len, PCR_RESULTSET_AGG agg, struct agg_acc *acc)
+{
+    const char *data = col->data->payload;
+    const size_t sz = col->data->sz;
+
+    if (!sel && col_count(col, rows) == rows) {
+        agg_batch(col, data, rows, agg, acc);
+        return;
+    }
+
+    union {
+        int64_t i[RSET_BATCH];
+        double f[RSET_BATCH];
+    } buf;
+    size_t n = 0;
+
+    if (sel) {
+        for (register size_t i = 0; i < len; i++) {
+            if (!col_valid(col, sel[i]))
+                continue;
+
+            memcpy(&buf.i[n++], data + sel[i] * sz, sz);
+            if (n == RSET_BATCH) {
+                agg_batch(col, &buf, n, agg, acc);
+                n = 0;
+            }
+        }
+    } else {
+        for (register size_t w = 0; w * RSET_WORD < rows; w++) {
+            uint64_t word = col_word(col, w, rows);
+
+            if (word == ~(uint64_t) 0) {
+                agg_batch(col, data + w * RSET_WORD * sz, RSET_WORD, agg, acc);
+                continue;
+            }
+
+            for (; word; word &= word - 1) {
+                size_t row = w * RSET_WORD + word_ctz(word);
+
+                memcpy(&buf.i[n++], data + row * sz, sz);
+                if (n == RSET_BATCH) {
+                    agg_batch(col, &buf, n, agg, acc);
+                    n = 0;
+                }
+            }
+        }
+    }
+
+    agg_batch(col, &buf, n, agg, acc);
+}
+
+
+/* Define the agg_spans() helper function. This function returns the 0-based
+ * row of the least, or if @max is set the greatest, text or blob cell of @col
+ * that is not NULL, either in the first @rows rows or in the @len rows at the
+ * 0-based indices @sel; @rows is returned if there are no such cells. */
+static size_t
+agg_spans(const struct rset_col *col, size_t rows, const size_t *sel,
+          size_t len, bool max)
+{
+    size_t best = rows;
+
+    for (register size_t i = 0; i < (sel ? len : rows); i++) {
+        size_t row = sel ? sel[i] : i;
+        if (!col_valid(col, row))
+            continue;
+
+        int cmp = best == rows ? 0 : span_cmp(col, row, best);
+        if (best == rows || (max ? cmp > 0 : cmp < 0))
+            best = row;
+    }
+
+    return best;
+}
+
+
+/* Define the agg_attrib() helper function. This function computes the
+ * aggregate @agg of the column @col of @ctx over the rows selected by @sel, or
+ * all rows if @sel is NULL, as an attribute keyed @key. As in SQL, NULL cells
+ * are ignored, and every aggregate other than a count is NULL if there are no
+ * cells left to aggregate. */
+static pcr_attribute *
+agg_attrib(const pcr_resultset *ctx, size_t col, PCR_RESULTSET_AGG agg,
+           const size_t *sel, size_t len, const pcr_string *key,
+           pcr_exception ex)
+{
+    const struct rset_col *cc = &ctx->cols[col - 1];
+    const bool bytes = cc->bytes;
+
+    pcr_assert_state(!bytes || agg == PCR_RESULTSET_COUNT
+                     || agg == PCR_RESULTSET_MIN || agg == PCR_RESULTSET_MAX,
+                     ex);
+
+    pcr_exception_try (x) {
+        if (agg == PCR_RESULTSET_COUNT) {
+            size_t n = 0;
+
+            if (!sel)
+                n = col_count(cc, ctx->rows);
+            else {
+                for (register size_t i = 0; i < len; i++)
+                    n += col_valid(cc, sel[i]);
+            }
+
+            return pcr_attribute_new_int(key, (int64_t) n, x);
+        }
+
+        if (cc->type == PCR_ATTRIBUTE_NULL)
+            return pcr_attribute_new_null(key, x);
+
+        if (bytes) {
+            size_t row = agg_spans(cc, ctx->rows, sel, len,
+                                   agg == PCR_RESULTSET_MAX);
+            if (row == ctx->rows)
+                return pcr_attribute_new_null(key, x);
+
+            return col_attrib(cc, pcr_string_copy(key, x), row, x);
+        }
+
+        struct agg_acc acc = {0};
+        agg_scan(cc, ctx->rows, sel, len, agg, &acc);
+
+        if (!acc.n)
+            return pcr_attribute_new_null(key, x);
+
+        const bool i64 = cc->type == PCR_ATTRIBUTE_INT;
+        switch (agg) {
+            case PCR_RESULTSET_SUM:
+                return i64 ? pcr_attribute_new_int(key, acc.isum, x)
+                           : pcr_attribute_new_float(key, acc.fsum, x);
+                break;
+
+            case PCR_RESULTSET_MIN:
+                return i64 ? pcr_attribute_new_int(key, acc.imin, x)
+                           : pcr_attribute_new_float(key, acc.fmin, x);
+                break;
+
+            case PCR_RESULTSET_MAX:
+                return i64 ? pcr_attribute_new_int(key, acc.imax, x)
+                           : pcr_attribute_new_float(key, acc.fmax, x);
+                break;
+
+            default:
+                return pcr_attribute_new_float(key, (i64 ? (double) acc.isum
+                                                         : acc.fsum)
+                                                    / (double) acc.n, x);
+                break;
+        }
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_resultset_aggregate() interface function. The result set
+ * returned has a single row, with one column for each aggregate keyed as in
+ * SQL, for example "sum(attempts)". Counts are integers, sums and extremes
+ * have the type of their column, and averages are floating point numbers. */
+extern pcr_resultset *
+pcr_resultset_aggregate(const pcr_resultset *ctx, const size_t *cols,
+                        const PCR_RESULTSET_AGG *aggs, size_t len,
+                        const pcr_vector *sel, pcr_exception ex)
+{
+    static const char *names[] = {"count(", "sum(", "min(", "max(", "avg("};
+
+    pcr_assert_handle(ctx && cols && aggs, ex);
+    pcr_assert_range(len, ex);
+
+    for (register size_t i = 0; i < len; i++) {
+        pcr_assert_range(cols[i] && cols[i] <= ctx->ncols, ex);
+        pcr_assert_range(aggs[i] <= PCR_RESULTSET_AVG, ex);
+    }
+
+    pcr_exception_try (x) {
+        const size_t *rsel = sel ? sel_rows(ctx, sel, x) : NULL;
+        const size_t slen = sel ? sel->len : 0;
+
+        pcr_string_vector *keys = pcr_string_vector_new(x);
+        PCR_ATTRIBUTE_VECTOR *types = PCR_ATTRIBUTE_VECTOR_NEW(x);
+        pcr_attribute_vector *row = pcr_attribute_vector_new(x);
+
+        for (register size_t i = 0; i < len; i++) {
+            pcr_string *key = pcr_string_new(names[aggs[i]], x);
+            key = pcr_string_add(key, pcr_string_vector_elem(ctx->keys,
+                                                             cols[i], x), x);
+            key = pcr_string_add(key, ")", x);
+
+            PCR_ATTRIBUTE type = ctx->cols[cols[i] - 1].type;
+            if (aggs[i] == PCR_RESULTSET_COUNT)
+                type = PCR_ATTRIBUTE_INT;
+            else if (aggs[i] == PCR_RESULTSET_AVG)
+                type = PCR_ATTRIBUTE_FLOAT;
+
+            pcr_string_vector_push(&keys, key, x);
+            PCR_ATTRIBUTE_VECTOR_PUSH(&types, type, x);
+            pcr_attribute_vector_push_take(&row, agg_attrib(ctx, cols[i],
+                                                            aggs[i], rsel,
+                                                            slen, key, x), x);
+        }
+
+        pcr_resultset *agg = pcr_resultset_new(ctx->name, keys, types, x);
+        pcr_resultset_push_2(&agg, row, x);
+
+        return agg;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
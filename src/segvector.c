@@ -0,0 +1,268 @@
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "./api.h"
+
+
+/* Define the number of elements in the first segment, and its base 2 log. Each
+ * segment after the first is twice as large as the one before, and so the
+ * segments of a vector with n elements number O(log n). */
+#define SEG_BASE_LOG 5
+#define SEG_BASE ((size_t) 1 << SEG_BASE_LOG)
+
+
+/* Define the maximum number of segments; this is far more than can ever be
+ * allocated, and lets the segment table be a fixed size array. */
+#define SEG_MAX 48
+
+
+/** @private */
+/* Define the pcr_segvector struct; this structure was forward-declared in the
+ * API header file as an abstract data type. Each segment starts with a ready
+ * flag for each of its slots, followed by the slots themselves; a slot is
+ * reserved by @reserved, written, and then flagged as ready. The @committed
+ * watermark is the length of the prefix of slots that are all ready. */
+struct pcr_segvector {
+    _Atomic(char *) seg[SEG_MAX]; /* segments, allocated on demand */
+    atomic_size_t reserved;       /* number of slots reserved      */
+    atomic_size_t committed;      /* number of slots published     */
+    size_t sz;                    /* size of each element          */
+};
+
+
+/* Define the seg_locate() helper function. This function maps a 0-based index
+ * @idx to the segment @k holding it and the 0-based offset @off within that
+ * segment. */
+static inline void
+seg_locate(size_t idx, size_t *k, size_t *off)
+{
+    size_t j = idx + SEG_BASE, msb = 0;
+
+#if (defined __GNUC__ || defined __clang__)
+    msb = sizeof (unsigned long long) * 8 - 1
+          - (size_t) __builtin_clzll((unsigned long long) j);
+#else
+    while (j >> (msb + 1))
+        msb++;
+#endif
+
+    *k = msb - SEG_BASE_LOG;
+    *off = j - ((size_t) 1 << msb);
+}
+
+
+/* Define the seg_len() helper function. This function returns the number of
+ * slots in the segment @k. */
+static inline size_t
+seg_len(size_t k)
+{
+    return SEG_BASE << k;
+}
+
+
+/* Define the seg_flags(), seg_offset() and seg_slots() helper functions. These
+ * functions return the ready flags, the byte offset of the first slot, and the
+ * first slot of the segment @k starting at @seg; the slots are placed after the
+ * flags, suitably aligned. */
+static inline atomic_uchar *
+seg_flags(char *seg)
+{
+    return (atomic_uchar *) seg;
+}
+
+static inline size_t
+seg_offset(size_t k)
+{
+    const size_t align = _Alignof (max_align_t);
+    return (seg_len(k) * sizeof (atomic_uchar) + align - 1) / align * align;
+}
+
+static inline char *
+seg_slots(char *seg, size_t k)
+{
+    return seg + seg_offset(k);
+}
+
+
+/* Define the seg_get() helper function. This function returns segment @k of
+ * @ctx, allocating it if required, and throws PCR_EXCEPTION_RANGE if the size of
+ * the segment would overflow. Producers may race to allocate the same
+ * segment; only one of them wins, and the allocations of the others are left
+ * to the garbage collector. */
+static char *
+seg_get(pcr_segvector *ctx, size_t k, pcr_exception ex)
+{
+    char *seg = atomic_load_explicit(&ctx->seg[k], memory_order_acquire);
+    if (pcr_hint_likely (seg))
+        return seg;
+
+    pcr_assert_range(seg_len(k) <= (SIZE_MAX - seg_offset(k)) / ctx->sz, ex);
+
+    pcr_exception_try (x) {
+        char *tmp = NULL;
+        char *alloc = pcr_mempool_alloc(seg_offset(k) + seg_len(k) * ctx->sz,
+                                        x);
+
+        if (atomic_compare_exchange_strong_explicit(&ctx->seg[k], &tmp, alloc,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire))
+            return alloc;
+
+        return tmp;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Define the seg_ready() helper function. This function checks whether the
+ * slot at the 0-based index @idx of @ctx has been written. */
+static inline bool
+seg_ready(const pcr_segvector *ctx, size_t idx)
+{
+    size_t k, off;
+    seg_locate(idx, &k, &off);
+
+    char *seg = atomic_load(&((pcr_segvector *) ctx)->seg[k]);
+    return seg && atomic_load(&seg_flags(seg)[off]);
+}
+
+
+/* Define the seg_advance() helper function. This function moves the committed
+ * watermark of @ctx past every consecutive ready slot. Any thread may help to
+ * advance the watermark, so a producer never waits on another; a producer that
+ * is stalled between reserving and writing its slot only holds back the
+ * watermark, and the producer that writes the last slot before it is the one
+ * that will move it along. The sequentially consistent flag store and loads
+ * ensure that two producers can't both miss each other's ready slots. */
+static size_t
+seg_advance(pcr_segvector *ctx)
+{
+    size_t c = atomic_load(&ctx->committed);
+
+    while (c < atomic_load(&ctx->reserved) && seg_ready(ctx, c)) {
+        if (atomic_compare_exchange_weak(&ctx->committed, &c, c + 1))
+            c++;
+    }
+
+    return c;
+}
+
+
+/* Implement the pcr_segvector_new() interface function. */
+extern pcr_segvector *
+pcr_segvector_new(size_t elemsz, pcr_exception ex)
+{
+    pcr_assert_range(elemsz, ex);
+
+    pcr_exception_try (x) {
+        pcr_segvector *ctx = pcr_mempool_alloc(sizeof *ctx, x);
+
+        ctx->sz = elemsz;
+        atomic_init(&ctx->reserved, 0);
+        atomic_init(&ctx->committed, 0);
+        for (register size_t k = 0; k < SEG_MAX; k++)
+            atomic_init(&ctx->seg[k], NULL);
+
+        return ctx;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Implement the pcr_segvector_push() interface function. A slot is reserved
+ * with a compare-and-swap on a single counter, so producers contend only on
+ * that counter; the element is then copied into the slot, which never moves,
+ * and published. The segment holding the slot is allocated before the slot is
+ * reserved, since a reserved slot that is never published would hold back the
+ * watermark, and so hide every later element, for good. */
+extern size_t
+pcr_segvector_push(pcr_segvector *ctx, const void *elem, pcr_exception ex)
+{
+    pcr_assert_handle(ctx && elem, ex);
+
+    pcr_exception_try (x) {
+        size_t idx = atomic_load_explicit(&ctx->reserved, memory_order_relaxed);
+        size_t k, off;
+        char *seg;
+
+        do {
+            seg_locate(idx, &k, &off);
+            pcr_assert_range(k < SEG_MAX, x);
+            seg = seg_get(ctx, k, x);
+        } while (!atomic_compare_exchange_weak_explicit(&ctx->reserved, &idx,
+                                                        idx + 1,
+                                                        memory_order_relaxed,
+                                                        memory_order_relaxed));
+
+        memcpy(seg_slots(seg, k) + off * ctx->sz, elem, ctx->sz);
+        atomic_store(&seg_flags(seg)[off], 1);
+
+        (void) seg_advance(ctx);
+        return idx + 1;
+    }
+
+    pcr_exception_unwind(ex);
+    return 0;
+}
+
+
+/* Implement the pcr_segvector_len() interface function. Only the published
+ * elements are counted; elements still being written by other producers are
+ * not. */
+extern size_t
+pcr_segvector_len(const pcr_segvector *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    return seg_advance((pcr_segvector *) ctx);
+}
+
+
+/* Implement the pcr_segvector_elem() interface function. Since segments never
+ * move, a pointer to the element itself is returned rather than a copy, and it
+ * remains valid for as long as @ctx is reachable. */
+extern const void *
+pcr_segvector_elem(const pcr_segvector *ctx, size_t idx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_range(idx && idx <= pcr_segvector_len(ctx, ex), ex);
+
+    size_t k, off;
+    seg_locate(idx - 1, &k, &off);
+
+    char *seg = atomic_load_explicit(&((pcr_segvector *) ctx)->seg[k],
+                                     memory_order_acquire);
+    return seg_slots(seg, k) + off * ctx->sz;
+}
+
+
+/* Implement the pcr_segvector_flatten() interface function. The published
+ * elements are copied into a new pcr_vector one segment at a time. */
+extern pcr_vector *
+pcr_segvector_flatten(const pcr_segvector *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+
+    pcr_exception_try (x) {
+        size_t len = pcr_segvector_len(ctx, x);
+        pcr_vector *vec = pcr_vector_new_2(ctx->sz, len ? len : 1, x);
+
+        for (register size_t k = 0, done = 0; done < len; k++) {
+            char *seg = atomic_load_explicit(&((pcr_segvector *) ctx)->seg[k],
+                                             memory_order_acquire);
+            size_t n = seg_len(k) < len - done ? seg_len(k) : len - done;
+
+            pcr_vector_push_n(&vec, seg_slots(seg, k), n, x);
+            done += n;
+        }
+
+        return vec;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
@@ -0,0 +1,516 @@
+#include <math.h>
+#include "./api.h"
+
+
+/* Define SIMD_AVX2 if the AVX2 kernels can be compiled. They are built with a
+ * per-function target attribute, and so the rest of the library doesn't need
+ * to be compiled for AVX2; whether they are actually used is decided at run
+ * time. Defining PCR_NO_SIMD at compile time leaves only the scalar kernels. */
+#if (!defined PCR_NO_SIMD && (defined __GNUC__ || defined __clang__) \
+     && (defined __x86_64__ || defined __i386__))
+#   define SIMD_AVX2 1
+#   define SIMD_TARGET __attribute__((target("avx2")))
+#   include <immintrin.h>
+#else
+#   define SIMD_AVX2 0
+#endif
+
+
+/* Define the number of 64-bit lanes in an AVX2 register. The scalar kernels
+ * mirror this lane layout where the order of evaluation matters, so that both
+ * kernels give bitwise identical results. */
+#define SIMD_LANES 4
+
+
+/* Define the simd_avx2() helper function. This function checks whether the
+ * processor that we are running on supports AVX2. */
+static inline bool
+simd_avx2(void)
+{
+#if SIMD_AVX2
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+
+/* Define the simd_cmp_i64() and simd_cmp_f64() helper functions. These
+ * functions apply the comparison @cmp to @lhs and @rhs with the same semantics
+ * as the C relational operators; in particular, comparisons against NaN are
+ * false except for PCR_VECTOR_CMP_NE. */
+static inline bool
+simd_cmp_i64(int64_t lhs, PCR_VECTOR_CMP cmp, int64_t rhs)
+{
+    switch (cmp) {
+        case PCR_VECTOR_CMP_EQ: return lhs == rhs;
+        case PCR_VECTOR_CMP_NE: return lhs != rhs;
+        case PCR_VECTOR_CMP_LT: return lhs < rhs;
+        case PCR_VECTOR_CMP_LE: return lhs <= rhs;
+        case PCR_VECTOR_CMP_GT: return lhs > rhs;
+        default:                return lhs >= rhs;
+    }
+}
+
+static inline bool
+simd_cmp_f64(double lhs, PCR_VECTOR_CMP cmp, double rhs)
+{
+    switch (cmp) {
+        case PCR_VECTOR_CMP_EQ: return lhs == rhs;
+        case PCR_VECTOR_CMP_NE: return lhs != rhs;
+        case PCR_VECTOR_CMP_LT: return lhs < rhs;
+        case PCR_VECTOR_CMP_LE: return lhs <= rhs;
+        case PCR_VECTOR_CMP_GT: return lhs > rhs;
+        default:                return lhs >= rhs;
+    }
+}
+
+
+#if SIMD_AVX2
+/* Define the avx2_mask_i64() and avx2_mask_f64() helper functions. These
+ * functions compare the four lanes of @x against @v with @cmp, and return a
+ * bitmask with bit j set if the comparison holds for lane j. AVX2 only has
+ * 64-bit integer compares for equality and greater than, so the others are
+ * derived by swapping operands and inverting the mask. */
+static inline SIMD_TARGET unsigned
+avx2_mask_i64(__m256i x, PCR_VECTOR_CMP cmp, __m256i v)
+{
+    __m256i m;
+    unsigned inv = 0;
+
+    switch (cmp) {
+        case PCR_VECTOR_CMP_EQ: m = _mm256_cmpeq_epi64(x, v); break;
+        case PCR_VECTOR_CMP_NE: m = _mm256_cmpeq_epi64(x, v); inv = 0xF; break;
+        case PCR_VECTOR_CMP_LT: m = _mm256_cmpgt_epi64(v, x); break;
+        case PCR_VECTOR_CMP_LE: m = _mm256_cmpgt_epi64(x, v); inv = 0xF; break;
+        case PCR_VECTOR_CMP_GT: m = _mm256_cmpgt_epi64(x, v); break;
+        default:                m = _mm256_cmpgt_epi64(v, x); inv = 0xF; break;
+    }
+
+    return (unsigned) _mm256_movemask_pd(_mm256_castsi256_pd(m)) ^ inv;
+}
+
+static inline SIMD_TARGET unsigned
+avx2_mask_f64(__m256d x, PCR_VECTOR_CMP cmp, __m256d v)
+{
+    __m256d m;
+
+    switch (cmp) {
+        case PCR_VECTOR_CMP_EQ: m = _mm256_cmp_pd(x, v, _CMP_EQ_OQ); break;
+        case PCR_VECTOR_CMP_NE: m = _mm256_cmp_pd(x, v, _CMP_NEQ_UQ); break;
+        case PCR_VECTOR_CMP_LT: m = _mm256_cmp_pd(x, v, _CMP_LT_OQ); break;
+        case PCR_VECTOR_CMP_LE: m = _mm256_cmp_pd(x, v, _CMP_LE_OQ); break;
+        case PCR_VECTOR_CMP_GT: m = _mm256_cmp_pd(x, v, _CMP_GT_OQ); break;
+        default:                m = _mm256_cmp_pd(x, v, _CMP_GE_OQ); break;
+    }
+
+    return (unsigned) _mm256_movemask_pd(m);
+}
+
+
+/* Define the avx2_mul_i64() helper function. AVX2 has no 64-bit multiply, so
+ * this function builds one from 32-bit multiplies; the result wraps modulo
+ * 2^64 as an unsigned multiply would. */
+static inline SIMD_TARGET __m256i
+avx2_mul_i64(__m256i a, __m256i b)
+{
+    __m256i lo = _mm256_mul_epu32(a, b);
+    __m256i t1 = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);
+    __m256i t2 = _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32));
+
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(_mm256_add_epi64(t1, t2),
+                                                  32));
+}
+
+
+static SIMD_TARGET int64_t
+avx2_sum_i64(const int64_t *arr, size_t len)
+{
+    __m256i acc = _mm256_setzero_si256();
+    register size_t i = 0;
+
+    for (; i + SIMD_LANES <= len; i += SIMD_LANES)
+        acc = _mm256_add_epi64(acc, _mm256_loadu_si256((const __m256i *)
+                                                       &arr[i]));
+
+    uint64_t lane[SIMD_LANES], sum = 0;
+    _mm256_storeu_si256((__m256i *) lane, acc);
+    for (register size_t j = 0; j < SIMD_LANES; j++)
+        sum += lane[j];
+
+    for (; i < len; i++)
+        sum += (uint64_t) arr[i];
+
+    return (int64_t) sum;
+}
+
+
+static SIMD_TARGET double
+avx2_sum_f64(const double *arr, size_t len)
+{
+    __m256d acc = _mm256_setzero_pd();
+    register size_t i = 0;
+
+    for (; i + SIMD_LANES <= len; i += SIMD_LANES)
+        acc = _mm256_add_pd(acc, _mm256_loadu_pd(&arr[i]));
+
+    double lane[SIMD_LANES];
+    _mm256_storeu_pd(lane, acc);
+    double sum = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+
+    for (; i < len; i++)
+        sum += arr[i];
+
+    return sum;
+}
+
+
+static SIMD_TARGET int64_t
+avx2_minmax_i64(const int64_t *arr, size_t len, bool max)
+{
+    __m256i m = _mm256_set1_epi64x(arr[0]);
+    register size_t i = 0;
+
+    for (; i + SIMD_LANES <= len; i += SIMD_LANES) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) &arr[i]);
+        __m256i gt = max ? _mm256_cmpgt_epi64(x, m) : _mm256_cmpgt_epi64(m, x);
+        m = _mm256_blendv_epi8(m, x, gt);
+    }
+
+    int64_t lane[SIMD_LANES], res = arr[0];
+    _mm256_storeu_si256((__m256i *) lane, m);
+    for (register size_t j = 0; j < SIMD_LANES; j++)
+        res = (max ? lane[j] > res : lane[j] < res) ? lane[j] : res;
+
+    for (; i < len; i++)
+        res = (max ? arr[i] > res : arr[i] < res) ? arr[i] : res;
+
+    return res;
+}
+
+
+static SIMD_TARGET double
+avx2_minmax_f64(const double *arr, size_t len, bool max)
+{
+    __m256d m = _mm256_set1_pd(max ? -INFINITY : INFINITY);
+    register size_t i = 0;
+
+    /* _mm256_min_pd(x, m) yields m if x is NaN, so NaNs are skipped */
+    for (; i + SIMD_LANES <= len; i += SIMD_LANES) {
+        __m256d x = _mm256_loadu_pd(&arr[i]);
+        m = max ? _mm256_max_pd(x, m) : _mm256_min_pd(x, m);
+    }
+
+    double lane[SIMD_LANES], res = max ? -INFINITY : INFINITY;
+    _mm256_storeu_pd(lane, m);
+    for (register size_t j = 0; j < SIMD_LANES; j++)
+        res = (max ? lane[j] > res : lane[j] < res) ? lane[j] : res;
+
+    for (; i < len; i++)
+        res = (max ? arr[i] > res : arr[i] < res) ? arr[i] : res;
+
+    return res;
+}
+
+
+static SIMD_TARGET size_t
+avx2_select_i64(const int64_t *arr, size_t len, PCR_VECTOR_CMP cmp,
+                int64_t val, size_t *sel)
+{
+    const __m256i v = _mm256_set1_epi64x(val);
+    register size_t i = 0, n = 0;
+
+    for (; i + SIMD_LANES <= len; i += SIMD_LANES) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) &arr[i]);
+        unsigned m = avx2_mask_i64(x, cmp, v);
+
+        if (!sel)
+            n += (size_t) __builtin_popcount(m);
+        else {
+            for (; m; m &= m - 1)
+                sel[n++] = i + (size_t) __builtin_ctz(m) + 1;
+        }
+    }
+
+    for (; i < len; i++) {
+        if (simd_cmp_i64(arr[i], cmp, val)) {
+            if (sel)
+                sel[n] = i + 1;
+            n++;
+        }
+    }
+
+    return n;
+}
+
+
+static SIMD_TARGET size_t
+avx2_select_f64(const double *arr, size_t len, PCR_VECTOR_CMP cmp, double val,
+                size_t *sel)
+{
+    const __m256d v = _mm256_set1_pd(val);
+    register size_t i = 0, n = 0;
+
+    for (; i + SIMD_LANES <= len; i += SIMD_LANES) {
+        unsigned m = avx2_mask_f64(_mm256_loadu_pd(&arr[i]), cmp, v);
+
+        if (!sel)
+            n += (size_t) __builtin_popcount(m);
+        else {
+            for (; m; m &= m - 1)
+                sel[n++] = i + (size_t) __builtin_ctz(m) + 1;
+        }
+    }
+
+    for (; i < len; i++) {
+        if (simd_cmp_f64(arr[i], cmp, val)) {
+            if (sel)
+                sel[n] = i + 1;
+            n++;
+        }
+    }
+
+    return n;
+}
+
+
+static SIMD_TARGET void
+avx2_arith_i64(int64_t *arr, size_t len, PCR_VECTOR_ARITH op, int64_t val)
+{
+    const __m256i v = _mm256_set1_epi64x(val);
+    register size_t i = 0;
+
+    for (; i + SIMD_LANES <= len; i += SIMD_LANES) {
+        __m256i *p = (__m256i *) &arr[i];
+        __m256i x = _mm256_loadu_si256(p);
+
+        switch (op) {
+            case PCR_VECTOR_ARITH_ADD: x = _mm256_add_epi64(x, v); break;
+            case PCR_VECTOR_ARITH_SUB: x = _mm256_sub_epi64(x, v); break;
+            default:                   x = avx2_mul_i64(x, v); break;
+        }
+
+        _mm256_storeu_si256(p, x);
+    }
+
+    for (; i < len; i++) {
+        uint64_t x = (uint64_t) arr[i], y = (uint64_t) val;
+        arr[i] = (int64_t) (op == PCR_VECTOR_ARITH_ADD ? x + y
+                            : op == PCR_VECTOR_ARITH_SUB ? x - y : x * y);
+    }
+}
+
+
+static SIMD_TARGET void
+avx2_arith_f64(double *arr, size_t len, PCR_VECTOR_ARITH op, double val)
+{
+    const __m256d v = _mm256_set1_pd(val);
+    register size_t i = 0;
+
+    for (; i + SIMD_LANES <= len; i += SIMD_LANES) {
+        __m256d x = _mm256_loadu_pd(&arr[i]);
+
+        switch (op) {
+            case PCR_VECTOR_ARITH_ADD: x = _mm256_add_pd(x, v); break;
+            case PCR_VECTOR_ARITH_SUB: x = _mm256_sub_pd(x, v); break;
+            case PCR_VECTOR_ARITH_MUL: x = _mm256_mul_pd(x, v); break;
+            default:                   x = _mm256_div_pd(x, v); break;
+        }
+
+        _mm256_storeu_pd(&arr[i], x);
+    }
+
+    for (; i < len; i++) {
+        switch (op) {
+            case PCR_VECTOR_ARITH_ADD: arr[i] += val; break;
+            case PCR_VECTOR_ARITH_SUB: arr[i] -= val; break;
+            case PCR_VECTOR_ARITH_MUL: arr[i] *= val; break;
+            default:                   arr[i] /= val; break;
+        }
+    }
+}
+#endif
+
+
+/* Implement the pcr_simd_sum_i64__() private function. The sum wraps modulo
+ * 2^64, and so the scalar kernel sums in unsigned arithmetic. */
+extern int64_t
+pcr_simd_sum_i64__(const int64_t *arr, size_t len)
+{
+#if SIMD_AVX2
+    if (simd_avx2())
+        return avx2_sum_i64(arr, len);
+#endif
+
+    uint64_t sum = 0;
+    for (register size_t i = 0; i < len; i++)
+        sum += (uint64_t) arr[i];
+
+    return (int64_t) sum;
+}
+
+
+/* Implement the pcr_simd_sum_f64__() private function. The scalar kernel keeps
+ * one partial sum per AVX2 lane, and combines them in the same order as the
+ * AVX2 kernel. */
+extern double
+pcr_simd_sum_f64__(const double *arr, size_t len)
+{
+#if SIMD_AVX2
+    if (simd_avx2())
+        return avx2_sum_f64(arr, len);
+#endif
+
+    double lane[SIMD_LANES] = {0.0, 0.0, 0.0, 0.0};
+    register size_t i = 0;
+
+    for (; i + SIMD_LANES <= len; i += SIMD_LANES) {
+        for (register size_t j = 0; j < SIMD_LANES; j++)
+            lane[j] += arr[i + j];
+    }
+
+    double sum = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+    for (; i < len; i++)
+        sum += arr[i];
+
+    return sum;
+}
+
+
+/* Implement the pcr_simd_minmax_i64__() private function. @len must not be 0.
+ */
+extern int64_t
+pcr_simd_minmax_i64__(const int64_t *arr, size_t len, bool max)
+{
+#if SIMD_AVX2
+    if (simd_avx2())
+        return avx2_minmax_i64(arr, len, max);
+#endif
+
+    int64_t res = arr[0];
+    for (register size_t i = 1; i < len; i++)
+        res = (max ? arr[i] > res : arr[i] < res) ? arr[i] : res;
+
+    return res;
+}
+
+
+/* Implement the pcr_simd_minmax_f64__() private function. NaNs are skipped, and
+ * so the result is an infinity if all elements are NaN. */
+extern double
+pcr_simd_minmax_f64__(const double *arr, size_t len, bool max)
+{
+#if SIMD_AVX2
+    if (simd_avx2())
+        return avx2_minmax_f64(arr, len, max);
+#endif
+
+    double res = max ? -INFINITY : INFINITY;
+    for (register size_t i = 0; i < len; i++)
+        res = (max ? arr[i] > res : arr[i] < res) ? arr[i] : res;
+
+    return res;
+}
+
+
+/* Implement the pcr_simd_select_i64__() private function. The 1-based indices
+ * of the elements matching @cmp are written to @sel unless it is null, and the
+ * number of matching elements is returned. */
+extern size_t
+pcr_simd_select_i64__(const int64_t *arr, size_t len, PCR_VECTOR_CMP cmp,
+                      int64_t val, size_t *sel)
+{
+#if SIMD_AVX2
+    if (simd_avx2())
+        return avx2_select_i64(arr, len, cmp, val, sel);
+#endif
+
+    register size_t n = 0;
+    for (register size_t i = 0; i < len; i++) {
+        if (simd_cmp_i64(arr[i], cmp, val)) {
+            if (sel)
+                sel[n] = i + 1;
+            n++;
+        }
+    }
+
+    return n;
+}
+
+
+/* Implement the pcr_simd_select_f64__() private function. */
+extern size_t
+pcr_simd_select_f64__(const double *arr, size_t len, PCR_VECTOR_CMP cmp,
+                      double val, size_t *sel)
+{
+#if SIMD_AVX2
+    if (simd_avx2())
+        return avx2_select_f64(arr, len, cmp, val, sel);
+#endif
+
+    register size_t n = 0;
+    for (register size_t i = 0; i < len; i++) {
+        if (simd_cmp_f64(arr[i], cmp, val)) {
+            if (sel)
+                sel[n] = i + 1;
+            n++;
+        }
+    }
+
+    return n;
+}
+
+
+/* Implement the pcr_simd_arith_i64__() private function. Addition, subtraction
+ * and multiplication wrap modulo 2^64. There is no vector integer division, so
+ * division is always scalar; the caller is responsible for rejecting a zero
+ * @val, and division by -1 is done as a wrapping negation. */
+extern void
+pcr_simd_arith_i64__(int64_t *arr, size_t len, PCR_VECTOR_ARITH op,
+                     int64_t val)
+{
+    if (op == PCR_VECTOR_ARITH_DIV) {
+        for (register size_t i = 0; i < len; i++) {
+            arr[i] = val == -1 ? (int64_t) (0 - (uint64_t) arr[i])
+                               : arr[i] / val;
+        }
+
+        return;
+    }
+
+#if SIMD_AVX2
+    if (simd_avx2()) {
+        avx2_arith_i64(arr, len, op, val);
+        return;
+    }
+#endif
+
+    const uint64_t y = (uint64_t) val;
+    for (register size_t i = 0; i < len; i++) {
+        uint64_t x = (uint64_t) arr[i];
+        arr[i] = (int64_t) (op == PCR_VECTOR_ARITH_ADD ? x + y
+                            : op == PCR_VECTOR_ARITH_SUB ? x - y : x * y);
+    }
+}
+
+
+/* Implement the pcr_simd_arith_f64__() private function. */
+extern void
+pcr_simd_arith_f64__(double *arr, size_t len, PCR_VECTOR_ARITH op, double val)
+{
+#if SIMD_AVX2
+    if (simd_avx2()) {
+        avx2_arith_f64(arr, len, op, val);
+        return;
+    }
+#endif
+
+    for (register size_t i = 0; i < len; i++) {
+        switch (op) {
+            case PCR_VECTOR_ARITH_ADD: arr[i] += val; break;
+            case PCR_VECTOR_ARITH_SUB: arr[i] -= val; break;
+            case PCR_VECTOR_ARITH_MUL: arr[i] *= val; break;
+            default:                   arr[i] /= val; break;
+        }
+    }
+}
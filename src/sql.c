@@ -7,7 +7,7 @@
 struct pcr_sql {
     pcr_string *unbound; /* unbound SQL statement */
     pcr_string *bound;   /* bound SQL statement   */
-    size_t ref;          /* reference count       */
+    pcr_refcount__ ref;  /* reference count       */
 };
 
 
@@ -21,15 +21,15 @@ sql_fork(pcr_sql **ctx, pcr_exception ex)
     pcr_exception_try (x) {
         pcr_sql *hnd = *ctx;
 
-        if (hnd->ref > 1) {
-            hnd->ref--;
+        if (pcr_refcount_get__(&hnd->ref) > 1) {
             pcr_string *unbound = pcr_string_copy(hnd->unbound, x);
             pcr_string *bound = pcr_string_copy(hnd->bound, x);
+            pcr_refcount_dec__(&hnd->ref);
 
             hnd = *ctx = pcr_mempool_alloc(sizeof *hnd, x);
             hnd->unbound = unbound;
             hnd->bound = bound;
-            hnd->ref = 1;
+            pcr_refcount_init__(&hnd->ref, 1);
         }
 
         return hnd;
@@ -51,7 +51,7 @@ pcr_sql_new(const pcr_string *unbound, pcr_exception ex)
     pcr_exception_try (x) {
         pcr_sql *ctx = pcr_mempool_alloc(sizeof *ctx, x);
 
-        ctx->ref = 1;
+        pcr_refcount_init__(&ctx->ref, 1);
         ctx->unbound = pcr_string_copy(unbound, x);
         ctx->bound = pcr_string_new("", x);
 
@@ -72,7 +72,7 @@ pcr_sql_copy(const pcr_sql *ctx, pcr_exception ex)
     pcr_assert_handle(ctx, ex);
 
     pcr_sql *hnd = (pcr_sql *) ctx;
-    hnd->ref++;
+    pcr_refcount_inc__(&hnd->ref);
 
     return hnd;
 }
@@ -118,7 +118,7 @@ extern size_t
 pcr_sql_refcount(const pcr_sql *ctx, pcr_exception ex)
 {
     pcr_assert_handle(ctx, ex);
-    return ctx->ref;
+    return pcr_refcount_get__(&ctx->ref);
 }
 
 
@@ -131,7 +131,9 @@ pcr_sql_refcount(const pcr_sql *ctx, pcr_exception ex)
  *   1. escaping all single quotes with double single quotes as prescribed by
  *      the SQL standard, and
  *   2. wrapping the entire text in single quotes to ensure that SQL views it as
- *      a string. */
+ *      a string.
+ * Blob attributes are bound as blob literals, which consist only of hexadecimal
+ * digits and so need no escaping. */
 extern void
 pcr_sql_bind(pcr_sql **ctx, const pcr_attribute *attr, pcr_exception ex)
 {
@@ -144,7 +146,9 @@ pcr_sql_bind(pcr_sql **ctx, const pcr_attribute *attr, pcr_exception ex)
 
         pcr_string *arg = pcr_attribute_string(attr, x);
 
-        if (pcr_attribute_type(attr, x) == PCR_ATTRIBUTE_TEXT) {
+        PCR_ATTRIBUTE type = pcr_attribute_type(attr, x);
+
+        if (type == PCR_ATTRIBUTE_TEXT) {
             pcr_string *sane = pcr_string_replace(arg, "\'", "\'\'", x);
 
             arg = pcr_string_new("\'", x);
@@ -152,6 +156,14 @@ pcr_sql_bind(pcr_sql **ctx, const pcr_attribute *attr, pcr_exception ex)
             arg = pcr_string_add(arg, "\'", x);
         }
 
+        else if (type == PCR_ATTRIBUTE_BLOB) {
+            pcr_string *hex = arg;
+
+            arg = pcr_string_new("X\'", x);
+            arg = pcr_string_add(arg, hex, x);
+            arg = pcr_string_add(arg, "\'", x);
+        }
+
         hnd = sql_fork(ctx, x);
         hnd->bound = pcr_string_replace(*hnd->bound ? hnd->bound
                                                     : hnd->unbound,
@@ -201,3 +213,8 @@ extern inline void
 pcr_sql_bind_text(pcr_sql **ctx, const pcr_string *key, const pcr_string *value,
                   pcr_exception ex);
 
+
+extern inline void
+pcr_sql_bind_blob(pcr_sql **ctx, const pcr_string *key, const void *data,
+                  size_t len, pcr_exception ex);
+
@@ -1,31 +1,73 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 #include "./api.h"
 
 
-struct pcr_vector {
-    void **payload;
-    size_t sz;
-    size_t len;
-    size_t cap;
-    size_t ref;
-    bool sorted;
-};
+/* Define the offset of the inline payload of a vector from the start of its
+ * header; this is rounded up so that the inline elements are suitably aligned
+ * for any type. */
+#define VEC_INLINE_OFFSET                                          \
+    ((sizeof (pcr_vector) + _Alignof (max_align_t) - 1)            \
+     / _Alignof (max_align_t) * _Alignof (max_align_t))
 
 
-extern pcr_vector *pcr_vector_new(size_t elemsz, pcr_exception ex)
+/* Define the vec_at() helper function. The elements of a vector are stored
+ * contiguously in its payload, and this function returns a pointer to the
+ * element at the 0-based index @idx. */
+static inline void *
+vec_at(const pcr_vector *ctx, size_t idx)
 {
-    pcr_assert_range(elemsz, ex);
+    return (char *) ctx->payload + idx * ctx->sz;
+}
+
+
+/* Define the vec_inline() helper function. This function returns a pointer to
+ * the inline payload that is allocated in the same block as the header of
+ * @ctx. */
+static inline void *
+vec_inline(const pcr_vector *ctx)
+{
+    return (char *) ctx + VEC_INLINE_OFFSET;
+}
+
+
+/* Define the largest payload, in bytes, that is stored inline. Payloads of at
+ * most PCR_VECTOR_INLINE elements are always inline; larger ones are inline
+ * only if they fit this budget, so that a large vector never pins an unused
+ * inline block once its payload has moved to the heap. */
+#define VEC_INLINE_MAX 256
 
+
+/* Define the vec_alloc() helper function. This function allocates a new empty
+ * vector with elements of size @sz and room for @cap elements. A small payload
+ * shares a single allocation with the header, so small vectors cost one
+ * allocation instead of two; a larger one is allocated separately on the heap,
+ * where it can be reallocated as the vector grows. */
+static pcr_vector *
+vec_alloc(size_t sz, size_t cap, pcr_exception ex)
+{
     pcr_exception_try (x) {
-        pcr_vector *ctx = pcr_mempool_alloc(sizeof *ctx, x);
+        const bool in = cap <= PCR_VECTOR_INLINE || sz * cap <= VEC_INLINE_MAX;
+        pcr_vector *ctx = pcr_mempool_alloc(VEC_INLINE_OFFSET
+                                            + (in ? sz * cap : 0), x);
 
-        ctx->sz = elemsz;
+        ctx->sz = sz;
         ctx->len = 0;
-        ctx->ref = 1;
-        ctx->cap = 4;
+        ctx->cap = cap;
         ctx->sorted = false;
-        ctx->payload = pcr_mempool_alloc(elemsz * ctx->cap, x);
+        ctx->mapped = false;
+        ctx->payload = in ? vec_inline(ctx) : pcr_mempool_alloc(sz * cap, x);
+        ctx->base = NULL;
+        pcr_refcount_init__(&ctx->ref, 1);
 
         return ctx;
     }
@@ -35,12 +77,50 @@ extern pcr_vector *pcr_vector_new(size_t elemsz, pcr_exception ex)
 }
 
 
+/* Define the vec_grow() helper function. This function grows the capacity of
+ * @ctx to @cap elements. Neither an inline nor a mapped payload can be
+ * reallocated, and so they are spilled onto the heap instead; the inline room,
+ * which is small, is simply left unused, and the mapping is released by its
+ * finalizer. */
+static void
+vec_grow(pcr_vector *ctx, size_t cap, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        if (ctx->payload == vec_inline(ctx) || ctx->mapped) {
+            void *payload = pcr_mempool_alloc(ctx->sz * cap, x);
+            memcpy(payload, ctx->payload, ctx->sz * ctx->len);
+            ctx->payload = payload;
+            ctx->mapped = false;
+        } else
+            ctx->payload = pcr_mempool_realloc(ctx->payload, ctx->sz * cap, x);
+
+        ctx->cap = cap;
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+extern pcr_vector *pcr_vector_new(size_t elemsz, pcr_exception ex)
+{
+    return pcr_vector_new_2(elemsz, PCR_VECTOR_INLINE, ex);
+}
+
+
+extern pcr_vector *pcr_vector_new_2(size_t elemsz, size_t cap,
+                                    pcr_exception ex)
+{
+    pcr_assert_range(elemsz && cap, ex);
+    return vec_alloc(elemsz, cap, ex);
+}
+
+
 extern pcr_vector *pcr_vector_copy(const pcr_vector *ctx, pcr_exception ex)
 {
     pcr_assert_handle(ctx, ex);
 
     pcr_vector *hnd = (pcr_vector *) ctx;
-    hnd->ref++;
+    pcr_refcount_inc__(&hnd->ref);
 
     return hnd;
 }
@@ -56,7 +136,7 @@ extern size_t pcr_vector_len(const pcr_vector *ctx, pcr_exception ex)
 extern size_t pcr_vector_refcount(const pcr_vector *ctx, pcr_exception ex)
 {
     pcr_assert_handle(ctx, ex);
-    return ctx->ref;
+    return pcr_refcount_get__(&ctx->ref);
 }
 
 
@@ -75,7 +155,7 @@ extern void *pcr_vector_elem(const pcr_vector *ctx, size_t idx,
 
     pcr_exception_try (x) {
         void *elem = pcr_mempool_alloc(ctx->sz, x);
-        memcpy(elem, ctx->payload[idx - 1], ctx->sz);
+        memcpy(elem, vec_at(ctx, idx - 1), ctx->sz);
 
         return elem;
     }
@@ -85,23 +165,25 @@ extern void *pcr_vector_elem(const pcr_vector *ctx, size_t idx,
 }
 
 
+/* Define the vec_fork() helper function. This function is responsible for
+ * making a hard copy of @ctx if its reference count is greater than 1, or if it
+ * is a slice, since the payload of a slice belongs to its base vector. A slice
+ * that is the sole owner of its handle gives up its share of the base. */
 static pcr_vector *vec_fork(pcr_vector **ctx, pcr_exception ex)
 {
     pcr_exception_try (x) {
         pcr_vector *hnd = *ctx;
-        if (hnd->ref > 1) {
-            hnd->ref--;
-            pcr_vector *frk = pcr_vector_new(hnd->sz, x);
+        bool shared = pcr_refcount_get__(&hnd->ref) > 1;
+
+        if (shared || hnd->base) {
+            pcr_vector *frk = vec_alloc(hnd->sz, hnd->cap, x);
 
-            frk->sz = hnd->sz;
             frk->len = hnd->len;
-            frk->cap = hnd->cap;
-            frk->ref = 1;
             frk->sorted = hnd->sorted;
+            memcpy(frk->payload, hnd->payload, frk->sz * frk->len);
 
-            const size_t newsz = frk->sz * frk->cap;
-            frk->payload = pcr_mempool_alloc(newsz, x);
-            memcpy(frk->payload, hnd->payload, newsz);
+            /* release our share only after the hard copy is complete */
+            pcr_refcount_dec__(shared ? &hnd->ref : &hnd->base->ref);
 
             *ctx = frk;
         }
@@ -114,6 +196,211 @@ static pcr_vector *vec_fork(pcr_vector **ctx, pcr_exception ex)
 }
 
 
+extern pcr_vector *pcr_vector_slice(const pcr_vector *ctx, size_t idx,
+                                    size_t len, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_range(idx && len && idx - 1 + len <= ctx->len, ex);
+
+    pcr_exception_try (x) {
+        pcr_vector *base = ctx->base ? ctx->base : (pcr_vector *) ctx;
+        pcr_vector *slc = pcr_mempool_alloc(sizeof *slc, x);
+
+        slc->sz = ctx->sz;
+        slc->len = len;
+        slc->cap = len;
+        slc->sorted = ctx->sorted;
+        slc->mapped = false;
+        slc->payload = vec_at(ctx, idx - 1);
+        slc->base = pcr_vector_copy(base, x);
+        pcr_refcount_init__(&slc->ref, 1);
+
+        return slc;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Define the vec_file struct. This is the header of the files written by
+ * pcr_vector_persist(); the elements follow it in native byte order. The header
+ * is padded to 64 bytes so that the mapped elements are suitably aligned for
+ * any type. */
+struct vec_file {
+    char magic[8];
+    uint64_t sz;
+    uint64_t len;
+    uint64_t sorted;
+    char pad[32];
+};
+
+
+/* Define the magic number that identifies the files written by
+ * pcr_vector_persist(). */
+static const char VEC_FILE_MAGIC[8] = "PCRVEC1";
+
+
+/* Define the vec_mapping struct. This records a file mapping so that it can be
+ * released by the vec_unmap() finalizer; it is allocated outside the garbage
+ * collected heap since the collector must not reclaim it first. */
+struct vec_mapping {
+    void *addr;
+    size_t len;
+};
+
+
+/* Define the vec_unmap() helper function. This function is the finalizer of a
+ * mapped vector, and releases its mapping once the vector (and hence any slice
+ * of it) is no longer reachable. */
+static void
+vec_unmap(void *ptr, void *opt)
+{
+    (void) ptr;
+    struct vec_mapping *map = opt;
+
+    (void) munmap(map->addr, map->len);
+    free(map);
+}
+
+
+/* Implement the pcr_vector_map() interface function. The file is mapped
+ * copy-on-write, as by pcr_vector_map_2(). */
+extern pcr_vector *pcr_vector_map(const char *path, size_t elemsz,
+                                  pcr_exception ex)
+{
+    return pcr_vector_map_2(path, elemsz, false, ex);
+}
+
+
+/* Implement the pcr_vector_map_2() interface function. The file is mapped
+ * privately, so its pages are shared with the page cache until they are
+ * written, at which point they are copied; the file itself is never changed.
+ * If @readonly is set, the pages are mapped without write access instead, so
+ * that writing to the elements in place faults rather than silently copying
+ * them; this suits reference tables that are never meant to change. In either
+ * case, pushing onto a mapped vector moves its payload to the heap. */
+extern pcr_vector *pcr_vector_map_2(const char *path, size_t elemsz,
+                                    bool readonly, pcr_exception ex)
+{
+    pcr_assert_string(path, ex);
+    pcr_assert_range(elemsz, ex);
+
+    int fd = open(path, O_RDONLY);
+    pcr_assert_file(fd != -1, ex);
+
+    pcr_exception_try (x) {
+        struct stat st;
+        struct vec_file hdr;
+
+        pcr_assert_file(!fstat(fd, &st), x);
+        pcr_assert_file((size_t) st.st_size >= sizeof hdr
+                        && pread(fd, &hdr, sizeof hdr, 0)
+                           == (ssize_t) sizeof hdr, x);
+        pcr_assert_parse(!memcmp(hdr.magic, VEC_FILE_MAGIC, sizeof hdr.magic)
+                         && hdr.sz == elemsz
+                         && hdr.len == ((size_t) st.st_size - sizeof hdr)
+                                       / elemsz
+                         && !(((size_t) st.st_size - sizeof hdr) % elemsz), x);
+
+        pcr_vector *ctx = vec_alloc(elemsz, 1, x);
+        ctx->sorted = hdr.sorted;
+
+        if (hdr.len) {
+            struct vec_mapping *map = malloc(sizeof *map);
+            if (pcr_hint_unlikely (!map))
+                pcr_exception_throw(x, PCR_EXCEPTION_MEMPOOL);
+
+            map->len = (size_t) st.st_size;
+            map->addr = mmap(NULL, map->len,
+                             readonly ? PROT_READ : PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE, fd, 0);
+
+            if (pcr_hint_unlikely (map->addr == MAP_FAILED)) {
+                free(map);
+                pcr_exception_throw(x, PCR_EXCEPTION_FILE);
+            }
+
+            pcr_mempool_finalize__(ctx, &vec_unmap, map);
+
+            ctx->payload = (char *) map->addr + sizeof hdr;
+            ctx->len = ctx->cap = hdr.len;
+            ctx->mapped = true;
+        }
+
+        (void) close(fd);
+        return ctx;
+    }
+
+    pcr_exception_catchall {
+        (void) close(fd);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Define the number of attempts made to create a uniquely named temporary file
+ * before pcr_vector_persist() gives up. */
+#define VEC_TMP_TRIES 64
+
+
+/* Define the vec_tmpfile() helper function. This function creates a new file
+ * named after @path with a unique suffix, writing its name to @tmp, which must
+ * have room for the suffix. The file is created with mode 0666 so that the
+ * kernel applies the umask as it would for any other new file; the umask itself
+ * is never changed, since other threads may be creating files. */
+static int
+vec_tmpfile(const char *path, char *tmp, size_t len)
+{
+    static atomic_uint seq;
+
+    for (register int i = 0; i < VEC_TMP_TRIES; i++) {
+        unsigned n = atomic_fetch_add(&seq, 1);
+        (void) snprintf(tmp, len, "%s.%lx.%x", path, (unsigned long) getpid(),
+                        n ^ (unsigned) time(NULL) << 16);
+
+        int fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        if (fd != -1 || errno != EEXIST)
+            return fd;
+    }
+
+    return -1;
+}
+
+
+/* Implement the pcr_vector_persist() interface function. The vector is written
+ * to a temporary file that then replaces @path, so that any existing mapping of
+ * @path remains valid and a reader never sees a partial file. */
+extern void pcr_vector_persist(const pcr_vector *ctx, const char *path,
+                               pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_string(path, ex);
+
+    size_t len = strlen(path) + 64;
+    char *tmp = pcr_mempool_alloc(len, ex);
+
+    int fd = vec_tmpfile(path, tmp, len);
+    pcr_assert_file(fd != -1, ex);
+
+    struct vec_file hdr = {.sz = ctx->sz, .len = ctx->len,
+                           .sorted = ctx->sorted};
+    memcpy(hdr.magic, VEC_FILE_MAGIC, sizeof hdr.magic);
+
+    FILE *file = fdopen(fd, "wb");
+    bool ok = file && fwrite(&hdr, sizeof hdr, 1, file) == 1
+              && fwrite(ctx->payload, ctx->sz, ctx->len, file) == ctx->len;
+
+    ok = (file ? !fclose(file) : !close(fd)) && ok && !rename(tmp, path);
+    if (pcr_hint_unlikely (!ok))
+        (void) unlink(tmp);
+
+    pcr_assert_file(ok, ex);
+}
+
+
 extern void pcr_vector_setelem(pcr_vector **ctx, const void *elem, size_t idx,
                                     pcr_exception ex)
 {
@@ -122,7 +409,8 @@ extern void pcr_vector_setelem(pcr_vector **ctx, const void *elem, size_t idx,
 
     pcr_exception_try (x) {
         pcr_vector *hnd = vec_fork(ctx, x);
-        memcpy(hnd->payload[idx - 1], elem, hnd->sz);
+        memcpy(vec_at(hnd, idx - 1), elem, hnd->sz);
+        hnd->sorted = false;
     }
 
     pcr_exception_unwind(ex);
@@ -136,15 +424,10 @@ extern void pcr_vector_push(pcr_vector **ctx, const void *elem,
 
     pcr_exception_try (x) {
         pcr_vector *hnd = vec_fork(ctx, x);
-        if (pcr_hint_unlikely (hnd->len == hnd->cap)) {
-            hnd->cap *= 2;
-            hnd->payload = pcr_mempool_realloc(hnd->payload, hnd->sz * hnd->cap,
-                                                    x);
-        }
+        if (pcr_hint_unlikely (hnd->len == hnd->cap))
+            vec_grow(hnd, hnd->cap * 2, x);
 
-        hnd->payload[hnd->len] = pcr_mempool_realloc(hnd->payload[hnd->len],
-                                                            hnd->sz, x);
-        memcpy(hnd->payload[hnd->len++], elem, hnd->sz);
+        memcpy(vec_at(hnd, hnd->len++), elem, hnd->sz);
         hnd->sorted = false;
     }
 
@@ -152,14 +435,22 @@ extern void pcr_vector_push(pcr_vector **ctx, const void *elem,
 }
 
 
-extern void pcr_vector_pop(pcr_vector **ctx, pcr_exception ex)
+extern void pcr_vector_push_n(pcr_vector **ctx, const void *elems,
+                              size_t len, pcr_exception ex)
 {
-    pcr_assert_handle(ctx && *ctx, ex);
+    pcr_assert_handle(ctx && *ctx && (elems || !len), ex);
 
     pcr_exception_try (x) {
         pcr_vector *hnd = vec_fork(ctx, x);
-        if (pcr_hint_likely (hnd->len)) {
-            hnd->payload[hnd->len--] = NULL;
+
+        if (hnd->len + len > hnd->cap) {
+            size_t cap = hnd->cap * 2;
+            vec_grow(hnd, cap > hnd->len + len ? cap : hnd->len + len, x);
+        }
+
+        if (len) {
+            memcpy(vec_at(hnd, hnd->len), elems, len * hnd->sz);
+            hnd->len += len;
             hnd->sorted = false;
         }
     }
@@ -168,66 +459,1079 @@ extern void pcr_vector_pop(pcr_vector **ctx, pcr_exception ex)
 }
 
 
-extern void pcr_vector_sort(pcr_vector **ctx, pcr_comparator *cmp,
-                                    pcr_exception ex)
+extern void pcr_vector_pop(pcr_vector **ctx, pcr_exception ex)
 {
-    pcr_assert_handle(ctx && *ctx && cmp, ex);
+    pcr_assert_handle(ctx && *ctx, ex);
 
     pcr_exception_try (x) {
         pcr_vector *hnd = vec_fork(ctx, x);
-        if (!hnd->sorted) {
-            qsort(hnd->payload, hnd->len, hnd->sz, cmp);
-            hnd->sorted = true;
-        }
+        if (pcr_hint_likely (hnd->len))
+            hnd->len--;
     }
 
     pcr_exception_unwind(ex);
 }
 
 
-extern size_t pcr_vector_search(pcr_vector **ctx, const void *key,
-                                        pcr_comparator *cmp, pcr_exception ex)
+/* Define the minimum run length below which the stable merge sort falls back
+ * to an insertion sort. */
+#define MSORT_CUTOFF 16
+
+
+/* Define the msort_insert() helper function. This function performs a stable
+ * insertion sort of the @len elements of size @sz at @base, using @tmp as
+ * scratch space for a single element. */
+static void
+msort_insert(char *base, size_t len, size_t sz, pcr_comparator *cmp, char *tmp)
 {
-    pcr_assert_handle(ctx && *ctx && key && cmp, ex);
+    for (register size_t i = 1; i < len; i++) {
+        register size_t j = i;
+        while (j && cmp(base + (j - 1) * sz, base + i * sz) > 0)
+            j--;
+
+        if (j < i) {
+            memcpy(tmp, base + i * sz, sz);
+            memmove(base + (j + 1) * sz, base + j * sz, (i - j) * sz);
+            memcpy(base + j * sz, tmp, sz);
+        }
+    }
+}
+
+
+/* Define the msort_merge() helper function. This function merges the sorted
+ * runs @lhs and @rhs of @llen and @rlen elements respectively into @out. Ties
+ * are resolved in favour of @lhs, which is what makes the merge stable. */
+static void
+msort_merge(const char *lhs, size_t llen, const char *rhs, size_t rlen,
+            char *out, size_t sz, pcr_comparator *cmp)
+{
+    const char *lend = lhs + llen * sz, *rend = rhs + rlen * sz;
+
+    while (lhs < lend && rhs < rend) {
+        if (cmp(lhs, rhs) <= 0) {
+            memcpy(out, lhs, sz);
+            lhs += sz;
+        } else {
+            memcpy(out, rhs, sz);
+            rhs += sz;
+        }
+
+        out += sz;
+    }
+
+    memcpy(out, lhs, lend - lhs);
+    memcpy(out + (lend - lhs), rhs, rend - rhs);
+}
+
+
+/* Define the msort_run() helper function. This function performs a stable
+ * top-down merge sort of the @len elements at @base, using @tmp as scratch
+ * space of at least @len elements. */
+static void
+msort_run(char *base, char *tmp, size_t len, size_t sz, pcr_comparator *cmp)
+{
+    if (len <= MSORT_CUTOFF) {
+        msort_insert(base, len, sz, cmp, tmp);
+        return;
+    }
+
+    const size_t mid = len / 2;
+    char *rhs = base + mid * sz;
+
+    msort_run(base, tmp, mid, sz, cmp);
+    msort_run(rhs, tmp, len - mid, sz, cmp);
+
+    if (cmp(rhs - sz, rhs) > 0) {
+        msort_merge(base, mid, rhs, len - mid, tmp, sz, cmp);
+        memcpy(base, tmp, len * sz);
+    }
+}
+
+
+/* Define the msort_corank() helper function. This function splits the merge of
+ * the sorted runs @lhs and @rhs at output position @k, returning the number of
+ * elements that @lhs contributes to the first @k elements of the merged output.
+ * The split honours the same tie-breaking as msort_merge(), so independently
+ * merged parts concatenate to exactly the output of a single merge. */
+static size_t
+msort_corank(size_t k, const char *lhs, size_t llen, const char *rhs,
+             size_t rlen, size_t sz, pcr_comparator *cmp)
+{
+    register size_t lo = k > rlen ? k - rlen : 0;
+    register size_t hi = k < llen ? k : llen;
+
+    while (lo < hi) {
+        register size_t i = lo + (hi - lo) / 2;
+        register size_t j = k - i;
+
+        if (j && i < llen && cmp(lhs + i * sz, rhs + (j - 1) * sz) <= 0)
+            lo = i + 1;
+        else
+            hi = i;
+    }
+
+    return lo;
+}
 
+
+/* Define the psort_part struct. A parallel sort proceeds in rounds, and during
+ * each round, the work is broken up into parts that can be processed by the
+ * workers independently. In the first round, each part is a run to be sorted in
+ * place; in subsequent rounds, each part is a slice of a merge of two adjacent
+ * sorted runs into the alternate buffer. */
+struct psort_part {
+    char *lhs;
+    char *rhs;
+    char *out;
+    size_t llen;
+    size_t rlen;
+};
+
+
+/* Define the psort struct. This struct holds the state shared by all workers
+ * in a single round of a parallel sort. */
+struct psort {
+    struct psort_part *parts;
+    size_t len;
+    size_t sz;
+    pcr_comparator *cmp;
+    bool stable;
+};
+
+
+/* Define the psort_sort() helper function. This is the worker task for the
+ * first round of a parallel sort, and sorts each run in place. Since the runs
+ * are disjoint, each worker uses the corresponding region of the scratch buffer
+ * for the stable merge sort. */
+static void
+psort_sort(size_t id, size_t len, void *opt, pcr_exception ex)
+{
+    struct psort *ps = (struct psort *) opt;
+    struct psort_part *p = &ps->parts[id];
+
+    (void) len;
+    (void) ex;
+
+    if (ps->stable)
+        msort_run(p->lhs, p->out, p->llen, ps->sz, ps->cmp);
+    else
+        qsort(p->lhs, p->llen, ps->sz, ps->cmp);
+}
+
+
+/* Define the psort_merge() helper function. This is the worker task for the
+ * merge rounds of a parallel sort; each worker merges the parts assigned to it
+ * in a round-robin fashion. */
+static void
+psort_merge(size_t id, size_t len, void *opt, pcr_exception ex)
+{
+    struct psort *ps = (struct psort *) opt;
+    struct psort_part *p;
+
+    (void) ex;
+
+    for (register size_t i = id; i < ps->len; i += len) {
+        p = &ps->parts[i];
+        msort_merge(p->lhs, p->llen, p->rhs, p->rlen, p->out, ps->sz, ps->cmp);
+    }
+}
+
+
+/* Define the vec_sort_par() helper function. This function sorts the vector
+ * @ctx in parallel across @wrk workers. The payload is first split into @wrk
+ * runs that are sorted concurrently; the runs are then merged pairwise in
+ * rounds, ping-ponging between the payload and a scratch buffer. In each round,
+ * every pairwise merge is itself split through msort_corank() into enough parts
+ * to keep all workers busy, so the final merges don't serialise. */
+static void
+vec_sort_par(pcr_vector *ctx, pcr_comparator *cmp, size_t wrk, bool stable,
+             pcr_exception ex)
+{
     pcr_exception_try (x) {
-        pcr_vector_sort(ctx, cmp, x);
+        const size_t sz = ctx->sz;
+        char *src = ctx->payload;
+        char *dst = pcr_mempool_alloc(ctx->len * sz, x);
 
-        pcr_vector *hnd = *ctx;
-        void *where = bsearch(key, hnd->payload, hnd->len, hnd->sz, cmp);
-        return where ? ((void **) where - hnd->payload) / hnd->sz : 0;
+        struct psort ps = {.len = wrk, .sz = sz, .cmp = cmp, .stable = stable};
+        ps.parts = pcr_mempool_alloc(sizeof *ps.parts * wrk, x);
+
+        size_t bounds[PCR_WORKER_MAX + 1];
+        for (register size_t i = 0; i <= wrk; i++)
+            bounds[i] = ctx->len * i / wrk;
+
+        for (register size_t i = 0; i < wrk; i++) {
+            ps.parts[i].lhs = src + bounds[i] * sz;
+            ps.parts[i].out = dst + bounds[i] * sz;
+            ps.parts[i].llen = bounds[i + 1] - bounds[i];
+        }
+
+        pcr_worker_run(wrk, &psort_sort, &ps, x);
+
+        for (register size_t w = 1; w < wrk; w *= 2) {
+            register size_t pairs = (wrk + 2 * w - 1) / (2 * w);
+            register size_t split = wrk / pairs ? wrk / pairs : 1;
+            ps.len = 0;
+
+            for (register size_t r = 0; r < wrk; r += 2 * w) {
+                const size_t mid = r + w < wrk ? r + w : wrk;
+                const size_t end = r + 2 * w < wrk ? r + 2 * w : wrk;
+
+                char *lhs = src + bounds[r] * sz, *rhs = src + bounds[mid] * sz;
+                const size_t llen = bounds[mid] - bounds[r];
+                const size_t rlen = bounds[end] - bounds[mid];
+                const size_t tot = llen + rlen;
+
+                register size_t pi = 0, pk = 0;
+                for (register size_t s = 1; s <= split; s++) {
+                    const size_t k = tot * s / split;
+                    const size_t i = msort_corank(k, lhs, llen, rhs, rlen, sz,
+                                                  cmp);
+
+                    struct psort_part *p = &ps.parts[ps.len++];
+                    p->lhs = lhs + pi * sz;
+                    p->llen = i - pi;
+                    p->rhs = rhs + (pk - pi) * sz;
+                    p->rlen = (k - i) - (pk - pi);
+                    p->out = dst + (bounds[r] + pk) * sz;
+
+                    pi = i;
+                    pk = k;
+                }
+            }
+
+            pcr_worker_run(ps.len < wrk ? ps.len : wrk, &psort_merge, &ps, x);
+
+            char *swp = src;
+            src = dst;
+            dst = swp;
+        }
+
+        if (src != ctx->payload)
+            memcpy(ctx->payload, src, ctx->len * sz);
     }
 
     pcr_exception_unwind(ex);
-    return 0;
 }
 
 
-extern void pcr_vector_iterate(const pcr_vector *ctx, pcr_iterator *itr,
-                                    void *opt, pcr_exception ex)
+/* Define the vec_sort() helper function. This function sorts @ctx in place,
+ * switching over to a parallel sort if @ctx has at least as many elements as
+ * the threshold set by PCR_VECTOR_SORT_THRESHOLD and more than one worker is
+ * available. */
+static void
+vec_sort(pcr_vector *ctx, pcr_comparator *cmp, bool stable, pcr_exception ex)
 {
-    pcr_assert_handle(ctx && itr, ex);
+    pcr_exception_try (x) {
+        const size_t wrk = pcr_worker_count();
+
+        if (ctx->len >= PCR_VECTOR_SORT_THRESHOLD && wrk > 1)
+            vec_sort_par(ctx, cmp, wrk, stable, x);
+        else if (stable && ctx->len > 1)
+            msort_run(ctx->payload, pcr_mempool_alloc(ctx->len * ctx->sz, x),
+                      ctx->len, ctx->sz, cmp);
+        else
+            qsort(ctx->payload, ctx->len, ctx->sz, cmp);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+extern void pcr_vector_sort(pcr_vector **ctx, pcr_comparator *cmp,
+                                    pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx && cmp, ex);
 
     pcr_exception_try (x) {
-        for (register size_t i = 0, len = ctx->len; i < len; i++)
-            itr(ctx->payload[i], i + 1, opt, x);
+        pcr_vector *hnd = vec_fork(ctx, x);
+        if (!hnd->sorted) {
+            vec_sort(hnd, cmp, false, x);
+            hnd->sorted = true;
+        }
     }
 
     pcr_exception_unwind(ex);
 }
 
 
-extern void pcr_vector_muterate(pcr_vector **ctx, pcr_muterator *mtr, void *opt,
+extern void pcr_vector_sort_stable(pcr_vector **ctx, pcr_comparator *cmp,
                                         pcr_exception ex)
 {
-    pcr_assert_handle(ctx && *ctx && mtr, ex);
+    pcr_assert_handle(ctx && *ctx && cmp, ex);
 
     pcr_exception_try (x) {
         pcr_vector *hnd = vec_fork(ctx, x);
-        for (register size_t i = 0, len = hnd->len; i < len; i++)
-            mtr(hnd->payload[i], i + 1, opt, x);
+        if (!hnd->sorted) {
+            vec_sort(hnd, cmp, true, x);
+            hnd->sorted = true;
+        }
     }
 
     pcr_exception_unwind(ex);
 }
 
+
+/* Define the number of bits sorted in each pass of the LSD radix sort, and the
+ * corresponding number of buckets and passes for 64-bit keys. */
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES (64 / RADIX_BITS)
+
+
+/* Define the radix_u64() helper function. This function performs an LSD radix
+ * sort of the @len unsigned 64-bit keys in @keys, using @tmp as scratch space of
+ * the same size. The histograms of all the passes are built in a single scan,
+ * and passes in which all keys fall in the same bucket are skipped since they
+ * would not change the order; this makes sorting narrow keys (such as small IDs
+ * stored as int64_t) markedly cheaper. */
+static void
+radix_u64(uint64_t *keys, uint64_t *tmp, size_t len)
+{
+    size_t cnt[RADIX_PASSES][RADIX_BUCKETS] = {{0}};
+
+    for (register size_t i = 0; i < len; i++) {
+        register uint64_t k = keys[i];
+        for (register size_t p = 0; p < RADIX_PASSES; p++)
+            cnt[p][(k >> (p * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+    }
+
+    uint64_t *src = keys, *dst = tmp;
+    for (register size_t p = 0; p < RADIX_PASSES; p++) {
+        register size_t *c = cnt[p];
+        register size_t shift = p * RADIX_BITS;
+
+        if (c[(src[0] >> shift) & (RADIX_BUCKETS - 1)] == len)
+            continue;
+
+        for (register size_t b = 0, off = 0, n; b < RADIX_BUCKETS; b++) {
+            n = c[b];
+            c[b] = off;
+            off += n;
+        }
+
+        for (register size_t i = 0; i < len; i++)
+            dst[c[(src[i] >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+
+        uint64_t *swp = src;
+        src = dst;
+        dst = swp;
+    }
+
+    if (src != keys)
+        memcpy(keys, src, len * sizeof *keys);
+}
+
+
+/* Define the f64_key() and f64_unkey() helper functions. These functions map
+ * the bit pattern of an IEEE 754 double to an unsigned key with the same order
+ * and back again: negative values have all their bits flipped, and positive
+ * values have only their sign bit flipped. NaNs are ordered by their sign, with
+ * negative NaNs first and positive NaNs last. */
+static inline uint64_t
+f64_key(uint64_t bits)
+{
+    return bits ^ ((bits >> 63) ? UINT64_MAX : UINT64_C(1) << 63);
+}
+
+
+static inline uint64_t
+f64_unkey(uint64_t key)
+{
+    return key ^ ((key >> 63) ? UINT64_C(1) << 63 : UINT64_MAX);
+}
+
+
+/* Define the vec_radix() helper function. This function is common to both the
+ * pcr_vector_sort_i64() and pcr_vector_sort_f64() interface functions, and
+ * radix sorts the 64-bit elements of @ctx after mapping them to unsigned keys in
+ * place through @key and before mapping them back through @unkey. */
+static void
+vec_radix(pcr_vector **ctx, uint64_t (*key)(uint64_t),
+          uint64_t (*unkey)(uint64_t), pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx, ex);
+    pcr_assert_state((*ctx)->sz == sizeof (uint64_t), ex);
+
+    pcr_exception_try (x) {
+        pcr_vector *hnd = vec_fork(ctx, x);
+        const size_t len = hnd->len;
+
+        if (!hnd->sorted && len > 1) {
+            uint64_t *keys = hnd->payload, bits;
+
+            for (register size_t i = 0; i < len; i++) {
+                memcpy(&bits, &keys[i], sizeof bits);
+                bits = key(bits);
+                memcpy(&keys[i], &bits, sizeof bits);
+            }
+
+            radix_u64(keys, pcr_mempool_alloc(len * sizeof *keys, x), len);
+
+            for (register size_t i = 0; i < len; i++) {
+                memcpy(&bits, &keys[i], sizeof bits);
+                bits = unkey(bits);
+                memcpy(&keys[i], &bits, sizeof bits);
+            }
+        }
+
+        hnd->sorted = true;
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+static inline uint64_t
+i64_key(uint64_t bits)
+{
+    return bits ^ (UINT64_C(1) << 63);
+}
+
+
+extern void pcr_vector_sort_i64(pcr_vector **ctx, pcr_exception ex)
+{
+    vec_radix(ctx, &i64_key, &i64_key, ex);
+}
+
+
+extern void pcr_vector_sort_f64(pcr_vector **ctx, pcr_exception ex)
+{
+    vec_radix(ctx, &f64_key, &f64_unkey, ex);
+}
+
+
+/* Define the run length below which the multikey quicksort falls back to an
+ * insertion sort. */
+#define MKQS_CUTOFF 12
+
+
+/* Define the mkqs_insert() helper function. This function performs an insertion
+ * sort of the @len strings at @arr, all of which are known to share their first
+ * @depth bytes. */
+static void
+mkqs_insert(pcr_string **arr, size_t len, size_t depth)
+{
+    for (register size_t i = 1; i < len; i++) {
+        pcr_string *s = arr[i];
+        register size_t j = i;
+
+        while (j && strcmp(arr[j - 1] + depth, s + depth) > 0) {
+            arr[j] = arr[j - 1];
+            j--;
+        }
+
+        arr[j] = s;
+    }
+}
+
+
+/* Define the mkqs_byte() helper function. This function returns the unsigned
+ * byte at offset @depth of @s; bytes are compared unsigned so that the sort
+ * order is the same as that of strcmp(). */
+static inline int
+mkqs_byte(const pcr_string *s, size_t depth)
+{
+    return (unsigned char) s[depth];
+}
+
+
+/* Define the mkqs_run() helper function. This function performs the multikey
+ * quicksort of Bentley and Sedgewick on the @len strings at @arr, all of which
+ * share their first @depth bytes. Each step partitions the strings three ways on
+ * the byte at @depth, recursing into the lesser and equal partitions (the
+ * latter one byte deeper) and looping over the greater partition. Unlike a
+ * comparator sort, each byte of each string is examined a near constant number
+ * of times, and no indirect calls are made. */
+static void
+mkqs_run(pcr_string **arr, size_t len, size_t depth)
+{
+    pcr_string *swp;
+
+    while (len > MKQS_CUTOFF) {
+        swp = arr[0];
+        arr[0] = arr[len / 2];
+        arr[len / 2] = swp;
+
+        register int piv = mkqs_byte(arr[0], depth);
+        register size_t lt = 0, i = 1, gt = len - 1;
+
+        while (i <= gt) {
+            register int c = mkqs_byte(arr[i], depth);
+
+            if (c < piv) {
+                swp = arr[lt];
+                arr[lt++] = arr[i];
+                arr[i++] = swp;
+            } else if (c > piv) {
+                swp = arr[gt];
+                arr[gt--] = arr[i];
+                arr[i] = swp;
+            } else
+                i++;
+        }
+
+        mkqs_run(arr, lt, depth);
+        if (piv)
+            mkqs_run(arr + lt, gt - lt + 1, depth + 1);
+
+        arr += gt + 1;
+        len -= gt + 1;
+    }
+
+    mkqs_insert(arr, len, depth);
+}
+
+
+extern void pcr_string_vector_sort_radix(pcr_string_vector **ctx,
+                                            pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx, ex);
+    pcr_assert_state((*ctx)->sz == sizeof (pcr_string *), ex);
+
+    pcr_exception_try (x) {
+        pcr_vector *hnd = vec_fork(ctx, x);
+        if (!hnd->sorted) {
+            mkqs_run(hnd->payload, hnd->len, 0);
+            hnd->sorted = true;
+        }
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+extern size_t pcr_vector_search(pcr_vector **ctx, const void *key,
+                                        pcr_comparator *cmp, pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx && key && cmp, ex);
+
+    pcr_exception_try (x) {
+        if (!(*ctx)->sorted)
+            pcr_vector_sort(ctx, cmp, x);
+
+        pcr_vector *hnd = *ctx;
+        char *where = bsearch(key, hnd->payload, hnd->len, hnd->sz, cmp);
+        return where ? (where - (char *) hnd->payload) / hnd->sz + 1 : 0;
+    }
+
+    pcr_exception_unwind(ex);
+    return 0;
+}
+
+
+/* Define the vec_sorted() helper function. This function checks whether @ctx
+ * can be treated as sorted; vectors with fewer than two elements are trivially
+ * sorted even if they have never been through a sort. */
+static inline bool
+vec_sorted(const pcr_vector *ctx)
+{
+    return ctx->sorted || ctx->len < 2;
+}
+
+
+/* Define the vec_bound() helper function. This function performs a binary
+ * search for @key over the @len elements of size @sz at @base, returning the
+ * 0-based index of the first element that is not less than @key if @upper is
+ * false, or the first element that is greater than @key if @upper is true. */
+static size_t
+vec_bound(const char *base, size_t len, size_t sz, const void *key,
+          pcr_comparator *cmp, bool upper)
+{
+    register size_t lo = 0, hi = len, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        register int c = cmp(base + mid * sz, key);
+
+        if (c < 0 || (upper && !c))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+
+/* Define the vec_gallop() helper function. This function has the same contract
+ * as vec_bound() for lower bounds, but first probes exponentially from the start
+ * of the range before bisecting. The cost is therefore logarithmic in the
+ * distance to the bound rather than in @len, which is what makes the set
+ * operations fast when one of the vectors is much smaller than the other. */
+static size_t
+vec_gallop(const char *base, size_t len, size_t sz, const void *key,
+           pcr_comparator *cmp)
+{
+    register size_t lo = 0, hi = 1;
+
+    while (hi < len && cmp(base + hi * sz, key) < 0) {
+        lo = hi;
+        hi *= 2;
+    }
+
+    if (hi > len)
+        hi = len;
+
+    return lo + vec_bound(base + lo * sz, hi - lo, sz, key, cmp, false);
+}
+
+
+extern size_t pcr_vector_lower_bound(const pcr_vector *ctx, const void *key,
+                                            pcr_comparator *cmp,
+                                            pcr_exception ex)
+{
+    pcr_assert_handle(ctx && key && cmp, ex);
+    pcr_assert_state(vec_sorted(ctx), ex);
+
+    return vec_bound(ctx->payload, ctx->len, ctx->sz, key, cmp, false) + 1;
+}
+
+
+extern size_t pcr_vector_upper_bound(const pcr_vector *ctx, const void *key,
+                                            pcr_comparator *cmp,
+                                            pcr_exception ex)
+{
+    pcr_assert_handle(ctx && key && cmp, ex);
+    pcr_assert_state(vec_sorted(ctx), ex);
+
+    return vec_bound(ctx->payload, ctx->len, ctx->sz, key, cmp, true) + 1;
+}
+
+
+extern void pcr_vector_insert_sorted(pcr_vector **ctx, const void *elem,
+                                            pcr_comparator *cmp,
+                                            pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx && elem && cmp, ex);
+    pcr_assert_state(vec_sorted(*ctx), ex);
+
+    pcr_exception_try (x) {
+        pcr_vector *hnd = vec_fork(ctx, x);
+        if (pcr_hint_unlikely (hnd->len == hnd->cap))
+            vec_grow(hnd, hnd->cap * 2, x);
+
+        size_t idx = vec_bound(hnd->payload, hnd->len, hnd->sz, elem, cmp,
+                               true);
+        memmove(vec_at(hnd, idx + 1), vec_at(hnd, idx),
+                (hnd->len - idx) * hnd->sz);
+        memcpy(vec_at(hnd, idx), elem, hnd->sz);
+
+        hnd->len++;
+        hnd->sorted = true;
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the ratio of the lengths of two sorted vectors beyond which the set
+ * operations switch from a linear merge to galloping through the runs of the
+ * longer vector. */
+#define SETOP_GALLOP_RATIO 8
+
+
+/* Define the SETOP enumeration of the set operations on sorted vectors. */
+typedef enum SETOP {
+    SETOP_UNION,
+    SETOP_INTERSECT,
+    SETOP_DIFFERENCE
+} SETOP;
+
+
+/* Define the vec_setop() helper function. This function performs the set
+ * operation @op on the sorted vectors @lhs and @rhs, returning a new sorted
+ * vector. Duplicates follow multiset semantics, so an element that occurs m
+ * times in @lhs and n times in @rhs occurs max(m, n), min(m, n) and max(m - n,
+ * 0) times in the union, intersection and difference respectively. Runs of
+ * elements that are present in only one of the vectors are located by
+ * galloping when the vectors are of very different lengths, and are copied in
+ * bulk. */
+static pcr_vector *
+vec_setop(const pcr_vector *lhs, const pcr_vector *rhs, pcr_comparator *cmp,
+          SETOP op, pcr_exception ex)
+{
+    pcr_assert_handle(lhs && rhs && cmp, ex);
+    pcr_assert_state(lhs->sz == rhs->sz, ex);
+    pcr_assert_state(vec_sorted(lhs) && vec_sorted(rhs), ex);
+
+    pcr_exception_try (x) {
+        const size_t sz = lhs->sz, m = lhs->len, n = rhs->len;
+        const char *a = lhs->payload, *b = rhs->payload;
+
+        size_t cap = op == SETOP_UNION ? m + n
+                     : op == SETOP_INTERSECT ? (m < n ? m : n) : m;
+        pcr_vector *res = vec_alloc(sz, cap ? cap : 1, x);
+
+        const bool gallop = m > n * SETOP_GALLOP_RATIO
+                            || n > m * SETOP_GALLOP_RATIO;
+        char *out = res->payload;
+        register size_t i = 0, j = 0, k;
+
+        while (i < m && j < n) {
+            register int c = cmp(a + i * sz, b + j * sz);
+
+            if (c < 0) {
+                k = gallop ? i + vec_gallop(a + i * sz, m - i, sz, b + j * sz,
+                                            cmp)
+                           : i + 1;
+                if (op != SETOP_INTERSECT) {
+                    memcpy(out, a + i * sz, (k - i) * sz);
+                    out += (k - i) * sz;
+                }
+                i = k;
+            } else if (c > 0) {
+                k = gallop ? j + vec_gallop(b + j * sz, n - j, sz, a + i * sz,
+                                            cmp)
+                           : j + 1;
+                if (op == SETOP_UNION) {
+                    memcpy(out, b + j * sz, (k - j) * sz);
+                    out += (k - j) * sz;
+                }
+                j = k;
+            } else {
+                if (op != SETOP_DIFFERENCE) {
+                    memcpy(out, a + i * sz, sz);
+                    out += sz;
+                }
+                i++;
+                j++;
+            }
+        }
+
+        if (op != SETOP_INTERSECT) {
+            memcpy(out, a + i * sz, (m - i) * sz);
+            out += (m - i) * sz;
+        }
+
+        if (op == SETOP_UNION) {
+            memcpy(out, b + j * sz, (n - j) * sz);
+            out += (n - j) * sz;
+        }
+
+        res->len = (out - (char *) res->payload) / sz;
+        res->sorted = true;
+
+        return res;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+extern pcr_vector *pcr_vector_union(const pcr_vector *lhs,
+                                        const pcr_vector *rhs,
+                                        pcr_comparator *cmp, pcr_exception ex)
+{
+    return vec_setop(lhs, rhs, cmp, SETOP_UNION, ex);
+}
+
+
+extern pcr_vector *pcr_vector_intersect(const pcr_vector *lhs,
+                                            const pcr_vector *rhs,
+                                            pcr_comparator *cmp,
+                                            pcr_exception ex)
+{
+    return vec_setop(lhs, rhs, cmp, SETOP_INTERSECT, ex);
+}
+
+
+extern pcr_vector *pcr_vector_difference(const pcr_vector *lhs,
+                                            const pcr_vector *rhs,
+                                            pcr_comparator *cmp,
+                                            pcr_exception ex)
+{
+    return vec_setop(lhs, rhs, cmp, SETOP_DIFFERENCE, ex);
+}
+
+
+extern void pcr_vector_iterate(const pcr_vector *ctx, pcr_iterator *itr,
+                                    void *opt, pcr_exception ex)
+{
+    pcr_assert_handle(ctx && itr, ex);
+
+    pcr_exception_try (x) {
+        for (register size_t i = 0, len = ctx->len; i < len; i++)
+            itr(vec_at(ctx, i), i + 1, opt, x);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+extern void pcr_vector_muterate(pcr_vector **ctx, pcr_muterator *mtr, void *opt,
+                                        pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx && mtr, ex);
+
+    pcr_exception_try (x) {
+        pcr_vector *hnd = vec_fork(ctx, x);
+        hnd->sorted = false;
+
+        for (register size_t i = 0, len = hnd->len; i < len; i++)
+            mtr(vec_at(hnd, i), i + 1, opt, x);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the vec_par struct. This struct holds the state shared by the workers
+ * of a parallel iteration over a vector. Exactly one of @itr and @mtr is set,
+ * depending on whether the iteration is read-only or mutating. */
+struct vec_par {
+    pcr_vector *vec;
+    pcr_iterator *itr;
+    pcr_muterator *mtr;
+    void **opt;
+    size_t len;
+};
+
+
+/* Define the vec_par_run() helper function. This is the worker task for the
+ * parallel iterations; the index range of the vector is split into the number
+ * of chunks requested by the caller, and each worker processes the chunks
+ * assigned to it in a round-robin fashion, passing each chunk its own context.
+ * Element indices passed to the callbacks remain global 1-based indices. */
+static void
+vec_par_run(size_t id, size_t len, void *opt, pcr_exception ex)
+{
+    struct vec_par *vp = (struct vec_par *) opt;
+    const size_t vlen = vp->vec->len;
+
+    pcr_exception_try (x) {
+        for (register size_t c = id; c < vp->len; c += len) {
+            register size_t i = vlen * c / vp->len;
+            register size_t end = vlen * (c + 1) / vp->len;
+            void *copt = vp->opt ? vp->opt[c] : NULL;
+
+            if (vp->itr) {
+                for (; i < end; i++)
+                    vp->itr(vec_at(vp->vec, i), i + 1, copt, x);
+            } else {
+                for (; i < end; i++)
+                    vp->mtr(vec_at(vp->vec, i), i + 1, copt, x);
+            }
+        }
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the vec_par() helper function. This function runs a parallel
+ * iteration over @vp->len chunks across as many workers as are available, but
+ * never more workers than there are chunks. */
+static void
+vec_par(struct vec_par *vp, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        register size_t wrk = pcr_worker_count();
+        pcr_worker_run(wrk < vp->len ? wrk : vp->len, &vec_par_run, vp, x);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+extern void pcr_vector_iterate_par(const pcr_vector *ctx, pcr_iterator *itr,
+                                        void **opt, size_t len,
+                                        pcr_exception ex)
+{
+    pcr_assert_handle(ctx && itr, ex);
+    pcr_assert_range(len, ex);
+
+    pcr_exception_try (x) {
+        struct vec_par vp = {.vec = (pcr_vector *) ctx, .itr = itr, .opt = opt,
+                             .len = len};
+        vec_par(&vp, x);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+extern void pcr_vector_muterate_par(pcr_vector **ctx, pcr_muterator *mtr,
+                                        void **opt, size_t len,
+                                        pcr_exception ex)
+{
+    pcr_assert_handle(ctx && *ctx && mtr, ex);
+    pcr_assert_range(len, ex);
+
+    pcr_exception_try (x) {
+        struct vec_par vp = {.vec = vec_fork(ctx, x), .mtr = mtr, .opt = opt,
+                             .len = len};
+        vp.vec->sorted = false;
+        vec_par(&vp, x);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+/* Define the vec_i64() and vec_f64() helper functions. These functions check
+ * that @ctx holds 64-bit elements, and return its payload as an array of the
+ * respective type. */
+static inline int64_t *
+vec_i64(const pcr_vector *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_state(ctx->sz == sizeof (int64_t), ex);
+
+    return ctx->payload;
+}
+
+static inline double *
+vec_f64(const pcr_vector *ctx, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    pcr_assert_state(ctx->sz == sizeof (double), ex);
+
+    return ctx->payload;
+}
+
+
+extern int64_t pcr_vector_sum_i64(const pcr_vector *ctx, pcr_exception ex)
+{
+    int64_t *arr = vec_i64(ctx, ex);
+    return pcr_simd_sum_i64__(arr, ctx->len);
+}
+
+
+extern double pcr_vector_sum_f64(const pcr_vector *ctx, pcr_exception ex)
+{
+    double *arr = vec_f64(ctx, ex);
+    return pcr_simd_sum_f64__(arr, ctx->len);
+}
+
+
+extern int64_t pcr_vector_min_i64(const pcr_vector *ctx, pcr_exception ex)
+{
+    int64_t *arr = vec_i64(ctx, ex);
+    pcr_assert_state(ctx->len, ex);
+
+    return pcr_simd_minmax_i64__(arr, ctx->len, false);
+}
+
+
+extern int64_t pcr_vector_max_i64(const pcr_vector *ctx, pcr_exception ex)
+{
+    int64_t *arr = vec_i64(ctx, ex);
+    pcr_assert_state(ctx->len, ex);
+
+    return pcr_simd_minmax_i64__(arr, ctx->len, true);
+}
+
+
+extern double pcr_vector_min_f64(const pcr_vector *ctx, pcr_exception ex)
+{
+    double *arr = vec_f64(ctx, ex);
+    pcr_assert_state(ctx->len, ex);
+
+    return pcr_simd_minmax_f64__(arr, ctx->len, false);
+}
+
+
+extern double pcr_vector_max_f64(const pcr_vector *ctx, pcr_exception ex)
+{
+    double *arr = vec_f64(ctx, ex);
+    pcr_assert_state(ctx->len, ex);
+
+    return pcr_simd_minmax_f64__(arr, ctx->len, true);
+}
+
+
+extern size_t pcr_vector_count_i64(const pcr_vector *ctx, PCR_VECTOR_CMP cmp,
+                                   int64_t val, pcr_exception ex)
+{
+    int64_t *arr = vec_i64(ctx, ex);
+    return pcr_simd_select_i64__(arr, ctx->len, cmp, val, NULL);
+}
+
+
+extern size_t pcr_vector_count_f64(const pcr_vector *ctx, PCR_VECTOR_CMP cmp,
+                                   double val, pcr_exception ex)
+{
+    double *arr = vec_f64(ctx, ex);
+    return pcr_simd_select_f64__(arr, ctx->len, cmp, val, NULL);
+}
+
+
+/* Implement the pcr_vector_select_i64() interface function. The selection
+ * vector holds the 1-based indices of the matching elements in ascending
+ * order, and so it is flagged as sorted. */
+extern pcr_vector *pcr_vector_select_i64(const pcr_vector *ctx,
+                                         PCR_VECTOR_CMP cmp, int64_t val,
+                                         pcr_exception ex)
+{
+    int64_t *arr = vec_i64(ctx, ex);
+
+    pcr_exception_try (x) {
+        pcr_vector *sel = vec_alloc(sizeof (size_t), ctx->len ? ctx->len : 1,
+                                    x);
+
+        sel->len = pcr_simd_select_i64__(arr, ctx->len, cmp, val, sel->payload);
+        sel->sorted = true;
+
+        return sel;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+extern pcr_vector *pcr_vector_select_f64(const pcr_vector *ctx,
+                                         PCR_VECTOR_CMP cmp, double val,
+                                         pcr_exception ex)
+{
+    double *arr = vec_f64(ctx, ex);
+
+    pcr_exception_try (x) {
+        pcr_vector *sel = vec_alloc(sizeof (size_t), ctx->len ? ctx->len : 1,
+                                    x);
+
+        sel->len = pcr_simd_select_f64__(arr, ctx->len, cmp, val, sel->payload);
+        sel->sorted = true;
+
+        return sel;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+extern void pcr_vector_arith_i64(pcr_vector **ctx, PCR_VECTOR_ARITH op,
+                                 int64_t val, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    (void) vec_i64(*ctx, ex);
+    pcr_assert_range(op != PCR_VECTOR_ARITH_DIV || val, ex);
+
+    pcr_exception_try (x) {
+        pcr_vector *hnd = vec_fork(ctx, x);
+
+        pcr_simd_arith_i64__(hnd->payload, hnd->len, op, val);
+        hnd->sorted = false;
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+extern void pcr_vector_arith_f64(pcr_vector **ctx, PCR_VECTOR_ARITH op,
+                                 double val, pcr_exception ex)
+{
+    pcr_assert_handle(ctx, ex);
+    (void) vec_f64(*ctx, ex);
+
+    pcr_exception_try (x) {
+        pcr_vector *hnd = vec_fork(ctx, x);
+
+        pcr_simd_arith_f64__(hnd->payload, hnd->len, op, val);
+        hnd->sorted = false;
+    }
+
+    pcr_exception_unwind(ex);
+}
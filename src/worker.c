@@ -0,0 +1,125 @@
+#include <threads.h>
+#include <unistd.h>
+#include "./api.h"
+
+
+/* Define the worker struct. Each instance of this struct holds the state of a
+ * single worker in a call to pcr_worker_run(), including the ID of the
+ * exception (if any) that was thrown by its task. Since exceptions are jump
+ * buffers, they can't cross thread boundaries, and so the ID is recorded here
+ * and rethrown on the calling thread once all workers have been joined. */
+struct worker {
+    pcr_worker_task *task;
+    void *opt;
+    size_t id;
+    size_t len;
+    PCR_EXCEPTION exid;
+};
+
+
+/* Declare the worker limit set through pcr_worker_limit(). A value of 0 means
+ * that the number of online processors is used instead. */
+static size_t worker_limit = 0;
+
+
+/* Define the worker_exec() helper function. This function runs the task of a
+ * worker @w within its own exception frame, and returns the ID of the exception
+ * thrown by the task, or PCR_EXCEPTION_NONE if the task succeeded. */
+static PCR_EXCEPTION
+worker_exec(struct worker *w)
+{
+    pcr_exception_try (x) {
+        w->task(w->id, w->len, w->opt, x);
+        return PCR_EXCEPTION_NONE;
+    }
+
+    pcr_exception_catchall {
+        pcr_exception_log();
+    }
+
+    return pcr__exid__;
+}
+
+
+/* Define the worker_main() helper function. This is the entry point of each
+ * spawned worker thread; we need to register the thread with the garbage
+ * collector for the duration of the task since the task may allocate. */
+static int
+worker_main(void *arg)
+{
+    struct worker *w = (struct worker *) arg;
+
+    pcr_mempool_thread_enter__();
+    w->exid = worker_exec(w);
+    pcr_mempool_thread_exit__();
+
+    return 0;
+}
+
+
+/* Implement the pcr_worker_count() interface function. */
+extern size_t
+pcr_worker_count(void)
+{
+    size_t len = worker_limit;
+
+    if (pcr_hint_likely (!len)) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        len = cpus > 0 ? (size_t) cpus : 1;
+    }
+
+    return len < PCR_WORKER_MAX ? len : PCR_WORKER_MAX;
+}
+
+
+/* Implement the pcr_worker_limit() interface function. */
+extern void
+pcr_worker_limit(size_t len)
+{
+    worker_limit = len;
+}
+
+
+/* Implement the pcr_worker_run() interface function. The calling thread runs
+ * the task of the first worker itself, and spawns threads for the rest. In the
+ * unlikely event that a thread can't be spawned, its task is run on the calling
+ * thread after the first worker is done, so that every task is always run
+ * exactly once. */
+extern void
+pcr_worker_run(size_t len, pcr_worker_task *task, void *opt, pcr_exception ex)
+{
+    pcr_assert_handle(task, ex);
+    pcr_assert_range(len && len <= PCR_WORKER_MAX, ex);
+
+    struct worker w[PCR_WORKER_MAX];
+    thrd_t thr[PCR_WORKER_MAX];
+    bool spawned[PCR_WORKER_MAX];
+
+    for (register size_t i = 0; i < len; i++) {
+        w[i].task = task;
+        w[i].opt = opt;
+        w[i].id = i;
+        w[i].len = len;
+        w[i].exid = PCR_EXCEPTION_NONE;
+    }
+
+    if (len > 1)
+        pcr_mempool_thread_init__();
+
+    for (register size_t i = 1; i < len; i++)
+        spawned[i] = thrd_create(&thr[i], &worker_main, &w[i]) == thrd_success;
+
+    w[0].exid = worker_exec(&w[0]);
+
+    for (register size_t i = 1; i < len; i++) {
+        if (pcr_hint_likely (spawned[i]))
+            (void) thrd_join(thr[i], NULL);
+        else
+            w[i].exid = worker_exec(&w[i]);
+    }
+
+    for (register size_t i = 0; i < len; i++) {
+        if (pcr_hint_unlikely (w[i].exid))
+            pcr_exception_throw(ex, w[i].exid);
+    }
+}
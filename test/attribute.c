@@ -202,6 +202,73 @@ test_new_9(pcr_string **desc, pcr_exception ex)
 }
 
 
+static bool
+test_new_10(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_new_take() adopts a key and value built by the"
+            " caller";
+
+    pcr_exception_try (x) {
+        int64_t *value = pcr_mempool_alloc(sizeof *value, x);
+        *value = -42;
+
+        pcr_attribute *attr = pcr_attribute_new_take(PCR_ATTRIBUTE_INT,
+                                                     pcr_string_new("foo", x),
+                                                     value, x);
+
+        return pcr_attribute_type(attr, x) == PCR_ATTRIBUTE_INT
+               && !strcmp(pcr_attribute_key(attr, x), "foo")
+               && *((int64_t *) pcr_attribute_value(attr, x)) == -42;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_new_11(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_new_text_take() adopts a text value built by the"
+            " caller";
+
+    pcr_exception_try (x) {
+        pcr_string *value = pcr_string_add(pcr_string_new("foo", x), "bar", x);
+        pcr_attribute *attr = pcr_attribute_new_text_take(pcr_string_new("key",
+                                                          x), value, x);
+
+        return pcr_attribute_type(attr, x) == PCR_ATTRIBUTE_TEXT
+               && !strcmp(pcr_attribute_string(attr, x), "foobar")
+               && pcr_attribute_valuesz(attr, x) == pcr_string_sz(value, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_new_12(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_new_take() throws PCR_EXCEPTION_STRING if passed an"
+            " empty key";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_attribute_new_take(PCR_ATTRIBUTE_NULL,
+                                      pcr_string_new("", x), NULL, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STRING) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
 /******************************************************************************
  * pcr_attribute_copy() test cases
  */
@@ -402,6 +469,112 @@ test_value_1(pcr_string **desc, pcr_exception ex)
 }
 
 
+/******************************************************************************
+ * pcr_attribute_int(), pcr_attribute_float() and pcr_attribute_text_ref() test
+ * cases
+ */
+
+
+static bool
+test_typed_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_int() and pcr_attribute_float() read numeric values";
+
+    pcr_exception_try (x) {
+        pcr_attribute *i = pcr_attribute_new_int("foo", -1234567890123, x);
+        pcr_attribute *f = pcr_attribute_new_float("bar", 3.25, x);
+
+        return pcr_attribute_int(i, x) == -1234567890123
+               && pcr_attribute_float(f, x) == 3.25;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_typed_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_text_ref() returns the text value without copying";
+
+    pcr_exception_try (x) {
+        pcr_string *value = pcr_string_new("foobar", x);
+        pcr_attribute *attr = pcr_attribute_new_text_take(pcr_string_new("key",
+                                                          x), value, x);
+
+        return pcr_attribute_text_ref(attr, x) == value;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_typed_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_int() throws PCR_EXCEPTION_STATE if the attribute is"
+            " not an integer";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_attribute_int(pcr_attribute_new_float("foo", 1.0, x), x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_typed_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_new_blob() copies the blob data once";
+
+    pcr_exception_try (x) {
+        unsigned char data[] = {0x01, 0xab, 0x00, 0x7f};
+        pcr_attribute *attr = pcr_attribute_new_blob("foo", data, sizeof data,
+                                                     x);
+        data[0] = 0xff;
+
+        pcr_blob blob = pcr_attribute_blob(attr, x);
+        const unsigned char *cmp = blob.data;
+
+        return pcr_attribute_type(attr, x) == PCR_ATTRIBUTE_BLOB
+               && pcr_attribute_valuesz(attr, x) == sizeof data
+               && blob.len == sizeof data && cmp[0] == 0x01 && cmp[3] == 0x7f
+               && !strcmp(pcr_attribute_string(attr, x), "01ab007f");
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_typed_5(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_new_blob() accepts an empty blob";
+
+    pcr_exception_try (x) {
+        pcr_attribute *attr = pcr_attribute_new_blob("foo", NULL, 0, x);
+        pcr_blob blob = pcr_attribute_blob(attr, x);
+
+        return !blob.len && !pcr_attribute_valuesz(attr, x)
+               && !*pcr_attribute_string(attr, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
 /******************************************************************************
  * pcr_attribute_type() test cases
  */
@@ -794,6 +967,491 @@ test_json_6(pcr_string **desc, pcr_exception ex)
 }
 
 
+/******************************************************************************
+ * pcr_attribute_encode() and pcr_attribute_decode() test cases
+ */
+
+
+static const unsigned char SAMPLE_BLOB[] = {0x00, 0x01, 0xfe, 0xff};
+
+
+static pcr_attribute_vector *
+sample_attribs(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        const pcr_attribute *arr[] = {
+            pcr_attribute_new_null("null", x),
+            pcr_attribute_new_int("min", INT64_MIN, x),
+            pcr_attribute_new_int("max", INT64_MAX, x),
+            pcr_attribute_new_int("small", -3, x),
+            pcr_attribute_new_float("float", -123.456789e-200, x),
+            pcr_attribute_new_text("text", "Вороно́й", x),
+            pcr_attribute_new_text("empty", "", x),
+            pcr_attribute_new_blob("blob", SAMPLE_BLOB, sizeof SAMPLE_BLOB, x)
+        };
+
+        return pcr_attribute_vector_new_2(arr, sizeof arr / sizeof *arr, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+static pcr_blob
+sample_varint(unsigned char last, bool longer, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_blob bfr = pcr_attribute_encode(pcr_attribute_new_int("i",
+                                                                  INT64_MIN,
+                                                                  x), x);
+        unsigned char *data = pcr_mempool_alloc(bfr.len + 1, x);
+
+        memcpy(data, bfr.data, bfr.len);
+        data[bfr.len - 1] = last;
+        data[bfr.len] = 0x00;
+
+        bfr.data = data;
+        bfr.len += longer;
+        return bfr;
+    }
+
+    pcr_exception_unwind(ex);
+    return (pcr_blob) {0};
+}
+
+
+static bool
+sample_attrib_match(const pcr_attribute *lhs, const pcr_attribute *rhs,
+                    pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        PCR_ATTRIBUTE type = pcr_attribute_type(lhs, x);
+
+        if (type != pcr_attribute_type(rhs, x)
+            || strcmp(pcr_attribute_key(lhs, x), pcr_attribute_key(rhs, x)))
+            return false;
+
+        switch (type) {
+            case PCR_ATTRIBUTE_INT:
+                return pcr_attribute_int(lhs, x) == pcr_attribute_int(rhs, x);
+
+            case PCR_ATTRIBUTE_FLOAT:
+                return pcr_attribute_float(lhs, x)
+                       == pcr_attribute_float(rhs, x);
+
+            default:
+                return !strcmp(pcr_attribute_string(lhs, x),
+                               pcr_attribute_string(rhs, x));
+        }
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_encode_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_decode() round-trips each attribute type through"
+            " pcr_attribute_encode()";
+
+    pcr_exception_try (x) {
+        pcr_attribute_vector *vec = sample_attribs(x);
+        register size_t len = pcr_attribute_vector_len(vec, x);
+
+        for (register size_t i = 1; i <= len; i++) {
+            pcr_attribute *attr = pcr_attribute_vector_elem(vec, i, x);
+            pcr_blob bfr = pcr_attribute_encode(attr, x);
+
+            if (!sample_attrib_match(attr, pcr_attribute_decode(bfr, x), x))
+                return false;
+        }
+
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_encode_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_decode_ref() decodes text and blobs in place";
+
+    pcr_exception_try (x) {
+        pcr_blob tbfr = pcr_attribute_encode(pcr_attribute_new_text("k", "v",
+                                                                    x), x);
+        pcr_blob bbfr = pcr_attribute_encode(pcr_attribute_new_blob("k",
+                                             SAMPLE_BLOB, sizeof SAMPLE_BLOB,
+                                             x), x);
+
+        const char *tend = (const char *) tbfr.data + tbfr.len;
+        const pcr_string *text = pcr_attribute_text_ref(
+                                     pcr_attribute_decode_ref(tbfr, x), x);
+        pcr_blob blob = pcr_attribute_blob(pcr_attribute_decode_ref(bbfr, x),
+                                           x);
+
+        return tbfr.len == 8 && text == tend - 2 && !strcmp(text, "v")
+               && blob.data == (const char *) bbfr.data + bbfr.len
+                               - sizeof SAMPLE_BLOB
+               && !memcmp(blob.data, SAMPLE_BLOB, sizeof SAMPLE_BLOB);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_encode_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_vector_decode() round-trips an attribute vector"
+            " through pcr_attribute_vector_encode() in less space than JSON";
+
+    pcr_exception_try (x) {
+        pcr_attribute_vector *vec = sample_attribs(x);
+        pcr_blob bfr = pcr_attribute_vector_encode(vec, x);
+
+        pcr_attribute_vector *cmp = pcr_attribute_vector_decode(bfr, x);
+        pcr_attribute_vector *ref = pcr_attribute_vector_decode_ref(bfr, x);
+        register size_t len = pcr_attribute_vector_len(vec, x);
+
+        pcr_json_writer *jw = pcr_json_writer_new(x);
+        for (register size_t i = 1; i <= len; i++) {
+            pcr_attribute *attr = pcr_attribute_vector_elem(vec, i, x);
+            pcr_attribute_json_write(attr, jw, x);
+
+            if (!sample_attrib_match(attr, pcr_attribute_vector_elem(cmp, i, x),
+                                     x)
+                || !sample_attrib_match(attr,
+                                        pcr_attribute_vector_elem(ref, i, x),
+                                        x))
+                return false;
+        }
+
+        return pcr_attribute_vector_len(cmp, x) == len
+               && pcr_attribute_vector_len(ref, x) == len
+               && bfr.len < pcr_json_writer_len(jw, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_encode_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_decode() throws PCR_EXCEPTION_PARSE if the buffer is"
+            " truncated";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_blob bfr = pcr_attribute_encode(pcr_attribute_new_float("f", 1.5,
+                                                                    x), x);
+        bfr.len--;
+        (void) pcr_attribute_decode(bfr, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_PARSE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_encode_5(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_vector_decode() throws PCR_EXCEPTION_PARSE if the"
+            " encoding version doesn't match";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_blob bfr = pcr_attribute_vector_encode(sample_attribs(x), x);
+        unsigned char *data = pcr_mempool_alloc(bfr.len, x);
+
+        memcpy(data, bfr.data, bfr.len);
+        data[0]++;
+        bfr.data = data;
+
+        (void) pcr_attribute_vector_decode(bfr, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_PARSE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_encode_6(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_decode() throws PCR_EXCEPTION_PARSE if a varint runs"
+            " past ten bytes";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_attribute_decode(sample_varint(0x81, true, x), x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_PARSE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_encode_7(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_decode() throws PCR_EXCEPTION_PARSE if a varint"
+            " overflows 64 bits";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        if (pcr_attribute_int(pcr_attribute_decode(sample_varint(0x01, false,
+                                                                 x), x), x)
+            != INT64_MIN)
+            return false;
+
+        (void) pcr_attribute_decode(sample_varint(0x02, false, x), x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_PARSE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_attribute_cmp() and pcr_attribute_hash() test cases
+ */
+
+
+static bool
+test_cmp_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_cmp() orders NULL before numbers before text before"
+            " blobs";
+
+    pcr_exception_try (x) {
+        const pcr_attribute *n = pcr_attribute_new_null("n", x);
+        const pcr_attribute *i = pcr_attribute_new_int("i", INT64_MAX, x);
+        const pcr_attribute *t = pcr_attribute_new_text("t", "", x);
+        const pcr_attribute *b = pcr_attribute_new_blob("b", "", 0, x);
+
+        return pcr_attribute_cmp(n, i, x) < 0
+               && pcr_attribute_cmp(i, t, x) < 0
+               && pcr_attribute_cmp(t, b, x) < 0
+               && pcr_attribute_cmp(b, n, x) > 0
+               && !pcr_attribute_cmp(n, pcr_attribute_new_null("m", x), x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_cmp_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_cmp() compares integers and floats exactly by their"
+            " numeric values";
+
+    pcr_exception_try (x) {
+        const pcr_attribute *i = pcr_attribute_new_int("i", 3, x);
+        const pcr_attribute *big = pcr_attribute_new_int("i",
+                                                         (1LL << 53) + 1, x);
+        const pcr_attribute *nan = pcr_attribute_new_float("f", 0.0 / 0.0, x);
+
+        return !pcr_attribute_cmp(i, pcr_attribute_new_float("f", 3.0, x), x)
+               && pcr_attribute_cmp(i, pcr_attribute_new_float("f", 3.5, x),
+                                    x) < 0
+               && pcr_attribute_cmp(pcr_attribute_new_float("f", -3.5, x),
+                                    pcr_attribute_new_int("i", -3, x), x) < 0
+               && pcr_attribute_cmp(big,
+                                    pcr_attribute_new_float("f", 0x1p53, x),
+                                    x) > 0
+               && pcr_attribute_cmp(pcr_attribute_new_int("i", INT64_MAX, x),
+                                    pcr_attribute_new_float("f", 0x1p63, x),
+                                    x) < 0
+               && pcr_attribute_cmp(nan, i, x) < 0
+               && !pcr_attribute_cmp(nan, nan, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_cmp_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_cmp() compares text and blobs bytewise, ignoring"
+            " keys";
+
+    pcr_exception_try (x) {
+        return pcr_attribute_cmp(pcr_attribute_new_text("a", "abc", x),
+                                 pcr_attribute_new_text("b", "abd", x), x) < 0
+               && !pcr_attribute_cmp(pcr_attribute_new_text("a", "abc", x),
+                                     pcr_attribute_new_text("b", "abc", x), x)
+               && pcr_attribute_cmp(pcr_attribute_new_blob("a", "ab", 2, x),
+                                    pcr_attribute_new_blob("b", "abc", 3, x),
+                                    x) < 0
+               && pcr_attribute_cmp(pcr_attribute_new_blob("a", "\xff", 1, x),
+                                    pcr_attribute_new_blob("b", "\x01", 1, x),
+                                    x) > 0;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_cmp_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_vector_sort() throws PCR_EXCEPTION_HANDLE if the"
+            " vector holds a null attribute";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_attribute_vector *vec = pcr_attribute_vector_new(x);
+        pcr_attribute_vector_push(&vec, pcr_attribute_new_int("a", 2, x), x);
+        pcr_attribute_vector_push_take(&vec, NULL, x);
+        pcr_attribute_vector_push(&vec, pcr_attribute_new_int("b", 1, x), x);
+
+        pcr_attribute_vector_sort(&vec, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_HANDLE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_hash_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_hash() hashes attributes that compare equal to the"
+            " same value";
+
+    pcr_exception_try (x) {
+        return pcr_attribute_hash(pcr_attribute_new_int("a", 3, x), x)
+                   == pcr_attribute_hash(pcr_attribute_new_float("b", 3.0, x),
+                                         x)
+               && pcr_attribute_hash(pcr_attribute_new_float("a", 0.0, x), x)
+                   == pcr_attribute_hash(pcr_attribute_new_float("b", -0.0, x),
+                                         x)
+               && pcr_attribute_hash(pcr_attribute_new_text("a", "xyz", x), x)
+                   == pcr_attribute_hash(pcr_attribute_new_text("b", "xyz", x),
+                                         x)
+               && pcr_attribute_hash(pcr_attribute_new_text("a", "xyz", x), x)
+                   != pcr_attribute_hash(pcr_attribute_new_blob("b", "xyz", 3,
+                                                                x), x)
+               && pcr_attribute_hash(pcr_attribute_new_int("a", 3, x), x)
+                   != pcr_attribute_hash(pcr_attribute_new_float("b", 3.5, x),
+                                         x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_hash_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_vector_hash() and pcr_attribute_vector_cmp() agree"
+            " with pcr_attribute_hash() and pcr_attribute_cmp()";
+
+    pcr_exception_try (x) {
+        pcr_attribute_vector *lhs = sample_attribs(x);
+        pcr_attribute_vector *rhs = pcr_attribute_vector_copy(lhs, x);
+        const size_t len = pcr_attribute_vector_len(lhs, x);
+
+        pcr_attribute_vector_sort(&rhs, x);
+        pcr_vector *hash = pcr_attribute_vector_hash(lhs, x);
+        pcr_vector *cmp = pcr_attribute_vector_cmp(lhs, rhs, x);
+
+        if (pcr_vector_len(hash, x) != len || pcr_vector_len(cmp, x) != len)
+            return false;
+
+        for (register size_t i = 1; i <= len; i++) {
+            pcr_attribute *l = pcr_attribute_vector_elem(lhs, i, x);
+            pcr_attribute *r = pcr_attribute_vector_elem(rhs, i, x);
+
+            if (*(const uint64_t *) pcr_vector_elem(hash, i, x)
+                    != pcr_attribute_hash(l, x)
+                || *(const int *) pcr_vector_elem(cmp, i, x)
+                    != pcr_attribute_cmp(l, r, x))
+                return false;
+
+            if (i > 1 && pcr_attribute_cmp(pcr_attribute_vector_elem(rhs,
+                                                                     i - 1, x),
+                                           r, x) > 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+test_hash_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_vector_cmp() throws PCR_EXCEPTION_RANGE if the"
+            " vectors differ in length";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_attribute_vector *lhs = sample_attribs(x);
+        pcr_attribute_vector *rhs = pcr_attribute_vector_new(x);
+        (void) pcr_attribute_vector_cmp(lhs, rhs, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
 /******************************************************************************
  * pcr_attribute_testsuite() interface
  */
@@ -801,12 +1459,17 @@ test_json_6(pcr_string **desc, pcr_exception ex)
 
 static pcr_unittest *unit_tests[] = {
     test_new_1, test_new_2, test_new_3, test_new_4, test_new_5, test_new_6,
-    test_new_7, test_new_8, test_new_9, test_copy_1, test_copy_2, test_copy_3,
-    test_copy_4, test_copy_5, test_copy_6, test_key_1, test_value_1,
-    test_type_1, test_valuesz_1, test_valuesz_2, test_valuesz_3, test_valuesz_4,
-    test_valuesz_5, test_valuesz_6, test_string_1, test_string_2, test_string_3,
-    test_string_4, test_string_5, test_string_6, test_json_1, test_json_2,
-    test_json_3, test_json_4, test_json_5, test_json_6
+    test_new_7, test_new_8, test_new_9, test_new_10, test_new_11, test_new_12,
+    test_copy_1, test_copy_2, test_copy_3, test_copy_4, test_copy_5,
+    test_copy_6, test_key_1, test_value_1, test_typed_1, test_typed_2,
+    test_typed_3, test_typed_4, test_typed_5, test_type_1, test_valuesz_1,
+    test_valuesz_2, test_valuesz_3, test_valuesz_4, test_valuesz_5,
+    test_valuesz_6, test_string_1, test_string_2, test_string_3, test_string_4,
+    test_string_5, test_string_6, test_json_1, test_json_2, test_json_3,
+    test_json_4, test_json_5, test_json_6, test_encode_1, test_encode_2,
+    test_encode_3, test_encode_4, test_encode_5, test_encode_6, test_encode_7,
+    test_cmp_1, test_cmp_2, test_cmp_3, test_cmp_4, test_hash_1, test_hash_2,
+    test_hash_3
 };
 
 
@@ -0,0 +1,405 @@
+#include <string.h>
+#include "./suites.h"
+
+
+static pcr_dbase *
+sample_dbase(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_dbase *db = pcr_dbase_new(PCR_DBASE_SQLITE, ":memory:", x);
+        const unsigned char data[] = {0xca, 0xfe};
+
+        pcr_sql *sql = pcr_sql_new("CREATE TABLE users (id INTEGER, name TEXT,"
+                                   " score REAL DEFAULT @score, data BLOB);",
+                                   x);
+        pcr_sql_bind_float(&sql, "@score", 0.0, x);
+        pcr_dbase_command(db, sql, x);
+
+        const pcr_string *insert = "INSERT INTO users VALUES (@id, @name,"
+                                   " @score, @data);";
+
+        sql = pcr_sql_new(insert, x);
+        pcr_sql_bind_int(&sql, "@id", 1, x);
+        pcr_sql_bind_text(&sql, "@name", "Ann", x);
+        pcr_sql_bind_float(&sql, "@score", 1.5, x);
+        pcr_sql_bind_blob(&sql, "@data", data, sizeof data, x);
+        pcr_dbase_command(db, sql, x);
+
+        sql = pcr_sql_new(insert, x);
+        pcr_sql_bind_int(&sql, "@id", 2, x);
+        pcr_sql_bind_null(&sql, "@name", x);
+        pcr_sql_bind_null(&sql, "@score", x);
+        pcr_sql_bind_null(&sql, "@data", x);
+        pcr_dbase_command(db, sql, x);
+
+        sql = pcr_sql_new(insert, x);
+        pcr_sql_bind_int(&sql, "@id", 3, x);
+        pcr_sql_bind_text(&sql, "@name", "Bob", x);
+        pcr_sql_bind_float(&sql, "@score", -2.25, x);
+        pcr_sql_bind_null(&sql, "@data", x);
+        pcr_dbase_command(db, sql, x);
+
+        return db;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+static pcr_cursor *
+sample_cursor(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_sql *sql = pcr_sql_new("SELECT id, name, score, data FROM users"
+                                   " WHERE id >= @min ORDER BY id;", x);
+        pcr_sql_bind_int(&sql, "@min", 1, x);
+
+        return pcr_dbase_open_cursor(sample_dbase(x), sql, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/******************************************************************************
+ * pcr_dbase_open_cursor() and pcr_cursor_next() test cases
+ */
+
+
+static bool
+cursor_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_cursor_next() steps through each row in turn, and then returns"
+            " false";
+
+    pcr_exception_try (x) {
+        pcr_cursor *cur = sample_cursor(x);
+        int64_t id = 0;
+
+        if (pcr_cursor_cols(cur, x) != 4)
+            return false;
+
+        while (pcr_cursor_next(cur, x)) {
+            if (pcr_cursor_int(cur, 1, x) != ++id
+                || strcmp(pcr_cursor_key(cur, 1, x), "id"))
+                return false;
+        }
+
+        return id == 3 && !pcr_cursor_next(cur, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+cursor_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_cursor_int(), pcr_cursor_float(), pcr_cursor_text() and"
+            " pcr_cursor_blob() read each type of column";
+
+    pcr_exception_try (x) {
+        pcr_cursor *cur = sample_cursor(x);
+        (void) pcr_cursor_next(cur, x);
+
+        pcr_blob blob = pcr_cursor_blob(cur, 4, x);
+        const unsigned char *data = blob.data;
+
+        return pcr_cursor_int(cur, 1, x) == 1
+               && !strcmp(pcr_cursor_text(cur, 2, x), "Ann")
+               && pcr_cursor_float(cur, 3, x) == 1.5
+               && blob.len == 2 && data[0] == 0xca && data[1] == 0xfe;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+cursor_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_cursor_type() and pcr_cursor_attrib() report NULL columns";
+
+    pcr_exception_try (x) {
+        pcr_cursor *cur = sample_cursor(x);
+        (void) pcr_cursor_next(cur, x);
+        (void) pcr_cursor_next(cur, x);
+
+        pcr_attribute *attr = pcr_cursor_attrib(cur, 2, x);
+
+        return pcr_cursor_type(cur, 2, x) == PCR_ATTRIBUTE_NULL
+               && pcr_cursor_type(cur, 4, x) == PCR_ATTRIBUTE_NULL
+               && pcr_attribute_type(attr, x) == PCR_ATTRIBUTE_NULL
+               && !strcmp(pcr_attribute_key(attr, x), "name");
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+cursor_test_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_cursor_attrib() copies the value of the current row";
+
+    pcr_exception_try (x) {
+        pcr_cursor *cur = sample_cursor(x);
+        (void) pcr_cursor_next(cur, x);
+
+        pcr_attribute *name = pcr_cursor_attrib(cur, 2, x);
+        pcr_attribute *score = pcr_cursor_attrib(cur, 3, x);
+        (void) pcr_cursor_next(cur, x);
+
+        return !strcmp(pcr_attribute_text_ref(name, x), "Ann")
+               && pcr_attribute_float(score, x) == 1.5
+               && pcr_attribute_int(pcr_cursor_attrib(cur, 1, x), x) == 2;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+cursor_test_5(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_cursor_int() throws PCR_EXCEPTION_STATE if the column is not"
+            " an integer";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_cursor *cur = sample_cursor(x);
+        (void) pcr_cursor_next(cur, x);
+        (void) pcr_cursor_int(cur, 2, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+cursor_test_6(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_cursor_float() throws PCR_EXCEPTION_STATE if the column is"
+            " NULL";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_cursor *cur = sample_cursor(x);
+        (void) pcr_cursor_next(cur, x);
+        (void) pcr_cursor_next(cur, x);
+        (void) pcr_cursor_float(cur, 3, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+cursor_test_7(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_cursor_text() throws PCR_EXCEPTION_STATE if the column is a"
+            " blob";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_cursor *cur = sample_cursor(x);
+        (void) pcr_cursor_next(cur, x);
+        (void) pcr_cursor_text(cur, 4, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+cursor_test_8(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_cursor_blob() throws PCR_EXCEPTION_STATE if the column is"
+            " text";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_cursor *cur = sample_cursor(x);
+        (void) pcr_cursor_next(cur, x);
+        (void) pcr_cursor_blob(cur, 2, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+cursor_test_9(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_cursor_attrib() throws PCR_EXCEPTION_RANGE if passed column 0";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_cursor *cur = sample_cursor(x);
+        (void) pcr_cursor_next(cur, x);
+        (void) pcr_cursor_attrib(cur, 0, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+cursor_test_10(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_cursor_type() throws PCR_EXCEPTION_RANGE if passed a column"
+            " past the last";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_cursor *cur = sample_cursor(x);
+        (void) pcr_cursor_next(cur, x);
+        (void) pcr_cursor_type(cur, pcr_cursor_cols(cur, x) + 1, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+cursor_test_11(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_cursor_int() throws PCR_EXCEPTION_STATE if called before"
+            " pcr_cursor_next()";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_cursor_int(sample_cursor(x), 1, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_cursor_close() test cases
+ */
+
+
+static bool
+close_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_cursor_close() can be called more than once, and ends the"
+            " rows of the cursor";
+
+    pcr_exception_try (x) {
+        pcr_cursor *cur = sample_cursor(x);
+        bool row = pcr_cursor_next(cur, x);
+
+        pcr_cursor_close(cur);
+        pcr_cursor_close(cur);
+        pcr_cursor_close(NULL);
+
+        return row && !pcr_cursor_next(cur, x) && pcr_cursor_cols(cur, x) == 4;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+close_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_cursor_close() is harmless on a cursor that has run out of"
+            " rows";
+
+    pcr_exception_try (x) {
+        pcr_cursor *cur = sample_cursor(x);
+        while (pcr_cursor_next(cur, x))
+            ;
+
+        pcr_cursor_close(cur);
+        return !pcr_cursor_next(cur, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_dbase_testsuite() interface
+ */
+
+
+static pcr_unittest *unit_tests[] = {
+    &cursor_test_1, &cursor_test_2,  &cursor_test_3,  &cursor_test_4,
+    &cursor_test_5, &cursor_test_6,  &cursor_test_7,  &cursor_test_8,
+    &cursor_test_9, &cursor_test_10, &cursor_test_11, &close_test_1,
+    &close_test_2
+};
+
+
+extern pcr_testsuite *
+pcr_dbase_testsuite(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        const pcr_string *name = "PCR Database (pcr_dbase)";
+        const size_t len = sizeof unit_tests / sizeof *unit_tests;
+
+        return pcr_testsuite_new_2(name, unit_tests, len, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
@@ -0,0 +1,294 @@
+#include "./suites.h"
+
+
+/* Define the number of elements in the large sample deques; this is chosen so
+ * that the ring buffer grows and wraps around several times. */
+static const int64_t SAMPLE_LEN = 1000;
+
+
+static bool
+sample_match(const pcr_deque *ctx, int64_t first, int64_t step,
+             pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        register size_t len = pcr_deque_len(ctx, x);
+
+        for (register size_t i = 1; i <= len; i++) {
+            int64_t elem = *((int64_t *) pcr_deque_elem(ctx, i, x));
+            if (elem != first + (int64_t) (i - 1) * step)
+                return false;
+        }
+
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_deque_new() test cases
+ */
+
+
+static bool
+new_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_deque_new() creates an empty deque with a reference count of 1";
+
+    pcr_exception_try (x) {
+        pcr_deque *dq = pcr_deque_new(sizeof (int64_t), x);
+        return !pcr_deque_len(dq, x) && pcr_deque_refcount(dq, x) == 1;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+new_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_deque_new() throws PCR_EXCEPTION_RANGE if passed zero @elemsz";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_deque_new(0, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_deque_push_*() and pcr_deque_pop_*() test cases
+ */
+
+
+static bool
+push_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_deque_push_back() and pcr_deque_pop_front() behave as a FIFO"
+            " queue across wrap arounds";
+
+    pcr_exception_try (x) {
+        pcr_deque *dq = pcr_deque_new(sizeof (int64_t), x);
+        int64_t next = 0, elem;
+
+        for (int64_t i = 0; i < SAMPLE_LEN; i++) {
+            pcr_deque_push_back(&dq, &i, x);
+
+            if (i % 3 == 2) {
+                pcr_deque_pop_front(&dq, &elem, x);
+                if (elem != next++)
+                    return false;
+            }
+        }
+
+        return pcr_deque_len(dq, x) == (size_t) (SAMPLE_LEN - next)
+               && sample_match(dq, next, 1, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+push_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_deque_push_front() and pcr_deque_pop_back() behave as a FIFO"
+            " queue in reverse";
+
+    pcr_exception_try (x) {
+        pcr_deque *dq = pcr_deque_new(sizeof (int64_t), x);
+
+        for (int64_t i = 0; i < SAMPLE_LEN; i++)
+            pcr_deque_push_front(&dq, &i, x);
+
+        if (!sample_match(dq, SAMPLE_LEN - 1, -1, x))
+            return false;
+
+        int64_t elem;
+        for (register int64_t i = 0; i < SAMPLE_LEN; i++) {
+            pcr_deque_pop_back(&dq, &elem, x);
+            if (elem != i)
+                return false;
+        }
+
+        return !pcr_deque_len(dq, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+push_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_deque_push_back() does not modify a shared copy";
+
+    pcr_exception_try (x) {
+        pcr_deque *dq = pcr_deque_new(sizeof (int64_t), x);
+
+        for (int64_t i = 0; i < 10; i++)
+            pcr_deque_push_back(&dq, &i, x);
+
+        pcr_deque *cp = pcr_deque_copy(dq, x);
+        int64_t elem = 10;
+        pcr_deque_push_back(&cp, &elem, x);
+        pcr_deque_pop_front(&cp, NULL, x);
+
+        return pcr_deque_refcount(dq, x) == 1 && pcr_deque_len(dq, x) == 10
+               && sample_match(dq, 0, 1, x) && sample_match(cp, 1, 1, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+pop_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_deque_pop_front() throws PCR_EXCEPTION_STATE if the deque is"
+            " empty";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        pcr_deque *dq = pcr_deque_new(sizeof (int64_t), x);
+        pcr_deque_pop_front(&dq, NULL, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_deque_drain() test cases
+ */
+
+
+static bool
+drain_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_deque_drain() moves elements from the front of a wrapped deque"
+            " into a vector in order";
+
+    pcr_exception_try (x) {
+        pcr_deque *dq = pcr_deque_new(sizeof (int64_t), x);
+        pcr_vector *vec = pcr_vector_new(sizeof (int64_t), x);
+
+        for (int64_t i = 0; i < 6; i++)
+            pcr_deque_push_back(&dq, &i, x);
+        for (register int64_t i = 0; i < 5; i++)
+            pcr_deque_pop_front(&dq, NULL, x);
+        for (int64_t i = 6; i < 14; i++)
+            pcr_deque_push_back(&dq, &i, x);
+
+        size_t n = pcr_deque_drain(&dq, &vec, 6, x);
+        size_t m = pcr_deque_drain_all(&dq, &vec, x);
+
+        if (n != 6 || m != 3 || pcr_deque_len(dq, x))
+            return false;
+
+        for (register size_t i = 1; i <= 9; i++) {
+            if (*((int64_t *) pcr_vector_elem(vec, i, x)) != (int64_t) i + 4)
+                return false;
+        }
+
+        return pcr_vector_len(vec, x) == 9;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+drain_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_deque_drain() throws PCR_EXCEPTION_STATE if the element sizes"
+            " differ";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        pcr_deque *dq = pcr_deque_new(sizeof (int64_t), x);
+        pcr_vector *vec = pcr_vector_new(sizeof (int32_t), x);
+        (void) pcr_deque_drain(&dq, &vec, 0, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+drain_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_deque_drain() moves nothing if passed a length of 0, and"
+            " leaves a shared deque unforked";
+
+    pcr_exception_try (x) {
+        pcr_deque *dq = pcr_deque_new(sizeof (int64_t), x);
+        pcr_vector *vec = pcr_vector_new(sizeof (int64_t), x);
+
+        for (int64_t i = 0; i < 4; i++)
+            pcr_deque_push_back(&dq, &i, x);
+
+        pcr_deque *cp = pcr_deque_copy(dq, x);
+        size_t n = pcr_deque_drain(&dq, &vec, 0, x);
+
+        return !n && dq == cp && pcr_deque_refcount(dq, x) == 2
+               && pcr_deque_len(dq, x) == 4 && !pcr_vector_len(vec, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_deque_testsuite() interface
+ */
+
+
+static pcr_unittest *unit_tests[] = {
+    &new_test_1,  &new_test_2, &push_test_1,  &push_test_2,
+    &push_test_3, &pop_test_1, &drain_test_1, &drain_test_2,
+    &drain_test_3
+};
+
+
+extern pcr_testsuite *
+pcr_deque_testsuite(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        const pcr_string *name = "PCR Deque (pcr_deque)";
+        const size_t len = sizeof unit_tests / sizeof *unit_tests;
+
+        return pcr_testsuite_new_2(name, unit_tests, len, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
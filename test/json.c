@@ -0,0 +1,276 @@
+#include "./suites.h"
+
+
+static bool
+sample_text_match(const char *text, const char *json, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_json_writer *jw = pcr_json_writer_new(x);
+        pcr_json_writer_text(jw, text, strlen(text), x);
+
+        return !strcmp(pcr_json_writer_string(jw, x), json);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_json_writer_text() test cases
+ */
+
+
+static bool
+text_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_json_writer_text() quotes text and passes UTF-8 through as-is";
+
+    pcr_exception_try (x) {
+        return sample_text_match("", "\"\"", x)
+               && sample_text_match("Hello, world!", "\"Hello, world!\"", x)
+               && sample_text_match("Привет, мир!", "\"Привет, мир!\"", x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+text_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_json_writer_text() escapes quotes, backslashes and control"
+            " characters";
+
+    pcr_exception_try (x) {
+        return sample_text_match("say \"hi\"", "\"say \\\"hi\\\"\"", x)
+               && sample_text_match("C:\\tmp", "\"C:\\\\tmp\"", x)
+               && sample_text_match("a\tb\nc\r\b\f", "\"a\\tb\\nc\\r\\b\\f\"",
+                                    x)
+               && sample_text_match("\x01\x1f", "\"\\u0001\\u001f\"", x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+text_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_json_writer_text() escapes characters anywhere in long text";
+
+    pcr_exception_try (x) {
+        char text[101];
+        memset(text, 'a', 100);
+        text[100] = '\0';
+        text[0] = '"';
+        text[17] = '\n';
+        text[99] = '\\';
+
+        pcr_json_writer *jw = pcr_json_writer_new(x);
+        pcr_json_writer_text(jw, text, 100, x);
+        pcr_string *json = pcr_json_writer_string(jw, x);
+
+        return pcr_json_writer_len(jw, x) == 105
+               && !strncmp(json, "\"\\\"a", 4)
+               && !strncmp(json + 19, "\\na", 3)
+               && !strcmp(json + 102, "\\\\\"");
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_json_writer_int(), pcr_json_writer_float() and pcr_json_writer_null()
+ * test cases
+ */
+
+
+static bool
+number_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_json_writer_int() and pcr_json_writer_float() write native"
+            " JSON numbers";
+
+    pcr_exception_try (x) {
+        pcr_json_writer *jw = pcr_json_writer_new(x);
+
+        pcr_json_writer_int(jw, INT64_MIN, x);
+        pcr_json_writer_raw(jw, ",", 1, x);
+        pcr_json_writer_float(jw, 0.1, x);
+        pcr_json_writer_raw(jw, ",", 1, x);
+        pcr_json_writer_float(jw, -2.5e-300, x);
+        pcr_json_writer_raw(jw, ",", 1, x);
+        pcr_json_writer_null(jw, x);
+
+        return !strcmp(pcr_json_writer_string(jw, x),
+                       "-9223372036854775808,0.1,-2.5e-300,null");
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+number_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_json_writer_float() writes infinities and NaNs as null";
+
+    pcr_exception_try (x) {
+        pcr_json_writer *jw = pcr_json_writer_new(x);
+
+        pcr_json_writer_float(jw, 1.0 / 0.0, x);
+        pcr_json_writer_float(jw, 0.0 / 0.0, x);
+
+        return !strcmp(pcr_json_writer_string(jw, x), "nullnull");
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_json_writer_new_2() test cases
+ */
+
+
+static bool
+file_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_json_writer_new_2() streams output larger than its buffer to"
+            " a file";
+
+    pcr_exception_try (x) {
+        FILE *file = tmpfile();
+        pcr_assert_file(file, x);
+
+        pcr_json_writer *jw = pcr_json_writer_new_2(file, x);
+        const size_t len = PCR_JSON_WRITER_BUFFER / 4;
+
+        for (register size_t i = 0; i < len; i++)
+            pcr_json_writer_text(jw, "a\"", 2, x);
+        pcr_json_writer_flush(jw, x);
+
+        bool ok = pcr_json_writer_len(jw, x) == len * 5
+                  && ftell(file) == (long) (len * 5);
+
+        char head[6] = {0};
+        rewind(file);
+        ok = ok && fread(head, 1, 5, file) == 5 && !strcmp(head, "\"a\\\"\"");
+
+        fclose(file);
+        return ok;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+file_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_json_writer_string() throws PCR_EXCEPTION_STATE for a file"
+            " writer";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_json_writer_string(pcr_json_writer_new_2(stderr, x), x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_attribute_json_write() test cases
+ */
+
+
+static bool
+attribute_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_json_write() writes each attribute type as its"
+            " native JSON type";
+
+    pcr_exception_try (x) {
+        const unsigned char data[] = {0xca, 0xfe};
+        const pcr_attribute *arr[] = {
+            pcr_attribute_new_null("n", x),
+            pcr_attribute_new_int("i", -42, x),
+            pcr_attribute_new_float("f", 123.456789, x),
+            pcr_attribute_new_text("t", "a \"b\"", x),
+            pcr_attribute_new_blob("b", data, sizeof data, x)
+        };
+
+        pcr_json_writer *jw = pcr_json_writer_new(x);
+        for (register size_t i = 0; i < sizeof arr / sizeof *arr; i++) {
+            pcr_json_writer_raw(jw, i ? "," : "{", 1, x);
+            pcr_attribute_json_write(arr[i], jw, x);
+        }
+        pcr_json_writer_raw(jw, "}", 1, x);
+
+        return !strcmp(pcr_json_writer_string(jw, x),
+                       "{\"n\":null,\"i\":-42,\"f\":123.456789,"
+                       "\"t\":\"a \\\"b\\\"\",\"b\":\"cafe\"}");
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+attribute_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_attribute_json_write() escapes the key";
+
+    pcr_exception_try (x) {
+        pcr_json_writer *jw = pcr_json_writer_new(x);
+        pcr_attribute_json_write(pcr_attribute_new_int("a\"b", 1, x), jw, x);
+
+        return !strcmp(pcr_json_writer_string(jw, x), "\"a\\\"b\":1");
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_json_testsuite() interface
+ */
+
+
+static pcr_unittest *unit_tests[] = {
+    &text_test_1,      &text_test_2,   &text_test_3, &number_test_1,
+    &number_test_2,    &file_test_1,   &file_test_2, &attribute_test_1,
+    &attribute_test_2
+};
+
+
+extern pcr_testsuite *
+pcr_json_testsuite(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        const pcr_string *name = "PCR JSON Writer (pcr_json_writer)";
+        const size_t len = sizeof unit_tests / sizeof *unit_tests;
+
+        return pcr_testsuite_new_2(name, unit_tests, len, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
@@ -0,0 +1,339 @@
+#include "./suites.h"
+
+
+/* Define the number of keys in the large sample maps; this is chosen so that
+ * the map is rehashed several times while being filled. */
+static const int64_t SAMPLE_LEN = 10000;
+
+
+static const pcr_string *SAMPLE_KEYS[] = {
+    "id", "fname", "lname", "attempts", "time",
+    "a column name longer than sixteen bytes", "Вороно́й", ""
+};
+
+static const size_t SAMPLE_KEYS_LEN = sizeof SAMPLE_KEYS / sizeof *SAMPLE_KEYS;
+
+
+static pcr_map *
+sample_i64(int64_t len, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_map *map = pcr_map_new(sizeof (int64_t), x);
+
+        int64_t val;
+        for (register int64_t i = 0; i < len; i++) {
+            val = i * i;
+            pcr_map_set_i64(&map, i * 7919, &val, x);
+        }
+
+        return map;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+static void
+sample_sum(const void *key, size_t keysz, const void *val, void *opt,
+           pcr_exception ex)
+{
+    *((int64_t *) opt) += *((const int64_t *) val);
+}
+
+
+/******************************************************************************
+ * pcr_map_new() test cases
+ */
+
+
+static bool
+new_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_map_new() creates an empty map with a reference count of 1";
+
+    pcr_exception_try (x) {
+        pcr_map *map = pcr_map_new(sizeof (int), x);
+        return !pcr_map_len(map, x) && pcr_map_refcount(map, x) == 1;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+new_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_map_new() throws PCR_EXCEPTION_RANGE if passed zero @valsz";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_map_new(0, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_map_set() and pcr_map_get() test cases
+ */
+
+
+static bool
+set_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_map_set_str() and pcr_map_get_str() store and retrieve string"
+            " keys of all lengths";
+
+    pcr_exception_try (x) {
+        pcr_map *map = pcr_map_new(sizeof (size_t), x);
+
+        for (size_t i = 0; i < SAMPLE_KEYS_LEN; i++)
+            pcr_map_set_str(&map, SAMPLE_KEYS[i], &i, x);
+
+        size_t val;
+        for (register size_t i = 0; i < SAMPLE_KEYS_LEN; i++) {
+            if (!pcr_map_get_str(map, SAMPLE_KEYS[i], &val, x) || val != i)
+                return false;
+        }
+
+        return pcr_map_len(map, x) == SAMPLE_KEYS_LEN
+               && !pcr_map_get_str(map, "fnam", NULL, x)
+               && !pcr_map_get_str(map, "fnamee", NULL, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+set_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_map_set() overwrites the value of an existing key";
+
+    pcr_exception_try (x) {
+        pcr_map *map = pcr_map_new(sizeof (double), x);
+
+        double val = 1.5;
+        pcr_map_set(&map, "key", 3, &val, x);
+        val = -2.5;
+        pcr_map_set(&map, "key", 3, &val, x);
+
+        val = 0.0;
+        return pcr_map_get(map, "key", 3, &val, x) && val == -2.5
+               && pcr_map_len(map, x) == 1;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+set_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_map_set_i64() grows the map to hold a large number of keys";
+
+    pcr_exception_try (x) {
+        pcr_map *map = sample_i64(SAMPLE_LEN, x);
+
+        int64_t val;
+        for (register int64_t i = 0; i < SAMPLE_LEN; i++) {
+            if (!pcr_map_get_i64(map, i * 7919, &val, x) || val != i * i)
+                return false;
+        }
+
+        return pcr_map_len(map, x) == (size_t) SAMPLE_LEN
+               && !pcr_map_get_i64(map, 1, NULL, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+set_test_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_map_set() throws PCR_EXCEPTION_HANDLE if passed a null pointer"
+            " for @val";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        pcr_map *map = pcr_map_new(sizeof (int), x);
+        pcr_map_set(&map, "key", 3, NULL, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_HANDLE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_map_remove() test cases
+ */
+
+
+static bool
+remove_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_map_remove_i64() removes only the given keys";
+
+    pcr_exception_try (x) {
+        pcr_map *map = sample_i64(SAMPLE_LEN, x);
+
+        for (register int64_t i = 0; i < SAMPLE_LEN; i += 2) {
+            if (!pcr_map_remove_i64(&map, i * 7919, x))
+                return false;
+        }
+
+        for (register int64_t i = 0; i < SAMPLE_LEN; i++) {
+            if (pcr_map_get_i64(map, i * 7919, NULL, x) != (i % 2))
+                return false;
+        }
+
+        return pcr_map_len(map, x) == (size_t) SAMPLE_LEN / 2
+               && !pcr_map_remove_i64(&map, 0, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+remove_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_map_remove() and pcr_map_set() can churn keys without growing"
+            " the map indefinitely";
+
+    pcr_exception_try (x) {
+        pcr_map *map = pcr_map_new(sizeof (int64_t), x);
+
+        for (int64_t i = 0; i < SAMPLE_LEN * 10; i++) {
+            pcr_map_set_i64(&map, i, &i, x);
+            if (i >= 64 && !pcr_map_remove_i64(&map, i - 64, x))
+                return false;
+        }
+
+        int64_t val;
+        return pcr_map_len(map, x) == 64
+               && pcr_map_get_i64(map, SAMPLE_LEN * 10 - 1, &val, x)
+               && val == SAMPLE_LEN * 10 - 1;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_map_reserve(), pcr_map_iterate() and pcr_map_copy() test cases
+ */
+
+
+static bool
+reserve_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_map_reserve() preserves the existing keys";
+
+    pcr_exception_try (x) {
+        pcr_map *map = sample_i64(100, x);
+        pcr_map_reserve(&map, SAMPLE_LEN, x);
+
+        int64_t val;
+        return pcr_map_len(map, x) == 100
+               && pcr_map_get_i64(map, 99 * 7919, &val, x) && val == 99 * 99;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+iterate_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_map_iterate() visits every key exactly once";
+
+    pcr_exception_try (x) {
+        pcr_map *map = sample_i64(SAMPLE_LEN, x);
+
+        int64_t sum = 0, expect = 0;
+        pcr_map_iterate(map, &sample_sum, &sum, x);
+
+        for (register int64_t i = 0; i < SAMPLE_LEN; i++)
+            expect += i * i;
+
+        return sum == expect;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+copy_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_map_set() and pcr_map_remove() do not modify a shared copy";
+
+    pcr_exception_try (x) {
+        pcr_map *map = sample_i64(100, x);
+        pcr_map *cp1 = pcr_map_copy(map, x);
+        pcr_map *cp2 = pcr_map_copy(map, x);
+
+        int64_t val = -1;
+        pcr_map_set_i64(&cp1, 1, &val, x);
+        (void) pcr_map_remove_i64(&cp2, 0, x);
+
+        return pcr_map_refcount(map, x) == 1 && pcr_map_len(map, x) == 100
+               && !pcr_map_get_i64(map, 1, NULL, x)
+               && pcr_map_get_i64(map, 0, NULL, x)
+               && pcr_map_len(cp1, x) == 101 && pcr_map_len(cp2, x) == 99;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_map_testsuite() interface
+ */
+
+
+static pcr_unittest *unit_tests[] = {
+    &new_test_1,     &new_test_2,     &set_test_1,    &set_test_2,
+    &set_test_3,     &set_test_4,     &remove_test_1, &remove_test_2,
+    &reserve_test_1, &iterate_test_1, &copy_test_1
+};
+
+
+extern pcr_testsuite *
+pcr_map_testsuite(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        const pcr_string *name = "PCR Map (pcr_map)";
+        const size_t len = sizeof unit_tests / sizeof *unit_tests;
+
+        return pcr_testsuite_new_2(name, unit_tests, len, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
@@ -1,3 +1,4 @@
+#include <math.h>
 #include "./suites.h"
 
 
@@ -356,6 +357,38 @@ copy_test_3(pcr_string **desc, pcr_exception ex)
 }
 
 
+static void
+sample_copy_task(size_t id, size_t len, void *opt, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        const pcr_resultset *rs = opt;
+        for (register size_t i = 0; i < 1000; i++)
+            (void) pcr_resultset_copy(rs, x);
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+static bool
+copy_test_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_copy() updates the reference count atomically across"
+            " worker threads";
+
+    pcr_exception_try (x) {
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        pcr_worker_run(4, &sample_copy_task, rs, x);
+
+        return pcr_resultset_refcount(rs, x) == 4001;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
 /******************************************************************************
  * pcr_resultset_push() test cases
  */
@@ -443,6 +476,1126 @@ push_test_4(pcr_string **desc, pcr_exception ex)
 }
 
 
+static bool
+push_test_5(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_push() does not modify the shared original";
+
+    pcr_exception_try (x) {
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        pcr_resultset *cp = pcr_resultset_copy(rs, x);
+
+        sample_row_push(&cp, x);
+        return cp != rs && pcr_resultset_refcount(rs, x) == 1
+               && !pcr_resultset_rows(rs, x) && pcr_resultset_rows(cp, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+push_test_6(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_push() stores a blob attribute";
+
+    pcr_exception_try (x) {
+        const pcr_string *keys[] = {"payload"};
+        const PCR_ATTRIBUTE types[] = {PCR_ATTRIBUTE_BLOB};
+        const unsigned char data[] = {0x00, 0xff, 0x10, 0x27};
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, keys, types, 1, x);
+        pcr_resultset_push(&rs, pcr_attribute_new_blob("payload", data,
+                                                       sizeof data, x), x);
+
+        pcr_blob blob = pcr_attribute_blob(pcr_resultset_attrib(rs, 1, 1, x),
+                                           x);
+        return blob.len == sizeof data && !memcmp(blob.data, data, blob.len);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * Column storage test cases
+ */
+
+
+static void
+sample_rows_push(pcr_resultset **ctx, size_t len, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        char fname[16];
+
+        for (register size_t i = 1; i <= len; i++) {
+            snprintf(fname, sizeof fname, "n%zu", i);
+
+            const pcr_attribute *arr[] = {
+                pcr_attribute_new_int("id", (int64_t) i, x),
+                i % 3 ? pcr_attribute_new_text("fname", fname, x)
+                      : pcr_attribute_new_null("fname", x),
+                pcr_attribute_new_text("lname", i % 2 ? "" : "Вороно́й", x),
+                i % 5 ? pcr_attribute_new_int("attempts", -(int64_t) i, x)
+                      : pcr_attribute_new_null("attempts", x),
+                pcr_attribute_new_float("time", (double) i / 4, x)
+            };
+
+            pcr_resultset_push_2(ctx, pcr_attribute_vector_new_2(arr,
+                                                                 SAMPLE_LEN,
+                                                                 x), x);
+        }
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+static bool
+column_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_attrib() reads back every cell, including NULLs,"
+            " across many rows";
+
+    pcr_exception_try (x) {
+        const size_t len = 200;
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, len, x);
+
+        if (pcr_resultset_rows(rs, x) != len)
+            return false;
+
+        char fname[16];
+        for (register size_t i = 1; i <= len; i++) {
+            snprintf(fname, sizeof fname, "n%zu", i);
+
+            pcr_attribute *f = pcr_resultset_attrib(rs, i, 2, x);
+            pcr_attribute *l = pcr_resultset_attrib(rs, i, 3, x);
+            pcr_attribute *a = pcr_resultset_attrib(rs, i, 4, x);
+            pcr_attribute *t = pcr_resultset_attrib(rs, i, 5, x);
+
+            if (pcr_attribute_int(pcr_resultset_attrib(rs, i, 1, x), x)
+                    != (int64_t) i
+                || pcr_resultset_null(rs, i, 2, x) != !(i % 3)
+                || (i % 3 && strcmp(pcr_attribute_text_ref(f, x), fname))
+                || strcmp(pcr_attribute_text_ref(l, x),
+                          i % 2 ? "" : "Вороно́й")
+                || pcr_attribute_type(a, x) != (i % 5 ? PCR_ATTRIBUTE_INT
+                                                      : PCR_ATTRIBUTE_NULL)
+                || pcr_attribute_float(t, x) != (double) i / 4)
+                return false;
+        }
+
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+column_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_attrib_set() replaces text of a different length"
+            " without disturbing the other cells or shared copies";
+
+    pcr_exception_try (x) {
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 10, x);
+
+        pcr_resultset *cp = pcr_resultset_copy(rs, x);
+        pcr_resultset_attrib_set(&cp, pcr_attribute_new_text("fname",
+                                                             "Alexander", x),
+                                 4, 2, x);
+        pcr_resultset_attrib_set(&cp, pcr_attribute_new_null("fname", x), 5, 2,
+                                 x);
+        pcr_resultset_attrib_set(&cp, pcr_attribute_new_int("attempts", 7, x),
+                                 5, 4, x);
+
+        pcr_attribute *attr = pcr_resultset_attrib(cp, 4, 2, x);
+        pcr_attribute *orig = pcr_resultset_attrib(rs, 4, 2, x);
+
+        return !strcmp(pcr_attribute_text_ref(attr, x), "Alexander")
+               && !strcmp(pcr_attribute_text_ref(orig, x), "n4")
+               && pcr_resultset_null(cp, 5, 2, x)
+               && !pcr_resultset_null(rs, 5, 2, x)
+               && !strcmp(pcr_attribute_text_ref(pcr_resultset_attrib(cp, 7, 2,
+                                                                      x), x),
+                          "n7")
+               && pcr_attribute_int(pcr_resultset_attrib(cp, 5, 4, x), x) == 7
+               && pcr_resultset_null(rs, 5, 4, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+column_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_col_i64() and pcr_resultset_col_f64() return the"
+            " cells of a column as a vector";
+
+    pcr_exception_try (x) {
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 100, x);
+
+        pcr_vector *id = pcr_resultset_col_i64(rs, 1, x);
+        pcr_vector *time = pcr_resultset_col_f64(rs, 5, x);
+
+        return pcr_vector_len(id, x) == 100
+               && pcr_vector_sum_i64(id, x) == 5050
+               && pcr_vector_sum_f64(time, x) == 5050.0 / 4;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+column_test_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_push() gives an untyped column the type of its first"
+            " value other than NULL";
+
+    pcr_exception_try (x) {
+        const pcr_string *keys[] = {"a", "b"};
+        const PCR_ATTRIBUTE types[] = {PCR_ATTRIBUTE_NULL, PCR_ATTRIBUTE_NULL};
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, keys, types, 2, x);
+        pcr_resultset_push(&rs, pcr_attribute_new_null("a", x), x);
+        pcr_resultset_push(&rs, pcr_attribute_new_null("b", x), x);
+        pcr_resultset_push(&rs, pcr_attribute_new_null("a", x), x);
+        pcr_resultset_push(&rs, pcr_attribute_new_text("b", "xyz", x), x);
+        pcr_resultset_push(&rs, pcr_attribute_new_int("a", 3, x), x);
+
+        PCR_ATTRIBUTE_VECTOR *tv = pcr_resultset_types(rs, x);
+
+        return pcr_resultset_rows(rs, x) == 2
+               && PCR_ATTRIBUTE_VECTOR_ELEM(tv, 1, x) == PCR_ATTRIBUTE_INT
+               && PCR_ATTRIBUTE_VECTOR_ELEM(tv, 2, x) == PCR_ATTRIBUTE_TEXT
+               && pcr_resultset_null(rs, 1, 2, x)
+               && !strcmp(pcr_attribute_text_ref(pcr_resultset_attrib(rs, 2, 2,
+                                                                      x), x),
+                          "xyz")
+               && pcr_attribute_int(pcr_resultset_attrib(rs, 3, 1, x), x) == 3;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+column_test_5(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_attrib() throws PCR_EXCEPTION_RANGE for a cell that"
+            " has not been pushed";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 2, x);
+        (void) pcr_resultset_attrib(rs, 3, 1, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_resultset_col_index() and pcr_resultset_attrib_by_key() test cases
+ */
+
+
+static bool
+index_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_col_index() finds the column of each key, and 0 for"
+            " an unknown key";
+
+    pcr_exception_try (x) {
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+
+        for (register size_t i = 1; i <= SAMPLE_LEN; i++) {
+            if (pcr_resultset_col_index(rs, SAMPLE_KEYS[i - 1], x) != i)
+                return false;
+        }
+
+        return !pcr_resultset_col_index(rs, "nope", x)
+               && !pcr_resultset_col_index(rs, "ID", x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+index_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_col_index() finds the first of repeated keys, and is"
+            " kept by forked copies";
+
+    pcr_exception_try (x) {
+        const pcr_string *keys[] = {"a", "b", "a"};
+        const PCR_ATTRIBUTE types[] = {PCR_ATTRIBUTE_INT, PCR_ATTRIBUTE_INT,
+                                       PCR_ATTRIBUTE_INT};
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, keys, types, 3, x);
+        pcr_resultset *cp = pcr_resultset_copy(rs, x);
+        pcr_resultset_push(&cp, pcr_attribute_new_int("a", 1, x), x);
+
+        return cp != rs && pcr_resultset_col_index(rs, "a", x) == 1
+               && pcr_resultset_col_index(cp, "a", x) == 1
+               && pcr_resultset_col_index(cp, "b", x) == 2;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+index_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_attrib_by_key() reads a cell by its key";
+
+    pcr_exception_try (x) {
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 10, x);
+
+        pcr_attribute *attr = pcr_resultset_attrib_by_key(rs, 7, "fname", x);
+        return !strcmp(pcr_attribute_text_ref(attr, x), "n7")
+               && pcr_attribute_float(pcr_resultset_attrib_by_key(rs, 8,
+                                                                  "time", x),
+                                      x) == 2.0;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+index_test_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_attrib_by_key() throws PCR_EXCEPTION_RANGE for an"
+            " unknown key";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 1, x);
+        (void) pcr_resultset_attrib_by_key(rs, 1, "nope", x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_resultset_sort() test cases
+ */
+
+
+static bool
+sort_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_sort() sorts rows in descending order with NULLs"
+            " last, keeping whole rows together";
+
+    pcr_exception_try (x) {
+        const size_t len = 200;
+        const size_t cols[] = {4};
+        const PCR_RESULTSET_ORDER dirs[] = {PCR_RESULTSET_DESC};
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, len, x);
+        pcr_resultset_sort(&rs, cols, dirs, 1, x);
+
+        if (pcr_resultset_rows(rs, x) != len)
+            return false;
+
+        /* attempts is -id, or NULL if id is a multiple of 5 */
+        int64_t prev = 0;
+        for (register size_t i = 1; i <= len; i++) {
+            int64_t id = pcr_attribute_int(pcr_resultset_attrib(rs, i, 1, x),
+                                           x);
+            bool null = pcr_resultset_null(rs, i, 4, x);
+
+            if (null != !(id % 5) || (i <= len * 4 / 5) == null
+                || (!null && pcr_attribute_int(pcr_resultset_attrib(rs, i, 4,
+                                                                    x), x)
+                                 != -id)
+                || pcr_attribute_float(pcr_resultset_attrib(rs, i, 5, x), x)
+                       != (double) id / 4
+                || id <= prev)
+                return false;
+
+            prev = i == len * 4 / 5 ? 0 : id;
+        }
+
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+sort_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_sort() sorts by several columns, the first taking"
+            " precedence";
+
+    pcr_exception_try (x) {
+        const size_t len = 50;
+        const size_t cols[] = {3, 1};
+        const PCR_RESULTSET_ORDER dirs[] = {PCR_RESULTSET_ASC,
+                                            PCR_RESULTSET_DESC};
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, len, x);
+        pcr_resultset_sort(&rs, cols, dirs, 2, x);
+
+        /* lname is "" for odd ids, so these come first, by descending id */
+        for (register size_t i = 1; i <= len; i++) {
+            int64_t id = pcr_attribute_int(pcr_resultset_attrib(rs, i, 1, x),
+                                           x);
+            int64_t want = i <= len / 2 ? (int64_t) (len - 2 * i + 1)
+                                        : (int64_t) (2 * len - 2 * i + 2);
+            if (id != want)
+                return false;
+        }
+
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+sort_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_sort() orders floats as pcr_attribute_cmp() does";
+
+    pcr_exception_try (x) {
+        const pcr_string *keys[] = {"f"};
+        const PCR_ATTRIBUTE types[] = {PCR_ATTRIBUTE_FLOAT};
+        const double vals[] = {3.5, -1.0, 0.0, -0.0, 0.0 / 0.0, -1.0 / 0.0,
+                               2.0, 1e300, -2.5e-300};
+        const size_t len = sizeof vals / sizeof *vals;
+        const size_t cols[] = {1};
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, keys, types, 1, x);
+        pcr_resultset_push(&rs, pcr_attribute_new_null("f", x), x);
+        for (register size_t i = 0; i < len; i++)
+            pcr_resultset_push(&rs, pcr_attribute_new_float("f", vals[i], x),
+                               x);
+
+        pcr_resultset_sort(&rs, cols, NULL, 1, x);
+        if (!pcr_resultset_null(rs, 1, 1, x)
+            || !isnan(pcr_attribute_float(pcr_resultset_attrib(rs, 2, 1, x),
+                                          x)))
+            return false;
+
+        for (register size_t i = 3; i <= len; i++) {
+            if (pcr_attribute_cmp(pcr_resultset_attrib(rs, i, 1, x),
+                                  pcr_resultset_attrib(rs, i + 1, 1, x), x)
+                > 0)
+                return false;
+        }
+
+        /* -0.0 and 0.0 compare equal, so they keep their original order */
+        return !signbit(pcr_attribute_float(pcr_resultset_attrib(rs, 6, 1, x),
+                                            x))
+               && signbit(pcr_attribute_float(pcr_resultset_attrib(rs, 7, 1, x),
+                                              x));
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+sort_test_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_sort() sorts a large result set stably in parallel";
+
+    pcr_exception_try (x) {
+        const size_t len = PCR_RESULTSET_SORT_THRESHOLD * 2 + 17;
+        const pcr_string *keys[] = {"key", "seq"};
+        const PCR_ATTRIBUTE types[] = {PCR_ATTRIBUTE_INT, PCR_ATTRIBUTE_INT};
+        const size_t cols[] = {1};
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, keys, types, 2, x);
+        uint64_t seed = 42;
+
+        for (register size_t i = 0; i < len; i++) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            int64_t key = (int64_t) (seed >> 33) % 2000 - 1000;
+
+            pcr_resultset_push(&rs, pcr_attribute_new_int("key", key, x), x);
+            pcr_resultset_push(&rs, pcr_attribute_new_int("seq", (int64_t) i,
+                                                          x), x);
+        }
+
+        pcr_worker_limit(4);
+        pcr_resultset_sort(&rs, cols, NULL, 1, x);
+        pcr_worker_limit(0);
+
+        pcr_vector *kv = pcr_resultset_col_i64(rs, 1, x);
+        pcr_vector *sv = pcr_resultset_col_i64(rs, 2, x);
+        const int64_t *k = kv->payload, *q = sv->payload;
+
+        for (register size_t i = 1; i < len; i++) {
+            if (k[i - 1] > k[i] || (k[i - 1] == k[i] && q[i - 1] >= q[i]))
+                return false;
+        }
+
+        return pcr_resultset_rows(rs, x) == len;
+    }
+
+    pcr_worker_limit(0);
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+sort_test_5(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_sort() does not modify the shared original";
+
+    pcr_exception_try (x) {
+        const size_t cols[] = {1};
+        const PCR_RESULTSET_ORDER dirs[] = {PCR_RESULTSET_DESC};
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 10, x);
+
+        pcr_resultset *cp = pcr_resultset_copy(rs, x);
+        pcr_resultset_sort(&cp, cols, dirs, 1, x);
+
+        return cp != rs && pcr_resultset_refcount(rs, x) == 1
+               && pcr_attribute_int(pcr_resultset_attrib(rs, 1, 1, x), x) == 1
+               && pcr_attribute_int(pcr_resultset_attrib(cp, 1, 1, x), x) == 10
+               && !strcmp(pcr_attribute_text_ref(pcr_resultset_attrib(cp, 1, 2,
+                                                                      x), x),
+                          "n10");
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+sort_test_6(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_sort() throws PCR_EXCEPTION_RANGE if passed an"
+            " invalid column";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        const size_t cols[] = {SAMPLE_LEN + 1};
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        pcr_resultset_sort(&rs, cols, NULL, 1, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_resultset_json_write() test cases
+ */
+
+
+static pcr_resultset *
+sample_json_rs(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        const pcr_string *keys[] = {"id", "na\"me", "data"};
+        const PCR_ATTRIBUTE types[] = {PCR_ATTRIBUTE_INT, PCR_ATTRIBUTE_TEXT,
+                                       PCR_ATTRIBUTE_BLOB};
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, keys, types, 3, x);
+        pcr_resultset_push(&rs, pcr_attribute_new_int("id", 1, x), x);
+        pcr_resultset_push(&rs, pcr_attribute_new_text("na\"me", "a\nb", x),
+                           x);
+        pcr_resultset_push(&rs, pcr_attribute_new_blob("data", "\x01\xab", 2,
+                                                       x), x);
+        pcr_resultset_push(&rs, pcr_attribute_new_int("id", -2, x), x);
+        pcr_resultset_push(&rs, pcr_attribute_new_null("na\"me", x), x);
+        pcr_resultset_push(&rs, pcr_attribute_new_null("data", x), x);
+
+        /* a partly pushed row is not written */
+        pcr_resultset_push(&rs, pcr_attribute_new_int("id", 3, x), x);
+
+        return rs;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+static bool
+sample_json_match(const pcr_resultset *rs, PCR_RESULTSET_JSON opts,
+                  const char *json, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        FILE *file = tmpfile();
+        pcr_assert_file(file, x);
+
+        size_t len = pcr_resultset_json_write(rs, file, opts, x);
+        char *buf = pcr_mempool_alloc(len + 1, x);
+
+        rewind(file);
+        bool ok = len == strlen(json) && fread(buf, 1, len, file) == len;
+        fclose(file);
+
+        return ok && !strcmp(buf, json);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+json_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_json_write() streams rows as objects of native JSON"
+            " values";
+
+    pcr_exception_try (x) {
+        return sample_json_match(sample_json_rs(x), PCR_RESULTSET_JSON_DEFAULT,
+                                 "{\"Test Resultset\":["
+                                 "{\"id\":1,\"na\\\"me\":\"a\\nb\","
+                                 "\"data\":\"01ab\"},"
+                                 "{\"id\":-2,\"na\\\"me\":null,\"data\":null}"
+                                 "]}", x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+json_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_json_write() writes rows as arrays, one per line, if"
+            " asked to";
+
+    pcr_exception_try (x) {
+        pcr_resultset *rs = sample_json_rs(x);
+        PCR_RESULTSET_JSON opts = PCR_RESULTSET_JSON_ARRAYS
+                                  | PCR_RESULTSET_JSON_LINES;
+
+        return sample_json_match(rs, opts,
+                                 "[1,\"a\\nb\",\"01ab\"]\n[-2,null,null]\n",
+                                 x)
+               && sample_json_match(pcr_resultset_new_2(SAMPLE_NAME,
+                                                        SAMPLE_KEYS,
+                                                        SAMPLE_TYPES,
+                                                        SAMPLE_LEN, x),
+                                    PCR_RESULTSET_JSON_DEFAULT,
+                                    "{\"Test Resultset\":[]}", x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+json_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_json_write() streams a result set larger than the"
+            " writer buffer";
+
+    pcr_exception_try (x) {
+        const size_t len = 5000;
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, len, x);
+
+        FILE *file = tmpfile();
+        pcr_assert_file(file, x);
+
+        size_t sz = pcr_resultset_json_write(rs, file,
+                                             PCR_RESULTSET_JSON_LINES, x);
+        bool ok = sz > PCR_JSON_WRITER_BUFFER && ftell(file) == (long) sz;
+
+        size_t rows = 0;
+        int c;
+        rewind(file);
+        while ((c = fgetc(file)) != EOF)
+            rows += c == '\n';
+
+        fclose(file);
+        return ok && rows == len;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+json_test_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_json_write() throws PCR_EXCEPTION_HANDLE if passed a"
+            " null pointer for @file";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_resultset_json_write(sample_json_rs(x), NULL,
+                                        PCR_RESULTSET_JSON_DEFAULT, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_HANDLE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_resultset_filter() and pcr_resultset_take() test cases
+ */
+
+
+static bool
+filter_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_filter() selects the matching rows of an integer"
+            " column in ascending order";
+
+    pcr_exception_try (x) {
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 200, x);
+
+        pcr_vector *sel = pcr_resultset_filter(rs, 1, PCR_VECTOR_CMP_GT,
+                                               pcr_attribute_new_int("v", 150,
+                                                                     x),
+                                               NULL, x);
+        const size_t *idx = sel->payload;
+
+        for (register size_t i = 0; i < 50; i++) {
+            if (idx[i] != 151 + i)
+                return false;
+        }
+
+        return pcr_vector_len(sel, x) == 50 && pcr_vector_sorted(sel, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+filter_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_filter() never matches NULL cells";
+
+    pcr_exception_try (x) {
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 200, x);
+
+        pcr_attribute *zero = pcr_attribute_new_int("v", 0, x);
+        pcr_vector *ne = pcr_resultset_filter(rs, 4, PCR_VECTOR_CMP_NE, zero,
+                                              NULL, x);
+        pcr_vector *le = pcr_resultset_filter(rs, 4, PCR_VECTOR_CMP_LE,
+                                              pcr_attribute_new_int("v", -100,
+                                                                    x),
+                                              NULL, x);
+        pcr_vector *none = pcr_resultset_filter(rs, 1, PCR_VECTOR_CMP_NE,
+                                                pcr_attribute_new_null("v", x),
+                                                NULL, x);
+
+        const size_t *idx = ne->payload;
+        for (register size_t i = 0; i < pcr_vector_len(ne, x); i++) {
+            if (!(idx[i] % 5))
+                return false;
+        }
+
+        return pcr_vector_len(ne, x) == 160 && pcr_vector_len(le, x) == 80
+               && !pcr_vector_len(none, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+filter_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_filter() compares mixed numbers and text, and chains"
+            " through a selection vector";
+
+    pcr_exception_try (x) {
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 200, x);
+
+        pcr_vector *sel = pcr_resultset_filter(rs, 5, PCR_VECTOR_CMP_GE,
+                                               pcr_attribute_new_int("v", 25,
+                                                                     x),
+                                               NULL, x);
+        pcr_vector *odd = pcr_resultset_filter(rs, 3, PCR_VECTOR_CMP_EQ,
+                                               pcr_attribute_new_text("v", "",
+                                                                      x),
+                                               sel, x);
+        pcr_vector *one = pcr_resultset_filter(rs, 2, PCR_VECTOR_CMP_EQ,
+                                               pcr_attribute_new_text("v",
+                                                                      "n151",
+                                                                      x),
+                                               odd, x);
+        pcr_vector *gt = pcr_resultset_filter(rs, 1, PCR_VECTOR_CMP_GT,
+                                              pcr_attribute_new_float("v",
+                                                                      199.5, x),
+                                              NULL, x);
+
+        return pcr_vector_len(sel, x) == 101 && pcr_vector_len(odd, x) == 50
+               && pcr_vector_len(one, x) == 1
+               && *(const size_t *) one->payload == 151
+               && pcr_vector_len(gt, x) == 1
+               && *(const size_t *) gt->payload == 200;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+filter_test_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_filter() throws PCR_EXCEPTION_RANGE if passed an"
+            " invalid column";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        (void) pcr_resultset_filter(rs, SAMPLE_LEN + 1, PCR_VECTOR_CMP_EQ,
+                                    pcr_attribute_new_int("v", 0, x), NULL, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+take_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_take() copies the selected rows into a new result"
+            " set";
+
+    pcr_exception_try (x) {
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 200, x);
+
+        pcr_vector *sel = pcr_resultset_filter(rs, 4, PCR_VECTOR_CMP_LT,
+                                               pcr_attribute_new_int("v", -190,
+                                                                     x),
+                                               NULL, x);
+        pcr_resultset *tk = pcr_resultset_take(rs, sel, x);
+
+        for (register size_t i = 1; i <= pcr_resultset_rows(tk, x); i++) {
+            size_t row = ((const size_t *) sel->payload)[i - 1];
+
+            for (register size_t j = 1; j <= SAMPLE_LEN; j++) {
+                if (pcr_attribute_cmp(pcr_resultset_attrib(tk, i, j, x),
+                                      pcr_resultset_attrib(rs, row, j, x), x))
+                    return false;
+            }
+        }
+
+        return pcr_resultset_rows(tk, x) == 8;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_resultset_project() test cases
+ */
+
+
+static bool
+project_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_project() selects and reorders columns without"
+            " changing the original";
+
+    pcr_exception_try (x) {
+        const size_t cols[] = {5, 1};
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 100, x);
+
+        pcr_resultset *prj = pcr_resultset_project(rs, cols, 2, x);
+        pcr_resultset_attrib_set(&prj, pcr_attribute_new_int("id", -1, x), 1,
+                                 2, x);
+
+        return pcr_resultset_cols(prj, x) == 2
+               && pcr_resultset_rows(prj, x) == 100
+               && pcr_resultset_col_index(prj, "time", x) == 1
+               && pcr_resultset_col_index(prj, "fname", x) == 0
+               && pcr_attribute_float(pcr_resultset_attrib(prj, 100, 1, x), x)
+                  == 25.0
+               && pcr_attribute_int(pcr_resultset_attrib(prj, 1, 2, x), x) == -1
+               && pcr_attribute_int(pcr_resultset_attrib(rs, 1, 1, x), x) == 1;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+project_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_project() throws PCR_EXCEPTION_STATE if a row is"
+            " partly pushed";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        const size_t cols[] = {1};
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        pcr_resultset_push(&rs, pcr_attribute_new_int("id", 1, x), x);
+        (void) pcr_resultset_project(rs, cols, 1, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_resultset_aggregate() test cases
+ */
+
+
+static bool
+aggregate_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_aggregate() aggregates whole columns, skipping"
+            " NULLs";
+
+    pcr_exception_try (x) {
+        const size_t cols[] = {2, 1, 4, 4, 5};
+        const PCR_RESULTSET_AGG aggs[] = {
+            PCR_RESULTSET_COUNT, PCR_RESULTSET_SUM, PCR_RESULTSET_MIN,
+            PCR_RESULTSET_MAX, PCR_RESULTSET_AVG
+        };
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 200, x);
+
+        pcr_resultset *agg = pcr_resultset_aggregate(rs, cols, aggs, 5, NULL,
+                                                     x);
+
+        return pcr_resultset_rows(agg, x) == 1
+               && pcr_attribute_int(pcr_resultset_attrib_by_key(agg, 1,
+                                                                "count(fname)",
+                                                                x), x) == 134
+               && pcr_attribute_int(pcr_resultset_attrib(agg, 1, 2, x), x)
+                  == 20100
+               && pcr_attribute_int(pcr_resultset_attrib(agg, 1, 3, x), x)
+                  == -199
+               && pcr_attribute_int(pcr_resultset_attrib(agg, 1, 4, x), x)
+                  == -1
+               && pcr_attribute_float(pcr_resultset_attrib_by_key(agg, 1,
+                                                                  "avg(time)",
+                                                                  x), x)
+                  == 25.125;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+aggregate_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_aggregate() aggregates the rows of a selection"
+            " vector, including text extremes";
+
+    pcr_exception_try (x) {
+        const size_t cols[] = {1, 2, 2, 4, 4};
+        const PCR_RESULTSET_AGG aggs[] = {
+            PCR_RESULTSET_SUM, PCR_RESULTSET_MIN, PCR_RESULTSET_MAX,
+            PCR_RESULTSET_MAX, PCR_RESULTSET_COUNT
+        };
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 2000, x);
+
+        pcr_vector *sel = pcr_resultset_filter(rs, 1, PCR_VECTOR_CMP_GT,
+                                               pcr_attribute_new_int("v", 150,
+                                                                     x),
+                                               NULL, x);
+        sel = pcr_resultset_filter(rs, 1, PCR_VECTOR_CMP_LE,
+                                   pcr_attribute_new_int("v", 200, x), sel, x);
+
+        pcr_resultset *agg = pcr_resultset_aggregate(rs, cols, aggs, 5, sel,
+                                                     x);
+
+        return pcr_attribute_int(pcr_resultset_attrib(agg, 1, 1, x), x) == 8775
+               && !strcmp(pcr_attribute_text_ref(pcr_resultset_attrib(agg, 1,
+                                                                      2, x),
+                                                 x), "n151")
+               && !strcmp(pcr_attribute_text_ref(pcr_resultset_attrib(agg, 1,
+                                                                      3, x),
+                                                 x), "n200")
+               && pcr_attribute_int(pcr_resultset_attrib(agg, 1, 4, x), x)
+                  == -151
+               && pcr_attribute_int(pcr_resultset_attrib(agg, 1, 5, x), x)
+                  == 40;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+aggregate_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_aggregate() returns NULL for aggregates over no"
+            " values";
+
+    pcr_exception_try (x) {
+        const size_t cols[] = {1, 5, 2};
+        const PCR_RESULTSET_AGG aggs[] = {
+            PCR_RESULTSET_SUM, PCR_RESULTSET_AVG, PCR_RESULTSET_COUNT
+        };
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 10, x);
+
+        pcr_vector *sel = pcr_resultset_filter(rs, 1, PCR_VECTOR_CMP_LT,
+                                               pcr_attribute_new_int("v", 0,
+                                                                     x),
+                                               NULL, x);
+        pcr_resultset *agg = pcr_resultset_aggregate(rs, cols, aggs, 3, sel,
+                                                     x);
+
+        return pcr_resultset_null(agg, 1, 1, x)
+               && pcr_resultset_null(agg, 1, 2, x)
+               && !pcr_attribute_int(pcr_resultset_attrib(agg, 1, 3, x), x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+aggregate_test_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_resultset_aggregate() throws PCR_EXCEPTION_STATE if asked to"
+            " sum text";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        const size_t cols[] = {3};
+        const PCR_RESULTSET_AGG aggs[] = {PCR_RESULTSET_SUM};
+
+        pcr_resultset *rs = pcr_resultset_new_2(SAMPLE_NAME, SAMPLE_KEYS,
+                                                SAMPLE_TYPES, SAMPLE_LEN, x);
+        sample_rows_push(&rs, 10, x);
+        (void) pcr_resultset_aggregate(rs, cols, aggs, 1, NULL, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
 /******************************************************************************
  * pcr_resultset_testsuite() interface
  */
@@ -451,7 +1604,15 @@ push_test_4(pcr_string **desc, pcr_exception ex)
 static pcr_unittest *unit_tests[] = {
     &new_2_test_1, &new_2_test_2, &new_2_test_3, &new_2_test_4, &new_2_test_5,
     &new_2_test_6, &new_2_test_7, &new_2_test_8, &copy_test_1, &copy_test_2,
-    &copy_test_3, &push_test_1, &push_test_2, &push_test_3, &push_test_4
+    &copy_test_3, &copy_test_4, &push_test_1, &push_test_2, &push_test_3,
+    &push_test_4, &push_test_5, &push_test_6, &column_test_1, &column_test_2,
+    &column_test_3, &column_test_4, &column_test_5, &json_test_1, &json_test_2,
+    &json_test_3, &json_test_4, &index_test_1, &index_test_2, &index_test_3,
+    &index_test_4, &sort_test_1, &sort_test_2, &sort_test_3, &sort_test_4,
+    &sort_test_5, &sort_test_6, &filter_test_1, &filter_test_2,
+    &filter_test_3, &filter_test_4, &take_test_1, &project_test_1,
+    &project_test_2, &aggregate_test_1, &aggregate_test_2, &aggregate_test_3,
+    &aggregate_test_4
 };
 
 
@@ -12,7 +12,10 @@ int main(void)
         pcr_testsuite *suites[] = {
             pcr_string_testsuite(x), pcr_attribute_testsuite(x),
             pcr_sql_testsuite(x),    pcr_resultset_testsuite(x),
-            pcr_lua_testsuite(x)
+            pcr_lua_testsuite(x),    pcr_worker_testsuite(x),
+            pcr_vector_testsuite(x), pcr_map_testsuite(x),
+            pcr_deque_testsuite(x),  pcr_segvector_testsuite(x),
+            pcr_json_testsuite(x),   pcr_dbase_testsuite(x)
         };
 
         pcr_testharness_init("bld/test.log", x);
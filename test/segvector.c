@@ -0,0 +1,223 @@
+#include "./suites.h"
+
+
+/* Define the number of elements pushed by each worker in the concurrent test
+ * cases, and the number of workers. */
+static const int64_t SAMPLE_LEN = 20000;
+static const size_t SAMPLE_WORKERS = 4;
+
+
+static void
+sample_push_task(size_t id, size_t len, void *opt, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        for (int64_t i = 0; i < SAMPLE_LEN; i++) {
+            int64_t elem = (int64_t) id * SAMPLE_LEN + i;
+            (void) pcr_segvector_push(opt, &elem, x);
+        }
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+static int
+sample_i64_cmp(const void *ctx, const void *cmp)
+{
+    int64_t lhs = *((const int64_t *) ctx), rhs = *((const int64_t *) cmp);
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+
+static bool
+sample_push_range(pcr_segvector *vec)
+{
+    int64_t elem = 0;
+
+    pcr_exception_try (x) {
+        (void) pcr_segvector_push(vec, &elem, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        return true;
+    }
+
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_segvector_new() test cases
+ */
+
+
+static bool
+new_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_segvector_new() creates an empty vector";
+
+    pcr_exception_try (x) {
+        pcr_segvector *vec = pcr_segvector_new(sizeof (int64_t), x);
+        return !pcr_segvector_len(vec, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+new_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_segvector_new() throws PCR_EXCEPTION_RANGE if passed zero"
+            " @elemsz";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_segvector_new(0, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_segvector_push() test cases
+ */
+
+
+static bool
+push_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_segvector_push() appends in order and never moves elements";
+
+    pcr_exception_try (x) {
+        pcr_segvector *vec = pcr_segvector_new(sizeof (int64_t), x);
+
+        int64_t elem = 0;
+        (void) pcr_segvector_push(vec, &elem, x);
+        const int64_t *first = pcr_segvector_elem(vec, 1, x);
+
+        for (elem = 1; elem < SAMPLE_LEN; elem++) {
+            if (pcr_segvector_push(vec, &elem, x) != (size_t) elem + 1)
+                return false;
+        }
+
+        for (register size_t i = 1; i <= (size_t) SAMPLE_LEN; i++) {
+            if (*((const int64_t *) pcr_segvector_elem(vec, i, x))
+                != (int64_t) i - 1)
+                return false;
+        }
+
+        return pcr_segvector_elem(vec, 1, x) == first
+               && pcr_segvector_len(vec, x) == (size_t) SAMPLE_LEN;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+push_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_segvector_push() keeps every element pushed concurrently by"
+            " multiple workers";
+
+    pcr_exception_try (x) {
+        pcr_segvector *vec = pcr_segvector_new(sizeof (int64_t), x);
+        pcr_worker_run(SAMPLE_WORKERS, &sample_push_task, vec, x);
+
+        const size_t len = SAMPLE_WORKERS * (size_t) SAMPLE_LEN;
+        if (pcr_segvector_len(vec, x) != len)
+            return false;
+
+        pcr_vector *flat = pcr_segvector_flatten(vec, x);
+        pcr_vector_sort(&flat, &sample_i64_cmp, x);
+
+        for (register size_t i = 1; i <= len; i++) {
+            if (*((int64_t *) pcr_vector_elem(flat, i, x)) != (int64_t) i - 1)
+                return false;
+        }
+
+        return pcr_vector_len(flat, x) == len;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+push_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_segvector_push() throws PCR_EXCEPTION_RANGE without reserving"
+            " a slot if its segment is too large";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_segvector *vec = pcr_segvector_new(SIZE_MAX / 8, x);
+        bool thrown = sample_push_range(vec);
+
+        pcr_log_allow();
+        return thrown && !pcr_segvector_len(vec, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+elem_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_segvector_elem() throws PCR_EXCEPTION_RANGE if passed an index"
+            " beyond the published elements";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        pcr_segvector *vec = pcr_segvector_new(sizeof (int64_t), x);
+        (void) pcr_segvector_elem(vec, 1, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_segvector_testsuite() interface
+ */
+
+
+static pcr_unittest *unit_tests[] = {
+    &new_test_1,  &new_test_2, &push_test_1, &push_test_2, &push_test_3,
+    &elem_test_1
+};
+
+
+extern pcr_testsuite *
+pcr_segvector_testsuite(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        const pcr_string *name = "PCR Segmented Vector (pcr_segvector)";
+        const size_t len = sizeof unit_tests / sizeof *unit_tests;
+
+        return pcr_testsuite_new_2(name, unit_tests, len, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
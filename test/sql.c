@@ -514,6 +514,28 @@ bind_test_12(pcr_string **desc, pcr_exception ex)
 }
 
 
+static bool
+bind_test_13(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_sql_bind() binds a blob parameter as a blob literal";
+
+    pcr_exception_try (x) {
+        const pcr_string *psql = "INSERT INTO files (data) VALUES (@data)";
+        const unsigned char data[] = {0xde, 0xad, 0x27, 0x00};
+
+        pcr_sql *test = pcr_sql_new(psql, x);
+        pcr_sql_bind_blob(&test, "@data", data, sizeof data, x);
+
+        const pcr_string *sql = "INSERT INTO files (data) VALUES (X\'dead2700"
+                                "\')";
+        return !pcr_string_cmp(sql, pcr_sql_bound(test, x), x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
 /******************************************************************************
  * pcr_sql_reset() test cases
  */
@@ -575,8 +597,8 @@ static pcr_unittest *unit_tests[] = {
     &unbound_test_1, &bound_test_1, &bound_test_2, &bind_test_1,
     &bind_test_2,    &bind_test_3,  &bind_test_4,  &bind_test_5,
     &bind_test_6,    &bind_test_7,  &bind_test_8,  &bind_test_9,
-    &bind_test_10,   &bind_test_11, &bind_test_12, &reset_test_1,
-    &reset_test_2
+    &bind_test_10,   &bind_test_11, &bind_test_12, &bind_test_13,
+    &reset_test_1,   &reset_test_2
 };
 
 
@@ -18,5 +18,26 @@ pcr_resultset_testsuite(pcr_exception ex);
 extern pcr_testsuite *
 pcr_lua_testsuite(pcr_exception ex);
 
+extern pcr_testsuite *
+pcr_worker_testsuite(pcr_exception ex);
+
+extern pcr_testsuite *
+pcr_vector_testsuite(pcr_exception ex);
+
+extern pcr_testsuite *
+pcr_map_testsuite(pcr_exception ex);
+
+extern pcr_testsuite *
+pcr_deque_testsuite(pcr_exception ex);
+
+extern pcr_testsuite *
+pcr_segvector_testsuite(pcr_exception ex);
+
+extern pcr_testsuite *
+pcr_json_testsuite(pcr_exception ex);
+
+extern pcr_testsuite *
+pcr_dbase_testsuite(pcr_exception ex);
+
 #endif /* !defined PCR_TESTSUITES */
 
@@ -0,0 +1,1700 @@
+#include <fcntl.h>
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "./suites.h"
+
+
+/* Define the number of elements in the large sample vectors; this is chosen to
+ * be comfortably above PCR_VECTOR_SORT_THRESHOLD so that the parallel code
+ * paths are exercised. */
+static const size_t SAMPLE_LARGE = PCR_VECTOR_SORT_THRESHOLD * 2 + 17;
+
+
+/* Define the number of workers to force for the parallel test cases so that the
+ * parallel code paths are exercised even on single core machines. */
+static const size_t SAMPLE_WORKERS = 4;
+
+
+struct sample_pair {
+    int64_t key;
+    int64_t seq;
+};
+
+
+static int
+sample_i64_cmp(const void *ctx, const void *cmp)
+{
+    int64_t lhs = *((const int64_t *) ctx), rhs = *((const int64_t *) cmp);
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+
+static int
+sample_pair_cmp(const void *ctx, const void *cmp)
+{
+    return sample_i64_cmp(&((const struct sample_pair *) ctx)->key,
+                          &((const struct sample_pair *) cmp)->key);
+}
+
+
+static inline int64_t
+sample_rand(uint64_t *seed)
+{
+    *seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (int64_t) (*seed >> 33);
+}
+
+
+static pcr_vector *
+sample_i64(size_t len, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_vector *vec = pcr_vector_new(sizeof (int64_t), x);
+
+        uint64_t seed = 42;
+        int64_t elem;
+        for (register size_t i = 0; i < len; i++) {
+            elem = sample_rand(&seed) % 1000 - 500;
+            pcr_vector_push(&vec, &elem, x);
+        }
+
+        return vec;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+static pcr_vector *
+sample_pairs(size_t len, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_vector *vec = pcr_vector_new(sizeof (struct sample_pair), x);
+
+        uint64_t seed = 7;
+        struct sample_pair elem;
+        for (register size_t i = 0; i < len; i++) {
+            elem.key = sample_rand(&seed) % 16;
+            elem.seq = (int64_t) i;
+            pcr_vector_push(&vec, &elem, x);
+        }
+
+        return vec;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+static void
+sample_i64_check(const void *elem, size_t idx, void *opt, pcr_exception ex)
+{
+    int64_t **prev = (int64_t **) opt;
+    const int64_t *cur = (const int64_t *) elem;
+
+    pcr_assert_state(!*prev || **prev <= *cur, ex);
+    *prev = (int64_t *) cur;
+}
+
+
+static void
+sample_pair_check(const void *elem, size_t idx, void *opt, pcr_exception ex)
+{
+    struct sample_pair **prev = (struct sample_pair **) opt;
+    const struct sample_pair *cur = (const struct sample_pair *) elem;
+
+    if (*prev) {
+        pcr_assert_state((*prev)->key <= cur->key, ex);
+        pcr_assert_state((*prev)->key < cur->key || (*prev)->seq < cur->seq,
+                         ex);
+    }
+
+    *prev = (struct sample_pair *) cur;
+}
+
+
+static bool
+sample_i64_sorted(const pcr_vector *vec, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        int64_t *prev = NULL;
+        pcr_vector_iterate(vec, &sample_i64_check, &prev, x);
+
+        return true;
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        return false;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+sample_pairs_stable(const pcr_vector *vec, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        struct sample_pair *prev = NULL;
+        pcr_vector_iterate(vec, &sample_pair_check, &prev, x);
+
+        return true;
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        return false;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_vector_sort() test cases
+ */
+
+
+static bool
+sort_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_sort() sorts a small vector";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_i64(100, x);
+        pcr_vector_sort(&vec, &sample_i64_cmp, x);
+
+        return pcr_vector_len(vec, x) == 100
+               && pcr_vector_sorted(vec, x)
+               && sample_i64_sorted(vec, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+sort_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_sort() sorts a large vector in parallel";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_i64(SAMPLE_LARGE, x);
+
+        pcr_worker_limit(SAMPLE_WORKERS);
+        pcr_vector_sort(&vec, &sample_i64_cmp, x);
+        pcr_worker_limit(0);
+
+        return pcr_vector_len(vec, x) == SAMPLE_LARGE
+               && sample_i64_sorted(vec, x);
+    }
+
+    pcr_worker_limit(0);
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+sort_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_sort() respects reference counts";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_i64(100, x);
+        pcr_vector *cpy = pcr_vector_copy(vec, x);
+        pcr_vector_sort(&cpy, &sample_i64_cmp, x);
+
+        return pcr_vector_refcount(vec, x) == 1
+               && pcr_vector_refcount(cpy, x) == 1
+               && !pcr_vector_sorted(vec, x)
+               && sample_i64_sorted(cpy, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+sort_test_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_sort() throws PCR_EXCEPTION_HANDLE if passed a null"
+            " pointer for @cmp";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_vector *vec = sample_i64(10, x);
+        pcr_vector_sort(&vec, NULL, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_HANDLE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_vector_sort_stable() test cases
+ */
+
+
+static bool
+sort_stable_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_sort_stable() preserves the order of equal elements in"
+            " a small vector";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_pairs(500, x);
+        pcr_vector_sort_stable(&vec, &sample_pair_cmp, x);
+
+        return pcr_vector_len(vec, x) == 500
+               && pcr_vector_sorted(vec, x)
+               && sample_pairs_stable(vec, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+sort_stable_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_sort_stable() preserves the order of equal elements in"
+            " a large vector sorted in parallel";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_pairs(SAMPLE_LARGE, x);
+
+        pcr_worker_limit(SAMPLE_WORKERS - 1);
+        pcr_vector_sort_stable(&vec, &sample_pair_cmp, x);
+        pcr_worker_limit(0);
+
+        return pcr_vector_len(vec, x) == SAMPLE_LARGE
+               && sample_pairs_stable(vec, x);
+    }
+
+    pcr_worker_limit(0);
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+sort_stable_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_sort_stable() throws PCR_EXCEPTION_HANDLE if passed a"
+            " null pointer for @ctx";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        pcr_vector_sort_stable(NULL, &sample_pair_cmp, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_HANDLE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_vector_sort_i64() test cases
+ */
+
+
+static bool
+sort_i64_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_sort_i64() sorts a vector of 64-bit integers";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_i64(SAMPLE_LARGE, x);
+
+        const int64_t edges[] = {INT64_MIN, INT64_MAX, -1, 0, 1, INT64_MIN};
+        for (register size_t i = 0; i < sizeof edges / sizeof *edges; i++)
+            pcr_vector_push(&vec, &edges[i], x);
+
+        pcr_vector_sort_i64(&vec, x);
+
+        return pcr_vector_sorted(vec, x)
+               && sample_i64_sorted(vec, x)
+               && *((int64_t *) pcr_vector_elem(vec, 1, x)) == INT64_MIN
+               && *((int64_t *) pcr_vector_elem(vec, 2, x)) == INT64_MIN
+               && *((int64_t *) pcr_vector_elem(vec, pcr_vector_len(vec, x),
+                                                x)) == INT64_MAX;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+sort_i64_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_sort_i64() throws PCR_EXCEPTION_STATE if passed a"
+            " vector that doesn't hold 64-bit elements";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_vector *vec = pcr_vector_new(sizeof (int32_t), x);
+        pcr_vector_sort_i64(&vec, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_vector_sort_f64() test cases
+ */
+
+
+static bool
+sort_f64_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_sort_f64() sorts a vector of floating point numbers";
+
+    pcr_exception_try (x) {
+        const double arr[] = {3.25, -0.0, INFINITY, -1e300, 0.0, -2.5, 1e-300,
+                              -INFINITY, 42.0, -2.5};
+        const double expect[] = {-INFINITY, -1e300, -2.5, -2.5, -0.0, 0.0,
+                                 1e-300, 3.25, 42.0, INFINITY};
+        const size_t len = sizeof arr / sizeof *arr;
+
+        pcr_vector *vec = pcr_vector_new(sizeof (double), x);
+        for (register size_t i = 0; i < len; i++)
+            pcr_vector_push(&vec, &arr[i], x);
+
+        pcr_vector_sort_f64(&vec, x);
+
+        for (register size_t i = 0; i < len; i++) {
+            if (*((double *) pcr_vector_elem(vec, i + 1, x)) != expect[i])
+                return false;
+        }
+
+        return signbit(*((double *) pcr_vector_elem(vec, 5, x)))
+               && !signbit(*((double *) pcr_vector_elem(vec, 6, x)));
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+sort_f64_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_sort_f64() respects reference counts";
+
+    pcr_exception_try (x) {
+        const double arr[] = {2.0, 1.0};
+
+        pcr_vector *vec = pcr_vector_new(sizeof (double), x);
+        pcr_vector_push(&vec, &arr[0], x);
+        pcr_vector_push(&vec, &arr[1], x);
+
+        pcr_vector *cpy = pcr_vector_copy(vec, x);
+        pcr_vector_sort_f64(&cpy, x);
+
+        return *((double *) pcr_vector_elem(vec, 1, x)) == 2.0
+               && *((double *) pcr_vector_elem(cpy, 1, x)) == 1.0;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_string_vector_sort() and pcr_string_vector_sort_radix() test cases
+ */
+
+
+static const pcr_string *SAMPLE_STRINGS[] = {
+    "pear", "", "apple", "Вороно́й", "app", "apple", "Zebra", "apricot",
+    "appendix", "a", "peach", "applesauce", "ñandú", "b", "apples", "pea"
+};
+
+
+static bool
+sample_strings_sorted(const pcr_string_vector *vec, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        register size_t len = pcr_string_vector_len(vec, x);
+        if (len != sizeof SAMPLE_STRINGS / sizeof *SAMPLE_STRINGS)
+            return false;
+
+        for (register size_t i = 2; i <= len; i++) {
+            if (strcmp(pcr_string_vector_elem(vec, i - 1, x),
+                       pcr_string_vector_elem(vec, i, x)) > 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+string_sort_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_string_vector_sort() sorts a string vector";
+
+    pcr_exception_try (x) {
+        const size_t len = sizeof SAMPLE_STRINGS / sizeof *SAMPLE_STRINGS;
+        pcr_string_vector *vec = pcr_string_vector_new_2(SAMPLE_STRINGS, len,
+                                                         x);
+        pcr_string_vector_sort(&vec, x);
+
+        return sample_strings_sorted(vec, x)
+               && pcr_string_vector_search(&vec, "apricot", x)
+               && !pcr_string_vector_search(&vec, "banana", x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+string_take_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_string_vector_push_take() and pcr_string_vector_elem_set_take()"
+            " store strings without copying them";
+
+    pcr_exception_try (x) {
+        pcr_string_vector *vec = pcr_string_vector_new(x);
+        pcr_string *foo = pcr_string_new("foo", x);
+        pcr_string *bar = pcr_string_new("bar", x);
+
+        pcr_string_vector_push(&vec, foo, x);
+        pcr_string_vector_push_take(&vec, foo, x);
+        pcr_string_vector_push_take(&vec, foo, x);
+        pcr_string_vector_elem_set_take(&vec, 3, bar, x);
+
+        return pcr_string_vector_len(vec, x) == 3
+               && pcr_string_vector_elem(vec, 1, x) != foo
+               && !strcmp(pcr_string_vector_elem(vec, 1, x), "foo")
+               && pcr_string_vector_elem(vec, 2, x) == foo
+               && pcr_string_vector_elem(vec, 3, x) == bar;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+string_sort_radix_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_string_vector_sort_radix() sorts a string vector";
+
+    pcr_exception_try (x) {
+        const size_t len = sizeof SAMPLE_STRINGS / sizeof *SAMPLE_STRINGS;
+        pcr_string_vector *vec = pcr_string_vector_new_2(SAMPLE_STRINGS, len,
+                                                         x);
+        pcr_string_vector_sort_radix(&vec, x);
+
+        return pcr_string_vector_sorted(vec, x)
+               && sample_strings_sorted(vec, x)
+               && !*pcr_string_vector_elem(vec, 1, x)
+               && !strcmp(pcr_string_vector_elem(vec, len, x), "Вороно́й");
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+string_sort_radix_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_string_vector_sort_radix() sorts a large string vector in the"
+            " same order as pcr_string_vector_sort()";
+
+    pcr_exception_try (x) {
+        pcr_string_vector *vec = pcr_string_vector_new(x);
+
+        uint64_t seed = 3;
+        for (register size_t i = 0; i < 5000; i++) {
+            pcr_string_vector_push(&vec, pcr_string_int(sample_rand(&seed)
+                                                        % 100000, x), x);
+        }
+
+        pcr_string_vector *cpy = pcr_string_vector_copy(vec, x);
+        pcr_string_vector_sort(&vec, x);
+        pcr_string_vector_sort_radix(&cpy, x);
+
+        for (register size_t i = 1; i <= 5000; i++) {
+            if (strcmp(pcr_string_vector_elem(vec, i, x),
+                       pcr_string_vector_elem(cpy, i, x)))
+                return false;
+        }
+
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_vector_iterate_par() and pcr_vector_muterate_par() test cases
+ */
+
+
+static void
+sample_sum(const void *elem, size_t idx, void *opt, pcr_exception ex)
+{
+    *((int64_t *) opt) += *((const int64_t *) elem);
+}
+
+
+static void
+sample_double(void *elem, size_t idx, void *opt, pcr_exception ex)
+{
+    *((int64_t *) elem) *= 2;
+}
+
+
+static void
+sample_throw(const void *elem, size_t idx, void *opt, pcr_exception ex)
+{
+    pcr_assert_range(idx != SAMPLE_LARGE, ex);
+}
+
+
+static bool
+iterate_par_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_iterate_par() passes each chunk its own context";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_i64(SAMPLE_LARGE, x);
+
+        int64_t expect = 0;
+        pcr_vector_iterate(vec, &sample_sum, &expect, x);
+
+        int64_t part[SAMPLE_WORKERS * 2];
+        void *opt[SAMPLE_WORKERS * 2];
+        for (register size_t i = 0; i < SAMPLE_WORKERS * 2; i++) {
+            part[i] = 0;
+            opt[i] = &part[i];
+        }
+
+        pcr_worker_limit(SAMPLE_WORKERS);
+        pcr_vector_iterate_par(vec, &sample_sum, opt, SAMPLE_WORKERS * 2, x);
+        pcr_worker_limit(0);
+
+        int64_t sum = 0;
+        for (register size_t i = 0; i < SAMPLE_WORKERS * 2; i++)
+            sum += part[i];
+
+        return sum == expect;
+    }
+
+    pcr_worker_limit(0);
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+iterate_par_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_iterate_par() rethrows an exception thrown by the"
+            " iterator in a worker";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_vector *vec = sample_i64(SAMPLE_LARGE, x);
+        pcr_worker_limit(SAMPLE_WORKERS);
+        pcr_vector_iterate_par(vec, &sample_throw, NULL, SAMPLE_WORKERS, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_worker_limit(0);
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_worker_limit(0);
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+iterate_par_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_iterate_par() throws PCR_EXCEPTION_RANGE if passed zero"
+            " for @len";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_vector *vec = sample_i64(10, x);
+        pcr_vector_iterate_par(vec, &sample_sum, NULL, 0, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+muterate_par_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_muterate_par() mutates every element";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_i64(SAMPLE_LARGE, x);
+        pcr_vector *cpy = pcr_vector_copy(vec, x);
+
+        pcr_worker_limit(SAMPLE_WORKERS);
+        pcr_vector_muterate_par(&cpy, &sample_double, NULL, SAMPLE_WORKERS * 3,
+                                x);
+        pcr_worker_limit(0);
+
+        int64_t lhs = 0, rhs = 0;
+        pcr_vector_iterate(vec, &sample_sum, &lhs, x);
+        pcr_vector_iterate(cpy, &sample_sum, &rhs, x);
+
+        return pcr_vector_refcount(vec, x) == 1 && rhs == 2 * lhs;
+    }
+
+    pcr_worker_limit(0);
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+muterate_par_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_muterate_par() throws PCR_EXCEPTION_HANDLE if passed a"
+            " null pointer for @mtr";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        pcr_vector *vec = sample_i64(10, x);
+        pcr_vector_muterate_par(&vec, NULL, NULL, 1, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_HANDLE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * Sorted vector test cases
+ */
+
+
+static pcr_vector *
+sample_steps(int64_t step, size_t len, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_vector *vec = pcr_vector_new(sizeof (int64_t), x);
+
+        int64_t elem;
+        for (register size_t i = 0; i < len; i++) {
+            elem = step * (int64_t) i;
+            pcr_vector_push(&vec, &elem, x);
+        }
+
+        pcr_vector_sort(&vec, &sample_i64_cmp, x);
+        return vec;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+/* Checks that @vec holds exactly the values in [0, @max) for which @pred holds,
+ * in ascending order. */
+static bool
+sample_steps_match(const pcr_vector *vec, int64_t max, bool (*pred)(int64_t),
+                   pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        register size_t idx = 0, len = pcr_vector_len(vec, x);
+
+        for (register int64_t v = 0; v < max; v++) {
+            if (!pred(v))
+                continue;
+
+            if (++idx > len || *((int64_t *) pcr_vector_elem(vec, idx, x)) != v)
+                return false;
+        }
+
+        return idx == len && pcr_vector_sorted(vec, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool sample_or(int64_t v) { return !(v % 2) || !(v % 3); }
+static bool sample_and(int64_t v) { return !(v % 6); }
+static bool sample_not(int64_t v) { return !(v % 2) && v % 3; }
+static bool sample_or_sparse(int64_t v) { return !(v % 2) || !(v % 301); }
+static bool sample_and_sparse(int64_t v) { return !(v % 602); }
+static bool sample_not_sparse(int64_t v) { return !(v % 2) && v % 602; }
+
+
+static bool
+bound_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_lower_bound() and pcr_vector_upper_bound() find the"
+            " range of equal elements";
+
+    pcr_exception_try (x) {
+        const int64_t arr[] = {1, 3, 3, 3, 7};
+        pcr_vector *vec = pcr_vector_new(sizeof (int64_t), x);
+        for (register size_t i = 0; i < 5; i++)
+            pcr_vector_push(&vec, &arr[i], x);
+        pcr_vector_sort(&vec, &sample_i64_cmp, x);
+
+        const int64_t k0 = 0, k3 = 3, k5 = 5, k9 = 9;
+        return pcr_vector_lower_bound(vec, &k3, &sample_i64_cmp, x) == 2
+               && pcr_vector_upper_bound(vec, &k3, &sample_i64_cmp, x) == 5
+               && pcr_vector_lower_bound(vec, &k5, &sample_i64_cmp, x) == 5
+               && pcr_vector_upper_bound(vec, &k5, &sample_i64_cmp, x) == 5
+               && pcr_vector_lower_bound(vec, &k0, &sample_i64_cmp, x) == 1
+               && pcr_vector_lower_bound(vec, &k9, &sample_i64_cmp, x) == 6;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+bound_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_lower_bound() throws PCR_EXCEPTION_STATE if passed an"
+            " unsorted vector";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+
+        const int64_t key = 0;
+        pcr_vector *vec = sample_i64(10, x);
+        (void) pcr_vector_lower_bound(vec, &key, &sample_i64_cmp, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+insert_sorted_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_insert_sorted() keeps a vector sorted";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = pcr_vector_new(sizeof (int64_t), x);
+
+        uint64_t seed = 11;
+        int64_t elem;
+        for (register size_t i = 0; i < 1000; i++) {
+            elem = sample_rand(&seed) % 100;
+            pcr_vector_insert_sorted(&vec, &elem, &sample_i64_cmp, x);
+        }
+
+        return pcr_vector_len(vec, x) == 1000
+               && pcr_vector_sorted(vec, x)
+               && sample_i64_sorted(vec, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+insert_sorted_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_insert_sorted() respects reference counts";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_steps(2, 10, x);
+        pcr_vector *cpy = pcr_vector_copy(vec, x);
+
+        const int64_t elem = 5;
+        pcr_vector_insert_sorted(&cpy, &elem, &sample_i64_cmp, x);
+
+        return pcr_vector_len(vec, x) == 10
+               && pcr_vector_len(cpy, x) == 11
+               && *((int64_t *) pcr_vector_elem(cpy, 4, x)) == 5;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+setop_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_union(), pcr_vector_intersect() and"
+            " pcr_vector_difference() work on vectors of similar lengths";
+
+    pcr_exception_try (x) {
+        pcr_vector *lhs = sample_steps(2, 1500, x);
+        pcr_vector *rhs = sample_steps(3, 1000, x);
+
+        return sample_steps_match(pcr_vector_union(lhs, rhs, &sample_i64_cmp,
+                                                   x), 3000, &sample_or, x)
+               && sample_steps_match(pcr_vector_intersect(lhs, rhs,
+                                                          &sample_i64_cmp, x),
+                                     3000, &sample_and, x)
+               && sample_steps_match(pcr_vector_difference(lhs, rhs,
+                                                           &sample_i64_cmp, x),
+                                     3000, &sample_not, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+setop_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_union(), pcr_vector_intersect() and"
+            " pcr_vector_difference() work on vectors of very different"
+            " lengths";
+
+    pcr_exception_try (x) {
+        pcr_vector *lhs = sample_steps(2, 1505, x);
+        pcr_vector *rhs = sample_steps(301, 10, x);
+
+        return sample_steps_match(pcr_vector_union(lhs, rhs, &sample_i64_cmp,
+                                                   x), 3010, &sample_or_sparse,
+                                  x)
+               && sample_steps_match(pcr_vector_union(rhs, lhs, &sample_i64_cmp,
+                                                      x), 3010,
+                                     &sample_or_sparse, x)
+               && sample_steps_match(pcr_vector_intersect(rhs, lhs,
+                                                          &sample_i64_cmp, x),
+                                     3010, &sample_and_sparse, x)
+               && sample_steps_match(pcr_vector_difference(lhs, rhs,
+                                                           &sample_i64_cmp, x),
+                                     3010, &sample_not_sparse, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+setop_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_intersect() throws PCR_EXCEPTION_STATE if passed an"
+            " unsorted vector";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_vector_intersect(sample_steps(2, 10, x), sample_i64(10, x),
+                                    &sample_i64_cmp, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/* Define a typed int64_t vector to exercise PCR_VECTOR_DEFINE(). */
+PCR_VECTOR_DEFINE(sample_i64_vector, int64_t)
+PCR_VECTOR_EXTERN(sample_i64_vector, int64_t, int64_t);
+
+
+static void
+sample_i64_sum(const void *elem, size_t idx, void *opt, pcr_exception ex)
+{
+    *((int64_t *) opt) += *((const int64_t *) elem) * (int64_t) idx;
+}
+
+
+static bool
+define_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "PCR_VECTOR_DEFINE() generates typed push, elem and iterate"
+            " functions";
+
+    pcr_exception_try (x) {
+        const int64_t arr[] = {5, -3, 11};
+        sample_i64_vector *vec = sample_i64_vector_new_2(arr, 3, x);
+
+        for (register int64_t i = 0; i < 100; i++)
+            sample_i64_vector_push(&vec, i, x);
+
+        int64_t sum = 0;
+        sample_i64_vector_iterate(vec, &sample_i64_sum, &sum, x);
+
+        int64_t expect = 5 - 3 * 2 + 11 * 3;
+        for (register int64_t i = 0; i < 100; i++)
+            expect += i * (i + 4);
+
+        return sample_i64_vector_len(vec, x) == 103
+               && sample_i64_vector_elem(vec, 2, x) == -3
+               && sample_i64_vector_elem(vec, 103, x) == 99
+               && sum == expect;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+define_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "PCR_VECTOR_DEFINE() push does not modify a shared copy";
+
+    pcr_exception_try (x) {
+        const int64_t arr[] = {1, 2, 3};
+        sample_i64_vector *vec = sample_i64_vector_new_2(arr, 3, x);
+        sample_i64_vector *cp = sample_i64_vector_copy(vec, x);
+
+        sample_i64_vector_push(&cp, 4, x);
+        sample_i64_vector_elem_set(&cp, 1, 9, x);
+
+        return sample_i64_vector_len(vec, x) == 3
+               && sample_i64_vector_elem(vec, 1, x) == 1
+               && sample_i64_vector_len(cp, x) == 4
+               && sample_i64_vector_elem(cp, 1, x) == 9
+               && sample_i64_vector_refcount(vec, x) == 1;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static void
+sample_fork_task(size_t id, size_t len, void *opt, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        const int64_t elem = (int64_t) id;
+        for (register size_t i = 0; i < 1000; i++) {
+            pcr_vector *cp = pcr_vector_copy(opt, x);
+            pcr_vector_push(&cp, &elem, x);
+        }
+    }
+
+    pcr_exception_unwind(ex);
+}
+
+
+static bool
+refcount_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_copy() and copy-on-write forks keep the reference count"
+            " consistent across worker threads";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_i64(10, x);
+        pcr_worker_run(SAMPLE_WORKERS, &sample_fork_task, vec, x);
+
+        return pcr_vector_refcount(vec, x) == 1 && pcr_vector_len(vec, x) == 10;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+new_2_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_new_2() creates a vector that spills its inline elements"
+            " intact on growth";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = pcr_vector_new_2(sizeof (int64_t), 3, x);
+        pcr_vector *cp = NULL;
+
+        for (int64_t i = 0; i < 100; i++) {
+            pcr_vector_push(&vec, &i, x);
+            if (i == 1)
+                cp = pcr_vector_copy(vec, x);
+        }
+
+        for (register size_t i = 1; i <= 100; i++) {
+            if (*((int64_t *) pcr_vector_elem(vec, i, x)) != (int64_t) i - 1)
+                return false;
+        }
+
+        return pcr_vector_len(vec, x) == 100 && pcr_vector_len(cp, x) == 2
+               && *((int64_t *) pcr_vector_elem(cp, 2, x)) == 1;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+new_2_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_new_2() throws PCR_EXCEPTION_RANGE if passed zero @cap";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_vector_new_2(sizeof (int64_t), 0, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/* the inline payload of a vector, if any, starts right after its header */
+static bool
+sample_inline(const pcr_vector *vec)
+{
+    const char *hdr = (const char *) vec, *payload = vec->payload;
+    return payload >= hdr && payload < hdr + sizeof *vec
+                                       + _Alignof (max_align_t);
+}
+
+
+static bool
+new_2_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_new_2() keeps large payloads out of the header block,"
+            " including when forked";
+
+    pcr_exception_try (x) {
+        const size_t len = 1 << 20;
+        int64_t *arr = pcr_mempool_alloc(len * sizeof *arr, x);
+        for (register size_t i = 0; i < len; i++)
+            arr[i] = (int64_t) i;
+
+        pcr_vector *vec = pcr_vector_new_2(sizeof (int64_t), len, x);
+        pcr_vector_push_n(&vec, arr, len, x);
+        bool ok = !sample_inline(vec)
+                  && sample_inline(pcr_vector_new_2(sizeof (int64_t), 2, x));
+
+        /* the fork has the same capacity, so it doesn't need to grow */
+        pcr_vector *cp = pcr_vector_copy(vec, x);
+        int64_t last = -1;
+        pcr_vector_setelem(&vec, &last, len, x);
+        ok = ok && vec != cp && !sample_inline(vec);
+
+        pcr_vector_push(&vec, &last, x);
+
+        return ok && !sample_inline(vec) && pcr_vector_len(vec, x) == len + 1
+               && pcr_vector_len(cp, x) == len
+               && ((const int64_t *) vec->payload)[len - 2] == (int64_t) len - 2
+               && ((const int64_t *) vec->payload)[len] == -1
+               && ((const int64_t *) cp->payload)[len - 1] == (int64_t) len - 1;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+slice_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_slice() creates a view that works with iterate, search"
+            " and the typed wrappers";
+
+    pcr_exception_try (x) {
+        const int64_t arr[] = {1, 2, 3, 4, 5, 6, 7, 8};
+        sample_i64_vector *vec = sample_i64_vector_new_2(arr, 8, x);
+        pcr_vector_sort_i64(&vec, x);
+
+        sample_i64_vector *slc = sample_i64_vector_slice(vec, 3, 4, x);
+        pcr_vector *slc2 = pcr_vector_slice(slc, 2, 2, x);
+
+        int64_t sum = 0, key = 5;
+        sample_i64_vector_iterate(slc, &sample_i64_sum, &sum, x);
+
+        return sample_i64_vector_len(slc, x) == 4
+               && sample_i64_vector_elem(slc, 1, x) == 3
+               && *((int64_t *) pcr_vector_elem(slc2, 2, x)) == 5
+               && sum == 3 + 4 * 2 + 5 * 3 + 6 * 4
+               && pcr_vector_search(&slc, &key, &sample_i64_cmp, x) == 3
+               && pcr_vector_refcount(vec, x) == 3;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+slice_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_slice() views are isolated from writes to and from their"
+            " base vector";
+
+    pcr_exception_try (x) {
+        const int64_t arr[] = {1, 2, 3, 4, 5};
+        sample_i64_vector *vec = sample_i64_vector_new_2(arr, 5, x);
+        sample_i64_vector *slc1 = sample_i64_vector_slice(vec, 2, 3, x);
+        sample_i64_vector *slc2 = sample_i64_vector_slice(vec, 2, 3, x);
+
+        sample_i64_vector_elem_set(&vec, 2, -2, x);
+        sample_i64_vector_elem_set(&slc1, 1, -20, x);
+        sample_i64_vector_push(&slc2, 6, x);
+
+        return sample_i64_vector_elem(vec, 2, x) == -2
+               && sample_i64_vector_elem(slc1, 1, x) == -20
+               && sample_i64_vector_elem(slc2, 1, x) == 2
+               && sample_i64_vector_len(slc2, x) == 4
+               && sample_i64_vector_elem(slc2, 4, x) == 6
+               && sample_i64_vector_len(vec, x) == 5;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+slice_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_slice() throws PCR_EXCEPTION_RANGE if the range exceeds"
+            " the vector";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_vector_slice(sample_i64(10, x), 8, 4, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static pcr_vector *
+sample_f64(size_t len, pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        pcr_vector *vec = pcr_vector_new(sizeof (double), x);
+
+        uint64_t seed = 11;
+        double elem;
+        for (register size_t i = 0; i < len; i++) {
+            elem = (double) (sample_rand(&seed) % 2001 - 1000) / 8.0;
+            pcr_vector_push(&vec, &elem, x);
+        }
+
+        return vec;
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
+
+
+static bool
+kernel_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_sum_i64(), pcr_vector_min_i64(), pcr_vector_max_i64()"
+            " and pcr_vector_count_i64() match a naive scan";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_i64(1003, x);
+        const int64_t *arr = vec->payload;
+
+        int64_t sum = 0, min = arr[0], max = arr[0];
+        size_t lt = 0, eq = 0;
+        for (register size_t i = 0; i < 1003; i++) {
+            sum += arr[i];
+            min = arr[i] < min ? arr[i] : min;
+            max = arr[i] > max ? arr[i] : max;
+            lt += arr[i] < 17;
+            eq += arr[i] == 17;
+        }
+
+        return pcr_vector_sum_i64(vec, x) == sum
+               && pcr_vector_min_i64(vec, x) == min
+               && pcr_vector_max_i64(vec, x) == max
+               && pcr_vector_count_i64(vec, PCR_VECTOR_CMP_LT, 17, x) == lt
+               && pcr_vector_count_i64(vec, PCR_VECTOR_CMP_EQ, 17, x) == eq
+               && pcr_vector_count_i64(vec, PCR_VECTOR_CMP_GE, 17, x)
+                  == 1003 - lt
+               && pcr_vector_count_i64(vec, PCR_VECTOR_CMP_NE, 17, x)
+                  == 1003 - eq;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+kernel_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_sum_f64(), pcr_vector_min_f64(), pcr_vector_max_f64()"
+            " and pcr_vector_count_f64() match a naive scan";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_f64(1003, x);
+        double nan = NAN;
+        pcr_vector_push(&vec, &nan, x);
+        const double *arr = vec->payload;
+
+        /* the sample values are multiples of 1/8, so the sum is exact */
+        double sum = 0.0, min = arr[0], max = arr[0];
+        size_t gt = 0;
+        for (register size_t i = 0; i < 1003; i++) {
+            sum += arr[i];
+            min = arr[i] < min ? arr[i] : min;
+            max = arr[i] > max ? arr[i] : max;
+            gt += arr[i] > 12.5;
+        }
+
+        return isnan(pcr_vector_sum_f64(vec, x))
+               && pcr_vector_min_f64(vec, x) == min
+               && pcr_vector_max_f64(vec, x) == max
+               && pcr_vector_count_f64(vec, PCR_VECTOR_CMP_GT, 12.5, x) == gt
+               && pcr_vector_count_f64(vec, PCR_VECTOR_CMP_LE, 12.5, x)
+                  == 1003 - gt
+               && pcr_vector_count_f64(vec, PCR_VECTOR_CMP_NE, 12.5, x)
+                  == 1004 - pcr_vector_count_f64(vec, PCR_VECTOR_CMP_EQ, 12.5,
+                                                 x)
+               && (pcr_vector_pop(&vec, x), pcr_vector_sum_f64(vec, x) == sum);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+kernel_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_select_i64() and pcr_vector_select_f64() return the"
+            " 1-based indices of matching elements in order";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_i64(1003, x);
+        pcr_vector *dbl = sample_f64(1003, x);
+        pcr_vector *sel = pcr_vector_select_i64(vec, PCR_VECTOR_CMP_GT, 100,
+                                                x);
+        pcr_vector *sel2 = pcr_vector_select_f64(dbl, PCR_VECTOR_CMP_LT, 0.0,
+                                                 x);
+        const int64_t *arr = vec->payload;
+        const double *arr2 = dbl->payload;
+
+        size_t n = 0, n2 = 0;
+        for (register size_t i = 0; i < 1003; i++) {
+            if (arr[i] > 100
+                && *((size_t *) pcr_vector_elem(sel, ++n, x)) != i + 1)
+                return false;
+
+            if (arr2[i] < 0.0
+                && *((size_t *) pcr_vector_elem(sel2, ++n2, x)) != i + 1)
+                return false;
+        }
+
+        return pcr_vector_len(sel, x) == n && pcr_vector_len(sel2, x) == n2
+               && !pcr_vector_len(pcr_vector_select_i64(vec, PCR_VECTOR_CMP_LT,
+                                                        -1000, x), x);
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+kernel_test_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_arith_i64() and pcr_vector_arith_f64() apply a scalar"
+            " to each element without modifying a shared copy";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_i64(1003, x);
+        pcr_vector *cp = pcr_vector_copy(vec, x);
+        pcr_vector *dbl = sample_f64(1003, x);
+        pcr_vector *cp2 = pcr_vector_copy(dbl, x);
+
+        pcr_vector_arith_i64(&cp, PCR_VECTOR_ARITH_MUL, -3000000007LL, x);
+        pcr_vector_arith_i64(&cp, PCR_VECTOR_ARITH_SUB, 5, x);
+        pcr_vector_arith_i64(&cp, PCR_VECTOR_ARITH_DIV, 2, x);
+        pcr_vector_arith_f64(&cp2, PCR_VECTOR_ARITH_DIV, 0.5, x);
+        pcr_vector_arith_f64(&cp2, PCR_VECTOR_ARITH_ADD, 1.0, x);
+
+        const int64_t *a = vec->payload, *b = cp->payload;
+        const double *c = dbl->payload, *d = cp2->payload;
+        for (register size_t i = 0; i < 1003; i++) {
+            if (b[i] != (a[i] * -3000000007LL - 5) / 2
+                || d[i] != c[i] / 0.5 + 1.0)
+                return false;
+        }
+
+        return cp != vec && cp2 != dbl;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+kernel_test_5(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_min_i64() throws PCR_EXCEPTION_STATE if passed an empty"
+            " vector";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_vector_min_i64(pcr_vector_new(sizeof (int64_t), x), x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_STATE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+kernel_test_6(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_arith_i64() throws PCR_EXCEPTION_RANGE on division by"
+            " zero";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        pcr_vector *vec = sample_i64(10, x);
+        pcr_vector_arith_i64(&vec, PCR_VECTOR_ARITH_DIV, 0, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_vector_map() and pcr_vector_persist() test cases
+ */
+
+
+/* Define the path of the file used by the pcr_vector_map() test cases. */
+#define SAMPLE_MAP_PATH "bld/test-vector.map"
+
+
+static bool
+map_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_map() maps a vector written by pcr_vector_persist(),"
+            " keeping its elements and sorted flag";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_i64(1000, x);
+        pcr_vector_sort_i64(&vec, x);
+        pcr_vector_persist(vec, SAMPLE_MAP_PATH, x);
+
+        pcr_vector *map = pcr_vector_map(SAMPLE_MAP_PATH, sizeof (int64_t), x);
+        if (pcr_vector_len(map, x) != 1000 || !pcr_vector_sorted(map, x)
+            || pcr_vector_refcount(map, x) != 1)
+            return false;
+
+        for (register size_t i = 1; i <= 1000; i++) {
+            if (*((int64_t *) pcr_vector_elem(map, i, x))
+                != *((int64_t *) pcr_vector_elem(vec, i, x)))
+                return false;
+        }
+
+        int64_t key = *((int64_t *) pcr_vector_elem(vec, 500, x));
+        size_t idx = pcr_vector_lower_bound(map, &key, &sample_i64_cmp, x);
+
+        return *((int64_t *) pcr_vector_elem(map, idx, x)) == key;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+map_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_map() returns a vector that can be modified without"
+            " changing the file";
+
+    pcr_exception_try (x) {
+        pcr_vector_persist(sample_i64(100, x), SAMPLE_MAP_PATH, x);
+        pcr_vector *map = pcr_vector_map(SAMPLE_MAP_PATH, sizeof (int64_t), x);
+
+        int64_t elem = 12345;
+        pcr_vector_setelem(&map, &elem, 1, x);
+        for (register int64_t i = 0; i < 100; i++)
+            pcr_vector_push(&map, &elem, x);
+
+        pcr_vector *cmp = pcr_vector_map(SAMPLE_MAP_PATH, sizeof (int64_t), x);
+        pcr_vector *vec = sample_i64(100, x);
+
+        return pcr_vector_len(map, x) == 200 && pcr_vector_len(cmp, x) == 100
+               && *((int64_t *) pcr_vector_elem(map, 1, x)) == 12345
+               && *((int64_t *) pcr_vector_elem(map, 200, x)) == 12345
+               && *((int64_t *) pcr_vector_elem(cmp, 1, x))
+                  == *((int64_t *) pcr_vector_elem(vec, 1, x));
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+map_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_persist() replaces a file without disturbing an"
+            " existing mapping of it";
+
+    pcr_exception_try (x) {
+        pcr_vector_persist(sample_i64(100, x), SAMPLE_MAP_PATH, x);
+        pcr_vector *map = pcr_vector_map(SAMPLE_MAP_PATH, sizeof (int64_t), x);
+        pcr_vector *slc = pcr_vector_slice(map, 91, 10, x);
+
+        pcr_vector_persist(pcr_vector_new(sizeof (int64_t), x),
+                           SAMPLE_MAP_PATH, x);
+        pcr_vector *cmp = pcr_vector_map(SAMPLE_MAP_PATH, sizeof (int64_t), x);
+        pcr_vector *vec = sample_i64(100, x);
+
+        return !pcr_vector_len(cmp, x) && pcr_vector_len(map, x) == 100
+               && *((int64_t *) pcr_vector_elem(slc, 10, x))
+                  == *((int64_t *) pcr_vector_elem(vec, 100, x));
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+map_test_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_map() throws PCR_EXCEPTION_PARSE if the element size"
+            " doesn't match the file";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        pcr_vector_persist(sample_i64(10, x), SAMPLE_MAP_PATH, x);
+        (void) pcr_vector_map(SAMPLE_MAP_PATH, sizeof (int32_t), x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_PARSE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+map_test_5(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_map() throws PCR_EXCEPTION_FILE if the file doesn't"
+            " exist";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        (void) pcr_vector_map("non-existent.map", sizeof (int64_t), x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_FILE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+map_test_6(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_persist() creates files with the same mode as open()";
+
+    pcr_exception_try (x) {
+        struct stat st, ref;
+        const char *path = SAMPLE_MAP_PATH ".ref";
+
+        /* a file created by open() gets 0666 less the umask in effect */
+        (void) unlink(path);
+        int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0666);
+        pcr_assert_file(fd != -1, x);
+        (void) close(fd);
+
+        pcr_vector_persist(sample_i64(10, x), SAMPLE_MAP_PATH, x);
+        bool ok = !stat(path, &ref) && !stat(SAMPLE_MAP_PATH, &st)
+                  && (st.st_mode & 0777) == (ref.st_mode & 0777);
+
+        (void) unlink(path);
+        return ok;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+map_test_7(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_vector_map_2() maps a read-only vector that faults on writes"
+            " but can still be pushed onto";
+
+    pcr_exception_try (x) {
+        pcr_vector *vec = sample_i64(100, x);
+        pcr_vector_persist(vec, SAMPLE_MAP_PATH, x);
+        pcr_vector *map = pcr_vector_map_2(SAMPLE_MAP_PATH, sizeof (int64_t),
+                                           true, x);
+
+        /* write to the mapping in a child, which should be killed by it */
+        fflush(NULL);
+        pid_t pid = fork();
+        if (!pid) {
+            (void) dup2(open("/dev/null", O_WRONLY), STDERR_FILENO);
+            *(volatile int64_t *) map->payload = 0;
+            _exit(0);
+        }
+
+        int status = 0;
+        bool ok = pid != -1 && waitpid(pid, &status, 0) == pid
+                  && !(WIFEXITED(status) && !WEXITSTATUS(status));
+
+        int64_t elem = 12345;
+        pcr_vector_push(&map, &elem, x);
+
+        return ok && pcr_vector_len(map, x) == 101
+               && *((int64_t *) pcr_vector_elem(map, 1, x))
+                  == *((int64_t *) pcr_vector_elem(vec, 1, x))
+               && *((int64_t *) pcr_vector_elem(map, 101, x)) == 12345;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_vector_testsuite() interface
+ */
+
+
+static pcr_unittest *unit_tests[] = {
+    &sort_test_1,        &sort_test_2,        &sort_test_3,
+    &sort_test_4,        &sort_stable_test_1, &sort_stable_test_2,
+    &sort_stable_test_3, &sort_i64_test_1,    &sort_i64_test_2,
+    &sort_f64_test_1,    &sort_f64_test_2,    &string_sort_test_1,
+    &string_take_test_1, &string_sort_radix_test_1, &string_sort_radix_test_2,
+    &iterate_par_test_1, &iterate_par_test_2, &iterate_par_test_3,
+    &muterate_par_test_1, &muterate_par_test_2, &bound_test_1,
+    &bound_test_2,       &insert_sorted_test_1, &insert_sorted_test_2,
+    &setop_test_1,       &setop_test_2,       &setop_test_3,
+    &define_test_1,      &define_test_2,      &refcount_test_1,
+    &new_2_test_1,       &new_2_test_2,       &new_2_test_3,
+    &slice_test_1,       &slice_test_2,       &slice_test_3,
+    &kernel_test_1,      &kernel_test_2,      &kernel_test_3,
+    &kernel_test_4,      &kernel_test_5,      &kernel_test_6,
+    &map_test_1,         &map_test_2,         &map_test_3,
+    &map_test_4,         &map_test_5,         &map_test_6,
+    &map_test_7
+};
+
+
+extern pcr_testsuite *
+pcr_vector_testsuite(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        const pcr_string *name = "PCR Vector (pcr_vector)";
+        const size_t len = sizeof unit_tests / sizeof *unit_tests;
+
+        return pcr_testsuite_new_2(name, unit_tests, len, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}
@@ -0,0 +1,169 @@
+#include <stdatomic.h>
+#include "./suites.h"
+
+
+static void
+sample_task(size_t id, size_t len, void *opt, pcr_exception ex)
+{
+    atomic_size_t *hits = (atomic_size_t *) opt;
+    atomic_fetch_add(&hits[id], 1);
+}
+
+
+static void
+sample_task_throw(size_t id, size_t len, void *opt, pcr_exception ex)
+{
+    pcr_assert_range(id != len - 1, ex);
+}
+
+
+/******************************************************************************
+ * pcr_worker_count() test cases
+ */
+
+
+static bool
+count_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_worker_count() returns at least one worker";
+
+    pcr_exception_try (x) {
+        return pcr_worker_count() >= 1;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+count_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_worker_count() respects the limit set by pcr_worker_limit()";
+
+    pcr_exception_try (x) {
+        pcr_worker_limit(3);
+        bool res = pcr_worker_count() == 3;
+        pcr_worker_limit(0);
+
+        return res;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_worker_run() test cases
+ */
+
+
+static bool
+run_test_1(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_worker_run() runs the task exactly once for each worker";
+
+    pcr_exception_try (x) {
+        atomic_size_t hits[8] = {0};
+        pcr_worker_run(8, &sample_task, hits, x);
+
+        for (register size_t i = 0; i < 8; i++) {
+            if (atomic_load(&hits[i]) != 1)
+                return false;
+        }
+
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+run_test_2(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_worker_run() rethrows an exception thrown by a worker";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        pcr_worker_run(4, &sample_task_throw, NULL, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+run_test_3(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_worker_run() throws PCR_EXCEPTION_RANGE if passed zero for"
+            " @len";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        pcr_worker_run(0, &sample_task, NULL, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_RANGE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+static bool
+run_test_4(pcr_string **desc, pcr_exception ex)
+{
+    *desc = "pcr_worker_run() throws PCR_EXCEPTION_HANDLE if passed a null"
+            " pointer for @task";
+
+    pcr_exception_try (x) {
+        pcr_log_suppress();
+        pcr_worker_run(2, NULL, NULL, x);
+    }
+
+    pcr_exception_catch (PCR_EXCEPTION_HANDLE) {
+        pcr_log_allow();
+        return true;
+    }
+
+    pcr_exception_unwind(ex);
+    return false;
+}
+
+
+/******************************************************************************
+ * pcr_worker_testsuite() interface
+ */
+
+
+static pcr_unittest *unit_tests[] = {
+    &count_test_1, &count_test_2, &run_test_1, &run_test_2, &run_test_3,
+    &run_test_4
+};
+
+
+extern pcr_testsuite *
+pcr_worker_testsuite(pcr_exception ex)
+{
+    pcr_exception_try (x) {
+        const pcr_string *name = "PCR Worker (pcr_worker)";
+        const size_t len = sizeof unit_tests / sizeof *unit_tests;
+
+        return pcr_testsuite_new_2(name, unit_tests, len, x);
+    }
+
+    pcr_exception_unwind(ex);
+    return NULL;
+}